@@ -4,6 +4,7 @@
 
 #include "asyexporterimpvisitor.h"
 
+#include "../misc/curve_sampler.h"
 #include "../misc/goniometry.h"
 #include "../objects/bezier_imp.h"
 #include "../objects/circle_imp.h"
@@ -19,6 +20,8 @@
 #include "../objects/polygon_imp.h"
 #include "../objects/text_imp.h"
 
+#include <algorithm>
+
 void AsyExporterImpVisitor::newLine()
 {
     mstream << "\n";
@@ -112,41 +115,15 @@ void AsyExporterImpVisitor::visit(ObjectHolder *obj)
 
 void AsyExporterImpVisitor::plotGenericCurve(const CurveImp *imp)
 {
-    std::vector<std::vector<Coordinate>> coordlist;
-    coordlist.push_back(std::vector<Coordinate>());
-    uint curid = 0;
-
-    Coordinate c;
-    Coordinate prev = Coordinate::invalidCoord();
-    for (double i = 0.0; i <= 1.0; i += 0.0001) {
-        c = imp->getPoint(i, mw.document());
-        if (!c.valid()) {
-            if (coordlist[curid].size() > 0) {
-                coordlist.push_back(std::vector<Coordinate>());
-                ++curid;
-                prev = Coordinate::invalidCoord();
-            }
-            continue;
-        }
-        if (!((fabs(c.x) <= 10000) && (fabs(c.y) <= 10000)))
-            continue;
-        // if there's too much distance between this coordinate and the previous
-        // one, then it's another piece of curve not joined with the rest
-        if (prev.valid() && (c.distance(prev) > 50.0)) {
-            coordlist.push_back(std::vector<Coordinate>());
-            ++curid;
-        }
-        coordlist[curid].push_back(c);
-        prev = c;
-    }
-    // special case for ellipse
-    if (const ConicImp *conic = dynamic_cast<const ConicImp *>(imp)) {
-        // if ellipse, close its path
-        // THSI IS WRONG, think of ellipse arcs!!
-        if (conic->conicType() == 1 && coordlist.size() == 1 && coordlist[0].size() > 1) {
-            coordlist[0].push_back(coordlist[0][0]);
-        }
-    }
+    // a tolerance of a thousandth of the picture is finer than it can
+    // be rendered anyway
+    const double tolerance = std::max(msr.width(), msr.height()) / 1000;
+    // there's no point in writing the samples far outside of the
+    // picture, e.g. along the asymptotes of a hyperbola..
+    Rect clip(msr);
+    clip.scale(3);
+    clip.setCenter(msr.center());
+    std::vector<std::vector<Coordinate>> coordlist = clipPolylines(sampleCurve(imp, mw.document(), msr, tolerance, 10000), clip);
     for (uint i = 0; i < coordlist.size(); ++i) {
         uint s = coordlist[i].size();
         // there's no point in draw curves empty or with only one point
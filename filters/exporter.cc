@@ -8,6 +8,7 @@
 #include "imageexporteroptions.h"
 #include "latexexporter.h"
 #include "svgexporter.h"
+#include "tiledimagewriter.h"
 #include "xfigexporter.h"
 
 #include "../kig/kig_document.h"
@@ -108,18 +109,15 @@ void ImageExporter::run(const KigPart &doc, KigWidget &w)
         KMessageBox::error(&w, i18n("The file \"%1\" could not be opened. Please check if the file permissions are set correctly.", filename));
         return;
     };
+    file.close();
 
-    QPixmap img(imgsize);
-    img.fill(Qt::white);
-    KigPainter p(ScreenInfo(w.screenInfo().shownRect(), img.rect()), &img, doc.document());
-    p.setWholeWinOverlay();
-    p.drawGrid(doc.document().coordinateSystem(), showgrid, showaxes);
-    // FIXME: show the selections ?
-    p.drawObjects(doc.document().objects(), false);
     const QStringList types = mimeType.suffixes();
     if (types.isEmpty())
         return; // TODO error dialog?
-    if (!img.save(filename, types.at(0).toLatin1())) {
+    // the image is rendered in tiles, so that it can be much larger
+    // than what would fit in a QPixmap
+    TiledImageWriter writer(doc.document(), w.screenInfo().shownRect(), imgsize, showgrid, showaxes);
+    if (!writer.write(filename, types.at(0).toLatin1())) {
         KMessageBox::error(&w, i18n("Sorry, something went wrong while saving to image \"%1\"", filename));
     }
 }
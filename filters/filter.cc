@@ -93,7 +93,7 @@ void KigFilter::warning(const QString &explanation) const
     KMessageBox::information(nullptr, explanation);
 }
 
-bool KigFilters::save(const KigDocument &data, const QString &tofile)
+bool KigFilters::save(const KigDocument &data, const QString &tofile, bool impcache)
 {
-    return KigFilterNative::instance()->save(data, tofile);
+    return KigFilterNative::instance()->save(data, tofile, impcache);
 }
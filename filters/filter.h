@@ -23,9 +23,9 @@ public:
 
     /**
      * saving is always done with the native filter.  We don't support
-     * output filters..
+     * output filters..  See KigFilterNative::save for \p impcache.
      */
-    bool save(const KigDocument &data, const QString &outfile);
+    bool save(const KigDocument &data, const QString &outfile, bool impcache = false);
 
 protected:
     KigFilters();
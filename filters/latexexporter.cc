@@ -14,6 +14,7 @@
 #include "../kig/kig_part.h"
 #include "../kig/kig_view.h"
 #include "../misc/common.h"
+#include "../misc/curve_sampler.h"
 #include "../misc/goniometry.h"
 #include "../misc/kigfiledialog.h"
 #include "../misc/rect.h"
@@ -219,40 +220,16 @@ void PSTricksExportImpVisitor::plotGenericCurve(const CurveImp *imp)
 
     QString prefix = QStringLiteral("\\pscurve[linecolor=%1,linewidth=%2,%3]").arg(mcurcolorid).arg(width / 100.0).arg(writeStyle(mcurobj->drawer()->style()));
 
-    std::vector<std::vector<Coordinate>> coordlist;
-    coordlist.push_back(std::vector<Coordinate>());
-    uint curid = 0;
-
-    Coordinate c;
-    Coordinate prev = Coordinate::invalidCoord();
-    for (double i = 0.0; i <= 1.0; i += 0.005) {
-        c = imp->getPoint(i, mw.document());
-        if (!c.valid()) {
-            if (coordlist[curid].size() > 0) {
-                coordlist.push_back(std::vector<Coordinate>());
-                ++curid;
-                prev = Coordinate::invalidCoord();
-            }
-            continue;
-        }
-        if (!((fabs(c.x) <= 1000) && (fabs(c.y) <= 1000)))
-            continue;
-        // if there's too much distance between this coordinate and the previous
-        // one, then it's another piece of curve not joined with the rest
-        if (prev.valid() && (c.distance(prev) > 4.0)) {
-            coordlist.push_back(std::vector<Coordinate>());
-            ++curid;
-        }
-        coordlist[curid].push_back(c);
-        prev = c;
-    }
-    // special case for ellipse
-    if (const ConicImp *conic = dynamic_cast<const ConicImp *>(imp)) {
-        // if ellipse, close its path
-        if (conic->conicType() == 1 && coordlist.size() == 1 && coordlist[0].size() > 1) {
-            coordlist[0].push_back(coordlist[0][0]);
-        }
-    }
+    // a tolerance of a thousandth of the picture is finer than LaTeX
+    // can render it anyway
+    const double tolerance = std::max(msr.width(), msr.height()) / 1000;
+    // the samples can be far outside of the picture, e.g. along the
+    // asymptotes of a hyperbola, and TeX gives up with "Dimension too
+    // large" on such coordinates..
+    Rect clip(msr);
+    clip.scale(3);
+    clip.setCenter(msr.center());
+    std::vector<std::vector<Coordinate>> coordlist = clipPolylines(sampleCurve(imp, mw.document(), msr, tolerance, 10000), clip);
     for (uint i = 0; i < coordlist.size(); ++i) {
         uint s = coordlist[i].size();
         // there's no point in draw curves empty or with only one point
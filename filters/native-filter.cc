@@ -22,15 +22,19 @@
 #include <algorithm>
 #include <iostream>
 #include <map>
+#include <set>
 #include <vector>
 
-#include <QDebug>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDomElement>
 #include <QFile>
 #include <QFont>
-#include <QStandardPaths>
-#include <QTextStream>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
+#include <KCompressionDevice>
 #include <KTar>
 
 struct HierElem {
@@ -78,7 +82,7 @@ KigFilterNative::~KigFilterNative()
 
 bool KigFilterNative::supportMime(const QString &mime)
 {
-    return mime == QLatin1String("application/x-kig");
+    return mime == QLatin1String("application/x-kig") || mime == QLatin1String("application/x-kig-binary");
 }
 
 KigDocument *KigFilterNative::load(const QString &file)
@@ -89,69 +93,79 @@ KigDocument *KigFilterNative::load(const QString &file)
         return nullptr;
     };
 
-    QFile kigdoc(file);
-    bool iscompressed = false;
-    if (!file.endsWith(QLatin1String(".kig"), Qt::CaseInsensitive)) {
-        // the file is compressed, so we have to decompress it and fetch the
-        // kig file inside it...
-        iscompressed = true;
+    if (file.endsWith(QLatin1String(".kig"), Qt::CaseInsensitive))
+        return load(ffile);
+    if (file.endsWith(QLatin1String(".kigb"), Qt::CaseInsensitive))
+        return loadBinary(ffile);
 
-        QString tempdir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-        if (tempdir.isEmpty())
-            KIG_FILTER_PARSE_ERROR;
-
-        tempdir += QLatin1Char('/');
-
-        QString tempname = file.section('/', -1);
-        if (file.endsWith(QLatin1String(".kigz"), Qt::CaseInsensitive)) {
-            tempname.remove(QRegExp("\\.[Kk][Ii][Gg][Zz]$"));
-        } else
-            KIG_FILTER_PARSE_ERROR;
-        // reading compressed file
-        KTar ark(file, QStringLiteral("application/gzip"));
-        ark.open(QIODevice::ReadOnly);
-        const KArchiveDirectory *dir = ark.directory();
-        //    assert( dir );
-        QStringList entries = dir->entries();
-        QStringList kigfiles = entries.filter(QRegExp("\\.kig$"));
-        if (kigfiles.count() != 1)
-            // I throw a generic parse error here, but I should warn the user that
-            // this kig archive file doesn't contain one kig file (it contains no
-            // kig files or more than one).
-            KIG_FILTER_PARSE_ERROR;
-        const KArchiveEntry *kigz = dir->entry(kigfiles.at(0));
-        if (!kigz->isFile())
-            KIG_FILTER_PARSE_ERROR;
-        dynamic_cast<const KArchiveFile *>(kigz)->copyTo(tempdir);
-        qDebug() << "extracted file: " << tempdir + kigz->name() << "exists: " << QFile::exists(tempdir + kigz->name());
-
-        kigdoc.setFileName(tempdir + kigz->name());
-    }
-
-    if (!kigdoc.open(QIODevice::ReadOnly))
+    // the file is compressed, so we have to fetch the kig file inside
+    // it.  We parse it straight from the archive, without extracting
+    // it first.  KTar would decompress a file it opens by name into a
+    // temp file, so we hand it a decompressing device instead..
+    if (!file.endsWith(QLatin1String(".kigz"), Qt::CaseInsensitive))
         KIG_FILTER_PARSE_ERROR;
-
-    QDomDocument doc(QStringLiteral("KigDocument"));
-    if (!doc.setContent(&kigdoc))
+    KCompressionDevice gz(&ffile, false, KCompressionDevice::GZip);
+    if (!gz.open(QIODevice::ReadOnly))
+        KIG_FILTER_PARSE_ERROR;
+    KTar ark(&gz);
+    if (!ark.open(QIODevice::ReadOnly))
+        KIG_FILTER_PARSE_ERROR;
+    const KArchiveDirectory *dir = ark.directory();
+    //    assert( dir );
+    QStringList entries = dir->entries();
+    QStringList kigfiles = entries.filter(QRegExp("\\.kig$"));
+    if (kigfiles.count() != 1)
+        // I throw a generic parse error here, but I should warn the user that
+        // this kig archive file doesn't contain one kig file (it contains no
+        // kig files or more than one).
+        KIG_FILTER_PARSE_ERROR;
+    const KArchiveEntry *kigz = dir->entry(kigfiles.at(0));
+    if (!kigz->isFile())
+        KIG_FILTER_PARSE_ERROR;
+    QIODevice *kigdoc = static_cast<const KArchiveFile *>(kigz)->createDevice();
+    if (!kigdoc)
         KIG_FILTER_PARSE_ERROR;
-    kigdoc.close();
 
-    // removing temp file
-    if (iscompressed)
-        kigdoc.remove();
+    KigDocument *ret = load(*kigdoc);
+    delete kigdoc;
+    return ret;
+}
 
-    return load(doc);
+// reads the element at the current position of \p xml, including all
+// of its children, into a new element of \p doc.  This allows us to
+// use the QDom based parts of Kig ( like ObjectImpFactory ) on small
+// parts of a document that is read with a QXmlStreamReader.  Like
+// QDomDocument::setContent, we drop whitespace-only text..
+static QDomElement readElement(QXmlStreamReader &xml, QDomDocument &doc)
+{
+    QDomElement e = doc.createElement(xml.name().toString());
+    const QXmlStreamAttributes attrs = xml.attributes();
+    for (QXmlStreamAttributes::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+        e.setAttribute(i->name().toString(), i->value().toString());
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.isStartElement())
+            e.appendChild(readElement(xml, doc));
+        else if (xml.isEndElement())
+            break;
+        else if (xml.isCharacters() && !xml.isWhitespace())
+            e.appendChild(doc.createTextNode(xml.text().toString()));
+    }
+    return e;
 }
 
-KigDocument *KigFilterNative::load(const QDomDocument &doc)
+KigDocument *KigFilterNative::load(QIODevice &dev)
 {
-    QDomElement main = doc.documentElement();
+    QXmlStreamReader xml(&dev);
+    if (!xml.readNextStartElement())
+        KIG_FILTER_PARSE_ERROR;
 
-    QString version = main.attribute(QStringLiteral("CompatibilityVersion"));
+    const QXmlStreamAttributes attrs = xml.attributes();
+    QString version = attrs.value(QStringLiteral("CompatibilityVersion")).toString();
     if (version.isEmpty())
-        version = main.attribute(QStringLiteral("Version"));
+        version = attrs.value(QStringLiteral("Version")).toString();
     if (version.isEmpty())
-        version = main.attribute(QStringLiteral("version"));
+        version = attrs.value(QStringLiteral("version")).toString();
     if (version.isEmpty())
         KIG_FILTER_PARSE_ERROR;
 
@@ -186,10 +200,16 @@ KigDocument *KigFilterNative::load(const QDomDocument &doc)
                  "new format.",
                  version));
         return nullptr;
-    } else if (major == 0 && minor <= 6)
-        return load04(main);
-    else
-        return load07(main);
+    } else if (major == 0 && minor <= 6) {
+        // the old format allows objects in any order, so we need the
+        // whole document in memory anyway..
+        QDomDocument doc(QStringLiteral("KigDocument"));
+        doc.appendChild(readElement(xml, doc));
+        if (xml.hasError())
+            KIG_FILTER_PARSE_ERROR;
+        return load04(doc.documentElement());
+    } else
+        return load07(xml);
 }
 
 KigDocument *KigFilterNative::load04(const QDomElement &docelem)
@@ -352,30 +372,163 @@ KigFilterNative *KigFilterNative::instance()
     return &f;
 }
 
+/*
+ * When saving from the GUI, a document can include the imps that Kig
+ * calculated for it ( see KigFilterNative::save ), so that they don't
+ * need to be calculated again when the document is opened.  Such a
+ * cached imp is keyed by a hash of everything that determines it: the
+ * Kig version, the coordinate system, the type or property of the
+ * object, and the keys of its parents, or, for data objects, their
+ * data.  Keys can thus be computed while loading, without calculating
+ * anything.  The adopted imps are verified later on, because KigPart
+ * recalculates everything in the background after loading.
+ *
+ * Loci are stored with the points they have sampled, which is where
+ * their cost is, and keep them through that recalculation, see
+ * LocusImp::cachedPoints().
+ */
+static const int impCacheStreamVersion = QDataStream::Qt_5_15;
+
+typedef std::map<const ObjectCalcer *, QByteArray> ImpCacheKeys;
+
+static QByteArray impCacheSalt(const KigDocument &doc)
+{
+    QByteArray ret(KIG_VERSION_STRING);
+    ret += '\0';
+    ret += doc.coordinateSystem().type();
+    return ret;
+}
+
+static QByteArray xmlSerializedImp(const ObjectImp &imp)
+{
+    QDomDocument doc;
+    QDomElement e = doc.createElement(QStringLiteral("Data"));
+    e.setAttribute(QStringLiteral("type"), ObjectImpFactory::instance()->serialize(imp, e, doc));
+    doc.appendChild(e);
+    return doc.toByteArray(-1);
+}
+
+static QByteArray serializedImp(const ObjectImp &imp)
+{
+    if (!ObjectImpFactory::instance()->canSerialize(imp))
+        return xmlSerializedImp(imp);
+    QByteArray ret;
+    QDataStream out(&ret, QIODevice::WriteOnly);
+    out.setVersion(impCacheStreamVersion);
+    ObjectImpFactory::instance()->serialize(imp, out);
+    return ret;
+}
+
+// computes the key of \p o, and adds it to \p keys.  The keys of the
+// parents of \p o must already be in there.
+static QByteArray impCacheKey(const ObjectCalcer *o, ImpCacheKeys &keys, const QByteArray &salt)
+{
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    h.addData(salt);
+    if (const ObjectConstCalcer *c = dynamic_cast<const ObjectConstCalcer *>(o)) {
+        h.addData("D", 1);
+        // the .kig format stores data objects with less precision than
+        // they have in memory, so we hash the form that survives a save
+        // and a load, or the keys would never match after loading..
+        h.addData(xmlSerializedImp(*c->imp()));
+    } else if (const ObjectPropertyCalcer *p = dynamic_cast<const ObjectPropertyCalcer *>(o)) {
+        h.addData("P", 1);
+        h.addData(QByteArray(p->parent()->imp()->getPropName(p->propGid())));
+    } else if (const ObjectTypeCalcer *t = dynamic_cast<const ObjectTypeCalcer *>(o)) {
+        h.addData("O", 1);
+        h.addData(QByteArray(t->type()->fullName()));
+    }
+    const std::vector<ObjectCalcer *> parents = o->parents();
+    for (std::vector<ObjectCalcer *>::const_iterator i = parents.begin(); i != parents.end(); ++i) {
+        ImpCacheKeys::const_iterator k = keys.find(*i);
+        assert(k != keys.end());
+        h.addData(k->second);
+    }
+    return keys[o] = h.result();
+}
+
+// whether we would store the imp of \p o in the imp cache
+static bool impCacheable(const ObjectCalcer *o)
+{
+    return !dynamic_cast<const ObjectConstCalcer *>(o) && ObjectImpFactory::instance()->canSerialize(*o->imp());
+}
+
+// sets the imp of \p o to the one in \p data, which was written by
+// ObjectImpFactory::serialize.
+static bool adoptImp(ObjectCalcer *o, const QByteArray &data)
+{
+    QDataStream in(data);
+    in.setVersion(impCacheStreamVersion);
+    ObjectImp *imp = ObjectImpFactory::instance()->deserialize(in);
+    if (!imp)
+        return false;
+    if (ObjectTypeCalcer *t = dynamic_cast<ObjectTypeCalcer *>(o))
+        t->setImp(imp);
+    else if (ObjectPropertyCalcer *p = dynamic_cast<ObjectPropertyCalcer *>(o))
+        p->setImp(imp);
+    else {
+        delete imp;
+        return false;
+    }
+    return true;
+}
+
+// calculates \p o and those of its ancestors that are not in \p calced
+// yet.  The loaders don't calculate the objects they create, that is
+// left to the caller ( see KigPart::openFile() ), except for the
+// parents of properties, whose imp we need to look up the property.
+static void calcWithAncestors(ObjectCalcer *o, const KigDocument &doc, std::set<const ObjectCalcer *> &calced)
+{
+    // an explicit stack, hierarchies can be very deep..
+    std::vector<std::pair<ObjectCalcer *, bool>> stack;
+    stack.push_back(std::make_pair(o, false));
+    while (!stack.empty()) {
+        ObjectCalcer *c = stack.back().first;
+        bool parentsdone = stack.back().second;
+        stack.pop_back();
+        if (calced.find(c) != calced.end())
+            continue;
+        if (parentsdone) {
+            c->calc(doc);
+            calced.insert(c);
+        } else {
+            stack.push_back(std::make_pair(c, true));
+            const std::vector<ObjectCalcer *> parents = c->parents();
+            for (std::vector<ObjectCalcer *>::const_iterator i = parents.begin(); i != parents.end(); ++i)
+                if (calced.find(*i) == calced.end())
+                    stack.push_back(std::make_pair(*i, false));
+        }
+    }
+}
+
 static const char *obsoletemessage = I18N_NOOP(
     "This Kig file uses an object of type \"%1\", "
     "which is obsolete, you should save the construction with "
     "a different name and check that it works as expected.");
 
-KigDocument *KigFilterNative::load07(const QDomElement &docelem)
+KigDocument *KigFilterNative::load07(QXmlStreamReader &xml)
 {
     KigDocument *ret = new KigDocument();
 
     bool ok = true;
     std::vector<ObjectCalcer::shared_ptr> calcers;
+    std::set<const ObjectCalcer *> calced;
     std::vector<ObjectHolder *> holders;
+    // the imp cache, see impCacheKey()
+    std::map<uint, std::pair<QByteArray, QByteArray>> impcache;
+    ImpCacheKeys impcachekeys;
+    QByteArray impcachesalt;
 
-    QString t = docelem.attribute(QStringLiteral("grid"));
+    QString t = xml.attributes().value(QStringLiteral("grid")).toString();
     bool tmphide = (t == QLatin1String("false")) || (t == QLatin1String("no")) || (t == QLatin1String("0"));
     ret->setGrid(!tmphide);
-    t = docelem.attribute(QStringLiteral("axes"));
+    t = xml.attributes().value(QStringLiteral("axes")).toString();
     tmphide = (t == QLatin1String("false")) || (t == QLatin1String("no")) || (t == QLatin1String("0"));
     ret->setAxes(!tmphide);
 
-    for (QDomElement subsectionelement = docelem.firstChild().toElement(); !subsectionelement.isNull();
-         subsectionelement = subsectionelement.nextSibling().toElement()) {
-        if (subsectionelement.tagName() == QLatin1String("CoordinateSystem")) {
-            QString tmptype = subsectionelement.text();
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("CoordinateSystem")) {
+            QString tmptype = xml.readElementText();
             // compatibility code - to support Invisible coord system...
             if (tmptype == QLatin1String("Invisible")) {
                 tmptype = QStringLiteral("Euclidean");
@@ -392,55 +545,80 @@ KigDocument *KigFilterNative::load07(const QDomElement &docelem)
                          "instead."));
             } else
                 ret->setCoordinateSystem(s);
-        } else if (subsectionelement.tagName() == QLatin1String("Hierarchy")) {
-            for (QDomElement e = subsectionelement.firstChild().toElement(); !e.isNull(); e = e.nextSibling().toElement()) {
-                QString tmp = e.attribute(QStringLiteral("id"));
+        } else if (xml.name() == QLatin1String("ImpCache")) {
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("Imp")) {
+                    const QXmlStreamAttributes attrs = xml.attributes();
+                    uint id = attrs.value(QStringLiteral("object")).toUInt();
+                    QByteArray key = QByteArray::fromHex(attrs.value(QStringLiteral("key")).toLatin1());
+                    impcache[id] = std::make_pair(key, QByteArray::fromBase64(xml.readElementText().toLatin1()));
+                } else
+                    xml.skipCurrentElement();
+            }
+        } else if (xml.name() == QLatin1String("Hierarchy")) {
+            impcachesalt = impCacheSalt(*ret);
+            while (xml.readNextStartElement()) {
+                const QXmlStreamAttributes attrs = xml.attributes();
+                const QString tag = xml.name().toString();
+                QString tmp = attrs.value(QStringLiteral("id")).toString();
                 uint id = tmp.toInt(&ok);
                 if (id <= 0)
                     KIG_FILTER_PARSE_ERROR;
 
+                // the data of an ObjectImp is deserialized from a QDomElement,
+                // so we read Data elements into a ( small ) DOM of their own.
+                // For the other elements, we only need the Parent children.
+                QDomDocument datadoc;
+                QDomElement dataelem;
                 std::vector<ObjectCalcer *> parents;
-                for (QDomElement parentel = e.firstChild().toElement(); !parentel.isNull(); parentel = parentel.nextSibling().toElement()) {
-                    if (parentel.tagName() != QLatin1String("Parent"))
-                        continue;
-                    QString tmp = parentel.attribute(QStringLiteral("id"));
-                    uint parentid = tmp.toInt(&ok);
-                    if (!ok)
-                        KIG_FILTER_PARSE_ERROR;
-                    if (parentid == 0 || parentid > calcers.size())
-                        KIG_FILTER_PARSE_ERROR;
-                    ObjectCalcer *parent = calcers[parentid - 1].get();
-                    if (!parent)
-                        KIG_FILTER_PARSE_ERROR;
-                    parents.push_back(parent);
+                if (tag == QLatin1String("Data")) {
+                    dataelem = readElement(xml, datadoc);
+                    for (QDomElement parentel = dataelem.firstChild().toElement(); !parentel.isNull(); parentel = parentel.nextSibling().toElement())
+                        if (parentel.tagName() == QLatin1String("Parent"))
+                            KIG_FILTER_PARSE_ERROR;
+                } else {
+                    while (xml.readNextStartElement()) {
+                        if (xml.name() == QLatin1String("Parent")) {
+                            QString tmp = xml.attributes().value(QStringLiteral("id")).toString();
+                            uint parentid = tmp.toInt(&ok);
+                            if (!ok)
+                                KIG_FILTER_PARSE_ERROR;
+                            if (parentid == 0 || parentid > calcers.size())
+                                KIG_FILTER_PARSE_ERROR;
+                            ObjectCalcer *parent = calcers[parentid - 1].get();
+                            if (!parent)
+                                KIG_FILTER_PARSE_ERROR;
+                            parents.push_back(parent);
+                        }
+                        xml.skipCurrentElement();
+                    }
                 }
 
                 ObjectCalcer *o = nullptr;
 
-                if (e.tagName() == QLatin1String("Data")) {
-                    if (!parents.empty())
-                        KIG_FILTER_PARSE_ERROR;
-                    QString tmp = e.attribute(QStringLiteral("type"));
+                if (tag == QLatin1String("Data")) {
+                    QString tmp = attrs.value(QStringLiteral("type")).toString();
                     QString error;
-                    ObjectImp *imp = ObjectImpFactory::instance()->deserialize(tmp, e, error);
+                    ObjectImp *imp = ObjectImpFactory::instance()->deserialize(tmp, dataelem, error);
                     if ((!imp) && !error.isEmpty()) {
                         parseError(error);
                         return nullptr;
                     }
                     o = new ObjectConstCalcer(imp);
-                } else if (e.tagName() == QLatin1String("Property")) {
+                } else if (tag == QLatin1String("Property")) {
                     if (parents.size() != 1)
                         KIG_FILTER_PARSE_ERROR;
-                    QByteArray propname = e.attribute(QStringLiteral("which")).toLatin1();
+                    QByteArray propname = attrs.value(QStringLiteral("which")).toLatin1();
 
                     ObjectCalcer *parent = parents[0];
+                    calcWithAncestors(parent, *ret, calced);
                     int propid = parent->imp()->propertiesInternalNames().indexOf(propname);
                     if (propid == -1)
                         KIG_FILTER_PARSE_ERROR;
 
                     o = new ObjectPropertyCalcer(parent, propname);
-                } else if (e.tagName() == QLatin1String("Object")) {
-                    QString tmp = e.attribute(QStringLiteral("type"));
+                } else if (tag == QLatin1String("Object")) {
+                    QString tmp = attrs.value(QStringLiteral("type")).toString();
                     const ObjectType *type = ObjectTypeFactory::instance()->find(tmp.toLatin1());
                     if (!type) {
                         if (tmp == QLatin1String("MeasureTransport") && parents.size() == 3) {
@@ -507,16 +685,24 @@ KigDocument *KigFilterNative::load07(const QDomElement &docelem)
                 } else
                     KIG_FILTER_PARSE_ERROR;
 
-                o->calc(*ret);
                 calcers.resize(id, nullptr);
                 calcers[id - 1] = o;
+
+                if (!impcache.empty()) {
+                    std::map<uint, std::pair<QByteArray, QByteArray>>::iterator c = impcache.find(id);
+                    const QByteArray key = impCacheKey(o, impcachekeys, impcachesalt);
+                    if (c != impcache.end() && c->second.first == key && adoptImp(o, c->second.second))
+                        calced.insert(o);
+                }
             }
-        } else if (subsectionelement.tagName() == QLatin1String("View")) {
-            for (QDomElement e = subsectionelement.firstChild().toElement(); !e.isNull(); e = e.nextSibling().toElement()) {
-                if (e.tagName() != QLatin1String("Draw"))
+        } else if (xml.name() == QLatin1String("View")) {
+            while (xml.readNextStartElement()) {
+                if (xml.name() != QLatin1String("Draw"))
                     KIG_FILTER_PARSE_ERROR;
+                const QXmlStreamAttributes attrs = xml.attributes();
+                xml.skipCurrentElement();
 
-                QString tmp = e.attribute(QStringLiteral("object"));
+                QString tmp = attrs.value(QStringLiteral("object")).toString();
                 uint id = tmp.toInt(&ok);
                 if (!ok)
                     KIG_FILTER_PARSE_ERROR;
@@ -524,32 +710,32 @@ KigDocument *KigFilterNative::load07(const QDomElement &docelem)
                     KIG_FILTER_PARSE_ERROR;
                 ObjectCalcer *calcer = calcers[id - 1].get();
 
-                tmp = e.attribute(QStringLiteral("color"));
+                tmp = attrs.value(QStringLiteral("color")).toString();
                 QColor color(tmp);
                 if (!color.isValid())
                     KIG_FILTER_PARSE_ERROR;
 
-                tmp = e.attribute(QStringLiteral("shown"));
+                tmp = attrs.value(QStringLiteral("shown")).toString();
                 bool shown = !(tmp == QLatin1String("false") || tmp == QLatin1String("no"));
 
-                tmp = e.attribute(QStringLiteral("width"));
+                tmp = attrs.value(QStringLiteral("width")).toString();
                 int width = tmp.toInt(&ok);
                 if (!ok)
                     width = -1;
 
-                tmp = e.attribute(QStringLiteral("style"));
+                tmp = attrs.value(QStringLiteral("style")).toString();
                 Qt::PenStyle style = ObjectDrawer::styleFromString(tmp);
 
-                tmp = e.attribute(QStringLiteral("point-style"));
+                tmp = attrs.value(QStringLiteral("point-style")).toString();
                 Kig::PointStyle pointstyle = Kig::pointStyleFromString(tmp);
 
-                tmp = e.attribute(QStringLiteral("font"));
+                tmp = attrs.value(QStringLiteral("font")).toString();
                 QFont f;
                 if (!tmp.isEmpty())
                     f.fromString(tmp);
 
                 ObjectConstCalcer *namecalcer = nullptr;
-                tmp = e.attribute(QStringLiteral("namecalcer"));
+                tmp = attrs.value(QStringLiteral("namecalcer")).toString();
                 if (tmp != QLatin1String("none") && !tmp.isEmpty()) {
                     int ncid = tmp.toInt(&ok);
                     if (!ok)
@@ -564,167 +750,602 @@ KigDocument *KigFilterNative::load07(const QDomElement &docelem)
                 ObjectDrawer *drawer = new ObjectDrawer(color, width, shown, style, pointstyle, f);
                 holders.push_back(new ObjectHolder(calcer, drawer, namecalcer));
             }
-        }
+        } else
+            xml.skipCurrentElement(); // be forward-compatible..
     }
+    if (xml.hasError())
+        KIG_FILTER_PARSE_ERROR;
 
     ret->addObjects(holders);
     return ret;
 }
 
-bool KigFilterNative::save07(const KigDocument &kdoc, QTextStream &stream)
+// writes \p e and all of its children to \p xml, see readElement()
+static void writeElement(QXmlStreamWriter &xml, const QDomElement &e)
+{
+    xml.writeStartElement(e.tagName());
+    const QDomNamedNodeMap attrs = e.attributes();
+    for (int i = 0; i < attrs.count(); ++i) {
+        const QDomAttr a = attrs.item(i).toAttr();
+        xml.writeAttribute(a.name(), a.value());
+    }
+    for (QDomNode n = e.firstChild(); !n.isNull(); n = n.nextSibling()) {
+        if (n.isElement())
+            writeElement(xml, n.toElement());
+        else if (n.isText())
+            xml.writeCharacters(n.toText().data());
+    }
+    xml.writeEndElement();
+}
+
+bool KigFilterNative::save07(const KigDocument &kdoc, QIODevice &dev, bool impcache)
 {
-    QDomDocument doc(QStringLiteral("KigDocument"));
+    QXmlStreamWriter xml(&dev);
+    xml.setAutoFormatting(true);
+    xml.setAutoFormattingIndent(1);
 
-    QDomProcessingInstruction xmlpi = doc.createProcessingInstruction(QStringLiteral("xml"), QStringLiteral("version=\"1.0\" encoding=\"utf-8\""));
-    doc.appendChild(xmlpi);
+    xml.writeStartDocument();
+    xml.writeDTD(QStringLiteral("<!DOCTYPE KigDocument>"));
 
-    QDomElement docelem = doc.createElement(QStringLiteral("KigDocument"));
-    docelem.setAttribute(QStringLiteral("Version"), KIG_VERSION_STRING);
-    docelem.setAttribute(QStringLiteral("CompatibilityVersion"), QStringLiteral("0.7.0"));
-    docelem.setAttribute(QStringLiteral("grid"), kdoc.grid());
-    docelem.setAttribute(QStringLiteral("axes"), kdoc.axes());
+    xml.writeStartElement(QStringLiteral("KigDocument"));
+    xml.writeAttribute(QStringLiteral("Version"), QStringLiteral(KIG_VERSION_STRING));
+    xml.writeAttribute(QStringLiteral("CompatibilityVersion"), QStringLiteral("0.7.0"));
+    xml.writeAttribute(QStringLiteral("grid"), QString::number(kdoc.grid()));
+    xml.writeAttribute(QStringLiteral("axes"), QString::number(kdoc.axes()));
 
-    QDomElement cselem = doc.createElement(QStringLiteral("CoordinateSystem"));
-    cselem.appendChild(doc.createTextNode(kdoc.coordinateSystem().type()));
-    docelem.appendChild(cselem);
+    xml.writeTextElement(QStringLiteral("CoordinateSystem"), kdoc.coordinateSystem().type());
 
     std::vector<ObjectHolder *> holders = kdoc.objects();
     std::vector<ObjectCalcer *> calcers = getAllParents(getAllCalcers(holders));
     calcers = calcPath(calcers);
 
-    QDomElement hierelem = doc.createElement(QStringLiteral("Hierarchy"));
     std::map<const ObjectCalcer *, int> idmap;
     for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i)
         idmap[*i] = (i - calcers.begin()) + 1;
+
+    // the imp cache goes before the hierarchy, so that the loader can
+    // use it while building the objects
+    if (impcache) {
+        const QByteArray salt = impCacheSalt(kdoc);
+        ImpCacheKeys keys;
+        xml.writeStartElement(QStringLiteral("ImpCache"));
+        for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i) {
+            const QByteArray key = impCacheKey(*i, keys, salt);
+            if (!impCacheable(*i))
+                continue;
+            xml.writeStartElement(QStringLiteral("Imp"));
+            xml.writeAttribute(QStringLiteral("object"), QString::number(idmap[*i]));
+            xml.writeAttribute(QStringLiteral("key"), QString::fromLatin1(key.toHex()));
+            xml.writeCharacters(QString::fromLatin1(serializedImp(*(*i)->imp()).toBase64()));
+            xml.writeEndElement();
+        }
+        xml.writeEndElement();
+    }
+
+    xml.writeStartElement(QStringLiteral("Hierarchy"));
     int id = 1;
 
     for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i) {
-        QDomElement objectelem;
         if (dynamic_cast<ObjectConstCalcer *>(*i)) {
-            objectelem = doc.createElement(QStringLiteral("Data"));
+            // ObjectImpFactory serializes to QDom, so we build a DOM for
+            // just this element..
+            QDomDocument doc;
+            QDomElement objectelem = doc.createElement(QStringLiteral("Data"));
             QString ser = ObjectImpFactory::instance()->serialize(*(*i)->imp(), objectelem, doc);
             objectelem.setAttribute(QStringLiteral("type"), ser);
+            objectelem.setAttribute(QStringLiteral("id"), id++);
+            writeElement(xml, objectelem);
+            // constant calcers have no parents..
+            continue;
         } else if (dynamic_cast<const ObjectPropertyCalcer *>(*i)) {
             const ObjectPropertyCalcer *o = static_cast<const ObjectPropertyCalcer *>(*i);
-            objectelem = doc.createElement(QStringLiteral("Property"));
+            xml.writeStartElement(QStringLiteral("Property"));
 
             QByteArray propname = o->parent()->imp()->getPropName(o->propGid());
-            objectelem.setAttribute(QStringLiteral("which"), QString(propname));
+            xml.writeAttribute(QStringLiteral("which"), QString(propname));
         } else if (dynamic_cast<const ObjectTypeCalcer *>(*i)) {
             const ObjectTypeCalcer *o = static_cast<const ObjectTypeCalcer *>(*i);
-            objectelem = doc.createElement(QStringLiteral("Object"));
-            objectelem.setAttribute(QStringLiteral("type"), o->type()->fullName());
+            xml.writeStartElement(QStringLiteral("Object"));
+            xml.writeAttribute(QStringLiteral("type"), o->type()->fullName());
         } else
             assert(false);
+        xml.writeAttribute(QStringLiteral("id"), QString::number(id++));
 
         const std::vector<ObjectCalcer *> parents = (*i)->parents();
         for (std::vector<ObjectCalcer *>::const_iterator i = parents.begin(); i != parents.end(); ++i) {
             std::map<const ObjectCalcer *, int>::const_iterator idp = idmap.find(*i);
             assert(idp != idmap.end());
             int pid = idp->second;
-            QDomElement pel = doc.createElement(QStringLiteral("Parent"));
-            pel.setAttribute(QStringLiteral("id"), pid);
-            objectelem.appendChild(pel);
+            xml.writeEmptyElement(QStringLiteral("Parent"));
+            xml.writeAttribute(QStringLiteral("id"), QString::number(pid));
         }
 
-        objectelem.setAttribute(QStringLiteral("id"), id++);
-        hierelem.appendChild(objectelem);
+        xml.writeEndElement();
     }
-    docelem.appendChild(hierelem);
+    xml.writeEndElement(); // Hierarchy
 
-    QDomElement windowelem = doc.createElement(QStringLiteral("View"));
+    xml.writeStartElement(QStringLiteral("View"));
     for (std::vector<ObjectHolder *>::iterator i = holders.begin(); i != holders.end(); ++i) {
         std::map<const ObjectCalcer *, int>::const_iterator idp = idmap.find((*i)->calcer());
         assert(idp != idmap.end());
         int id = idp->second;
 
         const ObjectDrawer *d = (*i)->drawer();
-        QDomElement drawelem = doc.createElement(QStringLiteral("Draw"));
-        drawelem.setAttribute(QStringLiteral("object"), id);
-        drawelem.setAttribute(QStringLiteral("color"), d->color().name());
-        drawelem.setAttribute(QStringLiteral("shown"), QLatin1String(d->shown() ? "true" : "false"));
-        drawelem.setAttribute(QStringLiteral("width"), QString::number(d->width()));
-        drawelem.setAttribute(QStringLiteral("style"), d->styleToString());
-        drawelem.setAttribute(QStringLiteral("point-style"), Kig::pointStyleToString(d->pointStyle()));
-        drawelem.setAttribute(QStringLiteral("font"), d->font().toString());
+        xml.writeEmptyElement(QStringLiteral("Draw"));
+        xml.writeAttribute(QStringLiteral("object"), QString::number(id));
+        xml.writeAttribute(QStringLiteral("color"), d->color().name());
+        xml.writeAttribute(QStringLiteral("shown"), QLatin1String(d->shown() ? "true" : "false"));
+        xml.writeAttribute(QStringLiteral("width"), QString::number(d->width()));
+        xml.writeAttribute(QStringLiteral("style"), d->styleToString());
+        xml.writeAttribute(QStringLiteral("point-style"), Kig::pointStyleToString(d->pointStyle()));
+        xml.writeAttribute(QStringLiteral("font"), d->font().toString());
 
         ObjectCalcer *namecalcer = (*i)->nameCalcer();
         if (namecalcer) {
             std::map<const ObjectCalcer *, int>::const_iterator ncp = idmap.find(namecalcer);
             assert(ncp != idmap.end());
             int ncid = ncp->second;
-            drawelem.setAttribute(QStringLiteral("namecalcer"), ncid);
+            xml.writeAttribute(QStringLiteral("namecalcer"), QString::number(ncid));
         } else {
-            drawelem.setAttribute(QStringLiteral("namecalcer"), QStringLiteral("none"));
+            xml.writeAttribute(QStringLiteral("namecalcer"), QStringLiteral("none"));
         }
-
-        windowelem.appendChild(drawelem);
     };
-    docelem.appendChild(windowelem);
+    xml.writeEndElement(); // View
 
-    doc.appendChild(docelem);
-    stream << doc.toString();
-    return true;
+    xml.writeEndElement(); // KigDocument
+    xml.writeEndDocument();
+    return !xml.hasError();
+}
+
+/*
+ * The binary ".kigb" format.  It stores the same information as the
+ * 0.7 XML format, but in a form that can be read back with hardly any
+ * parsing.  All of it is written with a QDataStream:
+ *
+ * - header: magic, format version, the Kig version that wrote the
+ *   file ( informational ), grid, axes and the coordinate system type;
+ * - a string table with all object type and property names;
+ * - the calcers, in calc order: a kind byte, a string table index for
+ *   the type or property name, the parents as indices of earlier
+ *   calcers, and for Data calcers the imp, in the binary form of
+ *   ObjectImpFactory, or as XML for imps that don't have one;
+ * - the holders: calcer index, drawer attributes and name calcer.
+ *
+ * The file is memory mapped for loading.
+ */
+static const quint32 binaryMagic = 0x4b494742; // "KIGB"
+// bump this when the format changes..
+static const quint32 binaryFormat = 1;
+static const int binaryStreamVersion = QDataStream::Qt_5_15;
+
+enum BinaryCalcerKind { BinaryDataCalcer = 0, XmlDataCalcer, PropertyCalcer, TypeCalcer };
+
+static const quint32 noIndex = ~0u;
+
+KigDocument *KigFilterNative::loadBinary(QFile &file)
+{
+    const qint64 size = file.size();
+    uchar *mapped = file.map(0, size);
+    // fall back to reading the file if it cannot be mapped..
+    QByteArray bytes = mapped ? QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), size) : file.readAll();
+    QDataStream in(bytes);
+    in.setVersion(binaryStreamVersion);
+
+    quint32 magic, format;
+    QString version;
+    in >> magic >> format >> version;
+    if (in.status() != QDataStream::Ok || magic != binaryMagic)
+        KIG_FILTER_PARSE_ERROR;
+    if (format > binaryFormat) {
+        notSupported(
+            i18n("This file was created by Kig version \"%1\", "
+                 "which this version cannot open.",
+                 version));
+        return nullptr;
+    }
+
+    KigDocument *ret = new KigDocument();
+
+    quint8 grid, axes;
+    QByteArray cstype;
+    in >> grid >> axes >> cstype;
+    ret->setGrid(grid);
+    ret->setAxes(axes);
+    CoordinateSystem *s = CoordinateSystemFactory::build(cstype.constData());
+    if (!s) {
+        warning(
+            i18n("This Kig file has a coordinate system "
+                 "that this Kig version does not support.\n"
+                 "A standard coordinate system will be used "
+                 "instead."));
+    } else
+        ret->setCoordinateSystem(s);
+
+    quint32 nstrings;
+    in >> nstrings;
+    std::vector<QByteArray> strings;
+    for (quint32 i = 0; i < nstrings && in.status() == QDataStream::Ok; ++i) {
+        QByteArray s;
+        in >> s;
+        strings.push_back(s);
+    }
+
+    quint32 ncalcers;
+    in >> ncalcers;
+    std::vector<ObjectCalcer::shared_ptr> calcers;
+    std::set<const ObjectCalcer *> calced;
+    for (quint32 i = 0; i < ncalcers; ++i) {
+        quint8 kind;
+        quint32 name, nparents;
+        in >> kind >> name >> nparents;
+        if (in.status() != QDataStream::Ok)
+            KIG_FILTER_PARSE_ERROR;
+        if (name != noIndex && name >= strings.size())
+            KIG_FILTER_PARSE_ERROR;
+        std::vector<ObjectCalcer *> parents;
+        for (quint32 j = 0; j < nparents; ++j) {
+            quint32 pid;
+            in >> pid;
+            if (in.status() != QDataStream::Ok || pid >= i)
+                KIG_FILTER_PARSE_ERROR;
+            parents.push_back(calcers[pid].get());
+        }
+
+        ObjectCalcer *o = nullptr;
+        if (kind == BinaryDataCalcer || kind == XmlDataCalcer) {
+            if (!parents.empty())
+                KIG_FILTER_PARSE_ERROR;
+            ObjectImp *imp = nullptr;
+            if (kind == BinaryDataCalcer)
+                imp = ObjectImpFactory::instance()->deserialize(in);
+            else {
+                QByteArray xml;
+                in >> xml;
+                QDomDocument doc;
+                if (name == noIndex || !doc.setContent(xml))
+                    KIG_FILTER_PARSE_ERROR;
+                QString error;
+                imp = ObjectImpFactory::instance()->deserialize(QString::fromLatin1(strings[name]), doc.documentElement(), error);
+                if ((!imp) && !error.isEmpty()) {
+                    parseError(error);
+                    return nullptr;
+                }
+            }
+            if (!imp)
+                KIG_FILTER_PARSE_ERROR;
+            o = new ObjectConstCalcer(imp);
+        } else if (kind == PropertyCalcer) {
+            if (parents.size() != 1 || name == noIndex)
+                KIG_FILTER_PARSE_ERROR;
+            const QByteArray &propname = strings[name];
+            calcWithAncestors(parents[0], *ret, calced);
+            if (parents[0]->imp()->propertiesInternalNames().indexOf(propname) == -1)
+                KIG_FILTER_PARSE_ERROR;
+            o = new ObjectPropertyCalcer(parents[0], propname);
+        } else if (kind == TypeCalcer) {
+            if (name == noIndex)
+                KIG_FILTER_PARSE_ERROR;
+            const ObjectType *type = ObjectTypeFactory::instance()->find(strings[name].constData());
+            if (!type) {
+                notSupported(
+                    i18n("This Kig file uses an object of type \"%1\", "
+                         "which this Kig version does not support."
+                         "Perhaps you have compiled Kig without support "
+                         "for this object type,"
+                         "or perhaps you are using an older Kig version.",
+                         QString::fromLatin1(strings[name])));
+                return nullptr;
+            }
+            // don't sort the args, see load07()
+            o = new ObjectTypeCalcer(type, parents, false);
+        } else
+            KIG_FILTER_PARSE_ERROR;
+
+        calcers.push_back(o);
+    }
+
+    quint32 nholders;
+    in >> nholders;
+    std::vector<ObjectHolder *> holders;
+    for (quint32 i = 0; i < nholders; ++i) {
+        quint32 id;
+        QRgb color;
+        quint8 shown;
+        qint32 width, style, pointstyle, ncid;
+        QString font;
+        in >> id >> color >> shown >> width >> style >> pointstyle >> font >> ncid;
+        if (in.status() != QDataStream::Ok || id >= calcers.size())
+            KIG_FILTER_PARSE_ERROR;
+        if (pointstyle < 0 || pointstyle >= Kig::NumberOfPointStyles)
+            KIG_FILTER_PARSE_ERROR;
+
+        ObjectConstCalcer *namecalcer = nullptr;
+        if (ncid >= 0) {
+            if (ncid >= static_cast<int>(calcers.size()) || !dynamic_cast<ObjectConstCalcer *>(calcers[ncid].get()))
+                KIG_FILTER_PARSE_ERROR;
+            namecalcer = static_cast<ObjectConstCalcer *>(calcers[ncid].get());
+        }
+
+        QFont f;
+        if (!font.isEmpty())
+            f.fromString(font);
+
+        ObjectDrawer *drawer = new ObjectDrawer(QColor::fromRgba(color), width, shown, static_cast<Qt::PenStyle>(style), static_cast<Kig::PointStyle>(pointstyle), f);
+        holders.push_back(new ObjectHolder(calcers[id].get(), drawer, namecalcer));
+    }
+
+    // the optional imp cache, see impCacheKey()
+    if (!in.atEnd()) {
+        quint32 nimps;
+        in >> nimps;
+        ImpCacheKeys keys;
+        const QByteArray salt = impCacheSalt(*ret);
+        for (uint i = 0; i < calcers.size(); ++i)
+            impCacheKey(calcers[i].get(), keys, salt);
+        for (quint32 i = 0; i < nimps && in.status() == QDataStream::Ok; ++i) {
+            quint32 id;
+            QByteArray key, data;
+            in >> id >> key >> data;
+            if (in.status() == QDataStream::Ok && id < calcers.size() && keys[calcers[id].get()] == key)
+                adoptImp(calcers[id].get(), data);
+        }
+    }
+
+    ret->addObjects(holders);
+    return ret;
 }
 
-bool KigFilterNative::save(const KigDocument &data, const QString &file)
+bool KigFilterNative::saveBinary(const KigDocument &kdoc, QIODevice &dev, bool impcache)
 {
-    return save07(data, file);
+    QDataStream out(&dev);
+    out.setVersion(binaryStreamVersion);
+
+    out << binaryMagic << binaryFormat << QStringLiteral(KIG_VERSION_STRING);
+    out << static_cast<quint8>(kdoc.grid()) << static_cast<quint8>(kdoc.axes()) << QByteArray(kdoc.coordinateSystem().type());
+
+    std::vector<ObjectHolder *> holders = kdoc.objects();
+    std::vector<ObjectCalcer *> calcers = getAllParents(getAllCalcers(holders));
+    calcers = calcPath(calcers);
+
+    std::map<const ObjectCalcer *, quint32> idmap;
+    for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i)
+        idmap[*i] = i - calcers.begin();
+
+    // first pass: the string table, and the name of every calcer..
+    std::map<QByteArray, quint32> stringmap;
+    std::vector<QByteArray> strings;
+    std::vector<quint32> names;
+    for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i) {
+        QByteArray name;
+        if (dynamic_cast<const ObjectConstCalcer *>(*i)) {
+            if (!ObjectImpFactory::instance()->canSerialize(*(*i)->imp())) {
+                QDomDocument doc;
+                QDomElement e = doc.createElement(QStringLiteral("Data"));
+                name = ObjectImpFactory::instance()->serialize(*(*i)->imp(), e, doc).toLatin1();
+            }
+        } else if (dynamic_cast<const ObjectPropertyCalcer *>(*i)) {
+            const ObjectPropertyCalcer *o = static_cast<const ObjectPropertyCalcer *>(*i);
+            name = o->parent()->imp()->getPropName(o->propGid());
+        } else if (dynamic_cast<const ObjectTypeCalcer *>(*i))
+            name = static_cast<const ObjectTypeCalcer *>(*i)->type()->fullName();
+        else
+            assert(false);
+
+        if (name.isNull())
+            names.push_back(noIndex);
+        else {
+            std::map<QByteArray, quint32>::iterator s = stringmap.find(name);
+            if (s == stringmap.end()) {
+                s = stringmap.insert(std::make_pair(name, static_cast<quint32>(strings.size()))).first;
+                strings.push_back(name);
+            }
+            names.push_back(s->second);
+        }
+    }
+    out << static_cast<quint32>(strings.size());
+    for (std::vector<QByteArray>::const_iterator i = strings.begin(); i != strings.end(); ++i)
+        out << *i;
+
+    out << static_cast<quint32>(calcers.size());
+    for (uint i = 0; i < calcers.size(); ++i) {
+        const ObjectCalcer *c = calcers[i];
+        quint8 kind;
+        if (dynamic_cast<const ObjectConstCalcer *>(c))
+            kind = names[i] == noIndex ? BinaryDataCalcer : XmlDataCalcer;
+        else if (dynamic_cast<const ObjectPropertyCalcer *>(c))
+            kind = PropertyCalcer;
+        else
+            kind = TypeCalcer;
+
+        const std::vector<ObjectCalcer *> parents = c->parents();
+        out << kind << names[i] << static_cast<quint32>(parents.size());
+        for (std::vector<ObjectCalcer *>::const_iterator j = parents.begin(); j != parents.end(); ++j) {
+            std::map<const ObjectCalcer *, quint32>::const_iterator idp = idmap.find(*j);
+            assert(idp != idmap.end());
+            out << idp->second;
+        }
+
+        if (kind == BinaryDataCalcer)
+            ObjectImpFactory::instance()->serialize(*c->imp(), out);
+        else if (kind == XmlDataCalcer) {
+            QDomDocument doc;
+            QDomElement e = doc.createElement(QStringLiteral("Data"));
+            ObjectImpFactory::instance()->serialize(*c->imp(), e, doc);
+            doc.appendChild(e);
+            out << doc.toByteArray(-1);
+        }
+    }
+
+    out << static_cast<quint32>(holders.size());
+    for (std::vector<ObjectHolder *>::iterator i = holders.begin(); i != holders.end(); ++i) {
+        std::map<const ObjectCalcer *, quint32>::const_iterator idp = idmap.find((*i)->calcer());
+        assert(idp != idmap.end());
+
+        const ObjectDrawer *d = (*i)->drawer();
+        qint32 ncid = -1;
+        ObjectCalcer *namecalcer = (*i)->nameCalcer();
+        if (namecalcer) {
+            std::map<const ObjectCalcer *, quint32>::const_iterator ncp = idmap.find(namecalcer);
+            assert(ncp != idmap.end());
+            ncid = ncp->second;
+        }
+        out << idp->second << d->color().rgba() << static_cast<quint8>(d->shown()) << static_cast<qint32>(d->width()) << static_cast<qint32>(d->style())
+            << static_cast<qint32>(d->pointStyle()) << d->font().toString() << ncid;
+    }
+
+    if (impcache) {
+        const QByteArray salt = impCacheSalt(kdoc);
+        ImpCacheKeys keys;
+        std::vector<quint32> cached;
+        for (uint i = 0; i < calcers.size(); ++i) {
+            impCacheKey(calcers[i], keys, salt);
+            if (impCacheable(calcers[i]))
+                cached.push_back(i);
+        }
+        out << static_cast<quint32>(cached.size());
+        for (std::vector<quint32>::const_iterator i = cached.begin(); i != cached.end(); ++i)
+            out << *i << keys[calcers[*i]] << serializedImp(*calcers[*i]->imp());
+    }
+
+    return out.status() == QDataStream::Ok;
 }
 
-bool KigFilterNative::save07(const KigDocument &data, const QString &outfile)
+bool KigFilterNative::saveBinary(const KigDocument &data, const QString &outfile, bool impcache)
+{
+    QFile file(outfile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        fileNotFound(outfile);
+        return false;
+    }
+    return saveBinary(data, file, impcache);
+}
+
+namespace
+{
+// a write only device that only counts the bytes written to it
+class CountingDevice : public QIODevice
+{
+    qint64 mcount;
+
+public:
+    CountingDevice()
+        : mcount(0)
+    {
+    }
+    qint64 count() const
+    {
+        return mcount;
+    }
+
+protected:
+    qint64 readData(char *, qint64) override
+    {
+        return -1;
+    }
+    qint64 writeData(const char *, qint64 len) override
+    {
+        mcount += len;
+        return len;
+    }
+};
+
+// a write only device for the contents of the file that is being
+// written in a KArchive, between prepareWriting() and finishWriting()
+class ArchiveEntryDevice : public QIODevice
+{
+    KArchive &mark;
+    qint64 mwritten;
+
+public:
+    explicit ArchiveEntryDevice(KArchive &ark)
+        : mark(ark)
+        , mwritten(0)
+    {
+    }
+    qint64 written() const
+    {
+        return mwritten;
+    }
+
+protected:
+    qint64 readData(char *, qint64) override
+    {
+        return -1;
+    }
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        if (!mark.writeData(data, len))
+            return -1;
+        mwritten += len;
+        return len;
+    }
+};
+}
+
+bool KigFilterNative::save(const KigDocument &data, const QString &file, bool impcache)
+{
+    if (file.endsWith(QLatin1String(".kigb"), Qt::CaseInsensitive))
+        return saveBinary(data, file, impcache);
+    return save07(data, file, impcache);
+}
+
+bool KigFilterNative::save07(const KigDocument &data, const QString &outfile, bool impcache)
 {
     // we have an empty outfile, so we have to print all to stdout
     if (outfile.isEmpty()) {
-        QTextStream stdoutstream(stdout, QIODevice::WriteOnly);
-        stdoutstream.setCodec("UTF-8");
-        return save07(data, stdoutstream);
+        QFile stdoutfile;
+        if (!stdoutfile.open(stdout, QIODevice::WriteOnly))
+            return false;
+        return save07(data, stdoutfile, impcache);
     }
     if (!outfile.endsWith(QLatin1String(".kig"), Qt::CaseInsensitive)) {
-        // the user wants to save a compressed file, so we have to save our kig
-        // file to a temp file and then compress it...
-
-        QString tempdir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-        if (tempdir.isEmpty())
-            return false;
-
+        // the user wants to save a compressed file, so we write our kig
+        // file straight into a new archive...
         QString tempname = outfile.section('/', -1);
         if (outfile.endsWith(QLatin1String(".kigz"), Qt::CaseInsensitive))
             tempname.remove(QRegExp("\\.[Kk][Ii][Gg][Zz]$"));
         else
             return false;
 
-        const QString tmpfile = tempdir + QLatin1Char('/') + tempname + ".kig";
-        QFile ftmpfile(tmpfile);
-        if (!ftmpfile.open(QIODevice::WriteOnly))
-            return false;
-        QTextStream stream(&ftmpfile);
-        stream.setCodec("UTF-8");
-        if (!save07(data, stream))
+        // a tar entry needs its size up front, so we do a first pass
+        // that only counts the bytes, instead of keeping the whole
+        // document in memory or in a temp file
+        CountingDevice counter;
+        counter.open(QIODevice::WriteOnly);
+        if (!save07(data, counter, impcache))
             return false;
-        ftmpfile.close();
 
-        qDebug() << "tmp saved file: " << tmpfile;
-
-        // creating the archive and adding our file
-        KTar ark(outfile, QStringLiteral("application/gzip"));
-        ark.open(QIODevice::WriteOnly);
-        ark.addLocalFile(tmpfile, tempname + ".kig");
-        ark.close();
-
-        // finally, removing temp file
-        QFile::remove(tmpfile);
-
-        return true;
+        // like when loading, we compress the archive ourselves, so that
+        // KTar doesn't write it to a temp file first..
+        QFile file(outfile);
+        if (!file.open(QIODevice::WriteOnly)) {
+            fileNotFound(outfile);
+            return false;
+        }
+        KCompressionDevice gz(&file, false, KCompressionDevice::GZip);
+        if (!gz.open(QIODevice::WriteOnly))
+            return false;
+        KTar ark(&gz);
+        if (!ark.open(QIODevice::WriteOnly))
+            return false;
+        const QDateTime now = QDateTime::currentDateTime();
+        if (!ark.prepareWriting(tempname + ".kig", QString(), QString(), counter.count(), 0100644, now, now, now))
+            return false;
+        ArchiveEntryDevice entry(ark);
+        entry.open(QIODevice::WriteOnly);
+        if (!save07(data, entry, impcache) || entry.written() != counter.count())
+            return false;
+        if (!ark.finishWriting(counter.count()) || !ark.close())
+            return false;
+        gz.close();
+        return file.error() == QFileDevice::NoError;
     } else {
         QFile file(outfile);
         if (!file.open(QIODevice::WriteOnly)) {
             fileNotFound(outfile);
             return false;
         }
-        QTextStream stream(&file);
-        stream.setCodec("UTF-8");
-        return save07(data, stream);
+        return save07(data, file, impcache);
     }
 
     // we should never reach this point...
@@ -7,15 +7,21 @@
 #include "filter.h"
 
 class QDomElement;
-class QDomDocument;
+class QFile;
+class QIODevice;
+class QXmlStreamReader;
 class KigDocument;
-class QTextStream;
 class QString;
 
 /**
  * Kig's native format.  Between versions 0.3.1 and 0.4, there was a
  * change in the file format.  This filter no longer supports pre-0.4
  * formats, it did up until Kig 0.6.
+ *
+ * Documents can be saved as plain XML ( ".kig" ), as a gzipped tar
+ * archive containing the XML ( ".kigz" ), or in a binary form (
+ * ".kigb" ).  All three can be converted into each other without
+ * losing anything.
  */
 class KigFilterNative : public KigFilter
 {
@@ -27,15 +33,28 @@ private:
     KigDocument *load04(const QDomElement &doc);
     /**
      * this is the load function for the Kig format that is used
-     * starting at Kig 0.7
+     * starting at Kig 0.7.  It reads the document with a pull parser
+     * positioned at the document element, and never keeps more than a
+     * single object's XML in memory.
      */
-    KigDocument *load07(const QDomElement &doc);
+    KigDocument *load07(QXmlStreamReader &xml);
 
     /**
-     * save in the Kig format that is used starting at Kig 0.7
+     * save in the Kig format that is used starting at Kig 0.7.  The
+     * document is written out object by object, without building a
+     * DOM for it first.  See save() for \p impcache.
      */
-    bool save07(const KigDocument &data, const QString &outfile);
-    bool save07(const KigDocument &data, QTextStream &file);
+    bool save07(const KigDocument &data, const QString &outfile, bool impcache);
+    bool save07(const KigDocument &data, QIODevice &dev, bool impcache);
+
+    /**
+     * load and save the binary ".kigb" format, which holds the same
+     * data as the 0.7 format, but can be loaded much faster.  See
+     * native-filter.cc for a description.
+     */
+    KigDocument *loadBinary(QFile &file);
+    bool saveBinary(const KigDocument &data, const QString &outfile, bool impcache);
+    bool saveBinary(const KigDocument &data, QIODevice &dev, bool impcache);
 
     KigFilterNative();
     ~KigFilterNative();
@@ -45,8 +64,18 @@ public:
 
     bool supportMime(const QString &mime) override;
     KigDocument *load(const QString &file) override;
-    KigDocument *load(const QDomDocument &doc);
+    /**
+     * load a document in Kig's native format from \p dev, which must
+     * be open for reading.
+     */
+    KigDocument *load(QIODevice &dev);
 
-    bool save(const KigDocument &data, const QString &file);
+    /**
+     * save \p data to \p file.  If \p impcache is true, the imps of
+     * the objects are saved as well, so that they need not be
+     * calculated again when the document is loaded.  All objects must
+     * have been calculated then.
+     */
+    bool save(const KigDocument &data, const QString &file, bool impcache = false);
     //  bool save( const KigDocument& data, QTextStream& stream );
 };
@@ -5,6 +5,7 @@
 
 #include "pgfexporterimpvisitor.h"
 
+#include "../misc/curve_sampler.h"
 #include "../misc/goniometry.h"
 #include "../objects/bezier_imp.h"
 #include "../objects/circle_imp.h"
@@ -20,6 +21,8 @@
 #include "../objects/polygon_imp.h"
 #include "../objects/text_imp.h"
 
+#include <algorithm>
+
 void PGFExporterImpVisitor::newLine()
 {
     mstream << ";\n";
@@ -107,34 +110,15 @@ void PGFExporterImpVisitor::emitLine(const Coordinate &a, const Coordinate &b, c
 
 void PGFExporterImpVisitor::plotGenericCurve(const CurveImp *imp)
 {
-    std::vector<std::vector<Coordinate>> coordlist;
-    coordlist.push_back(std::vector<Coordinate>());
-    uint curid = 0;
-
-    Coordinate c;
-    Coordinate prev = Coordinate::invalidCoord();
-    for (double i = 0.0; i <= 1.0; i += 0.0001) {
-        c = imp->getPoint(i, mw.document());
-        if (!c.valid()) {
-            if (coordlist[curid].size() > 0) {
-                coordlist.push_back(std::vector<Coordinate>());
-                ++curid;
-                prev = Coordinate::invalidCoord();
-            }
-            continue;
-        }
-        if (!((fabs(c.x) <= 10000) && (fabs(c.y) <= 10000)))
-            continue;
-        // if there's too much distance between this coordinate and the previous
-        // one, then it's another piece of curve not joined with the rest
-        if (prev.valid() && (c.distance(prev) > 50.0)) {
-            coordlist.push_back(std::vector<Coordinate>());
-            ++curid;
-        }
-        coordlist[curid].push_back(c);
-        prev = c;
-    }
-
+    // a tolerance of a thousandth of the picture is finer than it can
+    // be rendered anyway
+    const double tolerance = std::max(msr.width(), msr.height()) / 1000;
+    // TikZ can't handle the far away samples along e.g. the asymptotes
+    // of a hyperbola, so we only keep what is in or near the picture..
+    Rect clip(msr);
+    clip.scale(3);
+    clip.setCenter(msr.center());
+    std::vector<std::vector<Coordinate>> coordlist = clipPolylines(sampleCurve(imp, mw.document(), msr, tolerance, 10000), clip);
     for (uint i = 0; i < coordlist.size(); ++i) {
         uint s = coordlist[i].size();
         // there's no point in draw curves empty or with only one point
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "tiledimagewriter.h"
+
+#include "../kig/kig_document.h"
+#include "../misc/coordinate_system.h"
+#include "../misc/kigpainter.h"
+#include "../misc/screeninfo.h"
+#include "../objects/object_holder.h"
+#include "../objects/object_imp.h"
+
+#include <QFile>
+#include <QImage>
+#include <QImageWriter>
+#include <QPainter>
+#include <QThreadPool>
+#include <QtEndian>
+
+#include <vector>
+
+#include <zlib.h>
+
+TiledImageWriter::TiledImageWriter(const KigDocument &doc, const Rect &shownrect, const QSize &size, bool showgrid, bool showaxes)
+    : mdoc(doc)
+    , mshownrect(shownrect)
+    , msize(size)
+    , mshowgrid(showgrid)
+    , mshowaxes(showaxes)
+    , mthreadsafe(true)
+{
+    const std::vector<ObjectHolder *> objs = doc.objects();
+    for (std::vector<ObjectHolder *>::const_iterator i = objs.begin(); i != objs.end(); ++i)
+        if (!(*i)->imp()->isThreadSafe())
+            mthreadsafe = false;
+}
+
+void TiledImageWriter::renderBand(int top, QImage &band) const
+{
+    // the ScreenInfo of the whole image, from which those of the tiles
+    // are derived
+    const ScreenInfo si(mshownrect, QRect(QPoint(0, 0), msize));
+
+    std::vector<QRect> tilerects;
+    for (int x = 0; x < band.width(); x += tileSize)
+        tilerects.push_back(QRect(x, top, qMin(tileSize, band.width() - x), band.height()));
+    std::vector<QImage> tiles(tilerects.size());
+
+    const auto paintTile = [this, &si](const QRect &r, QImage &tile) {
+        tile = QImage(r.size(), QImage::Format_RGB32);
+        tile.fill(Qt::white);
+        // fromScreen() maps the bottom right pixel to the bottom
+        // right corner of the rect, so we add one
+        const Rect tilerect = si.fromScreen(QRect(r.topLeft(), r.size() + QSize(1, 1)));
+        KigPainter p(ScreenInfo(tilerect, QRect(QPoint(0, 0), r.size())), &tile, mdoc, false);
+        // the grid spacing and the arrows of the axes are those of the
+        // whole image, not of this tile..
+        p.setGridWindow(si.shownRect());
+        p.drawGrid(mdoc.coordinateSystem(), mshowgrid, mshowaxes);
+        // FIXME: show the selections ?
+        p.drawObjects(mdoc.objects(), false);
+    };
+
+    // drawing e.g. a locus of a python script object runs python,
+    // which may only happen on the main thread, so such documents are
+    // painted one tile after another..
+    if (!mthreadsafe) {
+        for (uint i = 0; i < tilerects.size(); ++i)
+            paintTile(tilerects[i], tiles[i]);
+    } else {
+        // the tiles don't share anything but the ( const ) document, so
+        // they can be painted on separate threads..
+        QThreadPool pool;
+        for (uint i = 0; i < tilerects.size(); ++i) {
+            const QRect r = tilerects[i];
+            QImage &tile = tiles[i];
+            pool.start([&paintTile, r, &tile]() {
+                paintTile(r, tile);
+            });
+        }
+        pool.waitForDone();
+    }
+
+    QPainter p(&band);
+    for (uint i = 0; i < tilerects.size(); ++i)
+        p.drawImage(tilerects[i].left(), 0, tiles[i]);
+}
+
+bool TiledImageWriter::write(const QString &filename, const QByteArray &format) const
+{
+    if (format.toLower() != "png")
+        return writeOther(filename, format);
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    return writePng(file);
+}
+
+bool TiledImageWriter::writeOther(const QString &filename, const QByteArray &format) const
+{
+    QImage img(msize, QImage::Format_RGB32);
+    if (img.isNull())
+        return false;
+    for (int top = 0; top < msize.height(); top += tileSize) {
+        QImage band(msize.width(), qMin(tileSize, msize.height() - top), QImage::Format_RGB32);
+        renderBand(top, band);
+        QPainter p(&img);
+        p.drawImage(0, top, band);
+    }
+    return img.save(filename, format.constData());
+}
+
+static void writeChunk(QIODevice &dev, const char *type, const QByteArray &data)
+{
+    uchar length[4];
+    qToBigEndian<quint32>(data.size(), length);
+    dev.write(reinterpret_cast<const char *>(length), 4);
+    dev.write(type, 4);
+    dev.write(data);
+    uLong crc = crc32(0, reinterpret_cast<const Bytef *>(type), 4);
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(data.constData()), data.size());
+    uchar crcbytes[4];
+    qToBigEndian<quint32>(crc, crcbytes);
+    dev.write(reinterpret_cast<const char *>(crcbytes), 4);
+}
+
+// feeds \p size bytes at \p data to \p z, and writes the compressed
+// data to \p dev in IDAT chunks
+static bool deflateToChunks(QIODevice &dev, z_stream &z, const char *data, uint size, int flush)
+{
+    static const int chunkSize = 1 << 16;
+    QByteArray out(chunkSize, Qt::Uninitialized);
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    z.avail_in = size;
+    do {
+        z.next_out = reinterpret_cast<Bytef *>(out.data());
+        z.avail_out = chunkSize;
+        const int ret = deflate(&z, flush);
+        if (ret == Z_STREAM_ERROR)
+            return false;
+        const int have = chunkSize - z.avail_out;
+        if (have > 0)
+            writeChunk(dev, "IDAT", out.left(have));
+    } while (z.avail_out == 0);
+    return true;
+}
+
+bool TiledImageWriter::writePng(QFile &dev) const
+{
+    static const char signature[] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n'};
+    dev.write(signature, sizeof(signature));
+
+    // 8 bit RGB, not interlaced
+    QByteArray ihdr(13, '\0');
+    uchar *h = reinterpret_cast<uchar *>(ihdr.data());
+    qToBigEndian<quint32>(msize.width(), h);
+    qToBigEndian<quint32>(msize.height(), h + 4);
+    h[8] = 8;
+    h[9] = 2;
+    writeChunk(dev, "IHDR", ihdr);
+
+    z_stream z;
+    z.zalloc = Z_NULL;
+    z.zfree = Z_NULL;
+    z.opaque = Z_NULL;
+    if (deflateInit(&z, Z_DEFAULT_COMPRESSION) != Z_OK)
+        return false;
+
+    bool ok = true;
+    // a filter type byte, followed by the RGB bytes of a row
+    const int rowsize = 1 + 3 * msize.width();
+    QByteArray rows;
+    for (int top = 0; ok && top < msize.height(); top += tileSize) {
+        QImage band(msize.width(), qMin(tileSize, msize.height() - top), QImage::Format_RGB32);
+        renderBand(top, band);
+
+        rows.resize(rowsize * band.height());
+        for (int y = 0; y < band.height(); ++y) {
+            const QRgb *in = reinterpret_cast<const QRgb *>(band.constScanLine(y));
+            uchar *out = reinterpret_cast<uchar *>(rows.data()) + y * rowsize;
+            // the "Sub" filter: every byte is stored as the difference
+            // with the same byte of the pixel on its left, which
+            // compresses much better for drawings like ours
+            *out++ = 1;
+            QRgb prev = 0;
+            for (int x = 0; x < band.width(); ++x) {
+                *out++ = qRed(in[x]) - qRed(prev);
+                *out++ = qGreen(in[x]) - qGreen(prev);
+                *out++ = qBlue(in[x]) - qBlue(prev);
+                prev = in[x];
+            }
+        }
+        ok = deflateToChunks(dev, z, rows.constData(), rows.size(), Z_NO_FLUSH);
+    }
+    ok = ok && deflateToChunks(dev, z, nullptr, 0, Z_FINISH);
+    deflateEnd(&z);
+
+    writeChunk(dev, "IEND", QByteArray());
+    return ok && dev.error() == QFileDevice::NoError;
+}
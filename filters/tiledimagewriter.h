@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "../misc/rect.h"
+
+#include <QByteArray>
+#include <QSize>
+
+class KigDocument;
+class QFile;
+class QImage;
+class QString;
+
+/**
+ * TiledImageWriter renders a KigDocument into an image file of any
+ * size.  The image is painted in tiles of tileSize x tileSize pixels,
+ * each with its own KigPainter and ScreenInfo, and a band of tiles
+ * is rendered at a time, in parallel on all cores, unless the document
+ * contains objects that can't be drawn on other threads than the main
+ * one ( see ObjectImp::isThreadSafe() ).
+ *
+ * PNG files are encoded a band at a time as well, so exporting a
+ * poster sized image only needs memory for one band.  For the other
+ * formats, QImageWriter needs the whole image, which is assembled
+ * from the bands.
+ */
+class TiledImageWriter
+{
+public:
+    static const int tileSize = 512;
+
+    /**
+     * Prepare to render the part \p shownrect of \p doc into an image
+     * of \p size pixels, with or without the grid and the axes.
+     */
+    TiledImageWriter(const KigDocument &doc, const Rect &shownrect, const QSize &size, bool showgrid, bool showaxes);
+
+    /**
+     * Render the image and write it to \p filename, in \p format ( one
+     * of QImageWriter::supportedImageFormats() ).  Returns false if
+     * something went wrong.
+     */
+    bool write(const QString &filename, const QByteArray &format) const;
+
+private:
+    /**
+     * renders the rows of the image starting at \p top into \p band,
+     * which is as wide as the image.
+     */
+    void renderBand(int top, QImage &band) const;
+
+    bool writePng(QFile &file) const;
+    bool writeOther(const QString &filename, const QByteArray &format) const;
+
+    const KigDocument &mdoc;
+    Rect mshownrect;
+    QSize msize;
+    bool mshowgrid;
+    bool mshowaxes;
+    // false if painting some object may run python, see renderBand()
+    bool mthreadsafe;
+};
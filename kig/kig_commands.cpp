@@ -14,8 +14,13 @@
 #include "../misc/calcpaths.h"
 #include "../misc/coordinate_system.h"
 #include "../modes/mode.h"
+#include "../objects/bogus_imp.h"
+#include "../objects/common.h"
 #include "../objects/object_drawer.h"
 #include "../objects/object_imp.h"
+#include "../objects/object_imp_factory.h"
+
+#include <QDataStream>
 
 #include <iterator>
 #include <vector>
@@ -29,12 +34,30 @@ class KigCommand::Private
 public:
     Private(KigPart &d)
         : doc(d)
+        , memory(-1)
     {
     }
     KigPart &doc;
     vector<KigCommandTask *> tasks;
+    // the cached result of memoryUsage(), or -1
+    mutable qint64 memory;
 };
 
+// the id of commands that only change data objects
+static const int changeDataCommandId = 1;
+
+// a rough estimate of the memory used by \p imp: the size of its binary
+// form, or a guess for the imps that don't have one.
+static qint64 impMemoryUsage(const ObjectImp *imp)
+{
+    if (!ObjectImpFactory::instance()->canSerialize(*imp))
+        return 1024;
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    ObjectImpFactory::instance()->serialize(*imp, out);
+    return sizeof(ObjectImp) + data.size();
+}
+
 KigCommand::KigCommand(KigPart &doc, const QString &name)
     : QUndoCommand(name)
     , d(new Private(doc))
@@ -50,21 +73,64 @@ KigCommand::~KigCommand()
 
 void KigCommand::redo()
 {
+    d->memory = -1;
     for (uint i = 0; i < d->tasks.size(); ++i)
         d->tasks[i]->execute(d->doc);
-    d->doc.redrawScreen();
+    if (!d->doc.deferringCalc())
+        d->doc.redrawScreen();
 }
 
 void KigCommand::undo()
 {
+    d->memory = -1;
     for (uint i = 0; i < d->tasks.size(); ++i)
         d->tasks[i]->unexecute(d->doc);
-    d->doc.redrawScreen();
+    if (!d->doc.deferringCalc())
+        d->doc.redrawScreen();
 }
 
 void KigCommand::addTask(KigCommandTask *t)
 {
     d->tasks.push_back(t);
+    d->memory = -1;
+}
+
+int KigCommand::id() const
+{
+    if (d->tasks.size() == 1 && dynamic_cast<ChangeObjectConstCalcersTask *>(d->tasks[0]))
+        return changeDataCommandId;
+    return -1;
+}
+
+bool KigCommand::mergeWith(const QUndoCommand *other)
+{
+    // QUndoStack has already redone other, which means that our task
+    // still holds the imps from before us, and the document holds the
+    // ones after other.  So all we need to do is to check that other
+    // changes the same objects as we do, and keep our task.
+    const KigCommand *o = dynamic_cast<const KigCommand *>(other);
+    if (!o || id() != changeDataCommandId || o->id() != changeDataCommandId || text() != o->text())
+        return false;
+    return static_cast<ChangeObjectConstCalcersTask *>(d->tasks[0])->changesSameCalcers(*static_cast<ChangeObjectConstCalcersTask *>(o->d->tasks[0]));
+}
+
+qint64 KigCommand::memoryUsage() const
+{
+    if (d->memory < 0) {
+        d->memory = sizeof(KigCommand) + sizeof(Private);
+        for (uint i = 0; i < d->tasks.size(); ++i)
+            d->memory += d->tasks[i]->memoryUsage();
+    }
+    return d->memory;
+}
+
+void KigCommand::drop()
+{
+    for (uint i = 0; i < d->tasks.size(); ++i)
+        delete d->tasks[i];
+    d->tasks.clear();
+    d->memory = -1;
+    setObsolete(true);
 }
 
 KigCommand *KigCommand::removeCommand(KigPart &doc, ObjectHolder *o)
@@ -122,6 +188,11 @@ KigCommandTask::~KigCommandTask()
 {
 }
 
+qint64 KigCommandTask::memoryUsage() const
+{
+    return sizeof(KigCommandTask);
+}
+
 AddObjectsTask::AddObjectsTask(const std::vector<ObjectHolder *> &os)
     : KigCommandTask()
     , undone(true)
@@ -133,6 +204,14 @@ void AddObjectsTask::execute(KigPart &doc)
 {
     doc._addObjects(mobjs);
     undone = false;
+    if (doc.deferringCalc())
+        return;
+
+    // while we were undone, intermediate objects that only our objects
+    // hold were not recalculated when their parents changed, and a
+    // jump through the history doesn't recalculate them either, see
+    // KigPart::finishDeferredCalc()..
+    calcAll(calcPath(getAllParents(getAllCalcers(mobjs))), doc.document());
 }
 
 void AddObjectsTask::unexecute(KigPart &doc)
@@ -148,6 +227,16 @@ AddObjectsTask::~AddObjectsTask()
             delete *i;
 }
 
+qint64 AddObjectsTask::memoryUsage() const
+{
+    qint64 ret = sizeof(AddObjectsTask) + mobjs.size() * sizeof(ObjectHolder *);
+    // while they are in the document, the objects don't count as ours
+    if (undone)
+        for (std::vector<ObjectHolder *>::const_iterator i = mobjs.begin(); i != mobjs.end(); ++i)
+            ret += sizeof(ObjectHolder) + sizeof(ObjectDrawer) + impMemoryUsage((*i)->imp());
+    return ret;
+}
+
 RemoveObjectsTask::RemoveObjectsTask(const std::vector<ObjectHolder *> &os)
     : AddObjectsTask(os)
 {
@@ -174,12 +263,12 @@ ChangeObjectConstCalcerTask::ChangeObjectConstCalcerTask(ObjectConstCalcer *calc
 void ChangeObjectConstCalcerTask::execute(KigPart &doc)
 {
     mnewimp = mcalcer->switchImp(mnewimp);
+    if (doc.deferringCalc())
+        return;
 
     std::set<ObjectCalcer *> allchildren = getAllChildren(mcalcer.get());
     std::vector<ObjectCalcer *> allchildrenvect(allchildren.begin(), allchildren.end());
-    allchildrenvect = calcPath(allchildrenvect);
-    for (std::vector<ObjectCalcer *>::iterator i = allchildrenvect.begin(); i != allchildrenvect.end(); ++i)
-        (*i)->calc(doc.document());
+    calcAll(calcPath(allchildrenvect), doc.document());
 }
 
 void ChangeObjectConstCalcerTask::unexecute(KigPart &doc)
@@ -187,20 +276,127 @@ void ChangeObjectConstCalcerTask::unexecute(KigPart &doc)
     execute(doc);
 }
 
-struct MoveDataStruct {
-    ObjectConstCalcer *o;
-    ObjectImp *oldimp;
-    MoveDataStruct(ObjectConstCalcer *io, ObjectImp *oi)
-        : o(io)
-        , oldimp(oi)
+qint64 ChangeObjectConstCalcerTask::memoryUsage() const
+{
+    return sizeof(ChangeObjectConstCalcerTask) + impMemoryUsage(mnewimp);
+}
+
+namespace
+{
+/**
+ * the imp of an ObjectConstCalcer, as stored by
+ * ChangeObjectConstCalcersTask and MonitorDataObjects: a DoubleImp is
+ * kept as its value, any other imp as a copy.
+ */
+struct StoredImp {
+    ObjectConstCalcer::shared_ptr calcer;
+    double value;
+    ObjectImp *imp;
+
+    StoredImp(ObjectConstCalcer *c, ObjectImp *i)
+        : calcer(c)
+        , value(0.)
+        , imp(i)
+    {
+        if (imp->type() == DoubleImp::stype()) {
+            value = static_cast<DoubleImp *>(imp)->data();
+            delete imp;
+            imp = nullptr;
+        }
+    }
+    bool equals(const ObjectImp &other) const
+    {
+        if (imp)
+            return imp->equals(other);
+        return other.type() == DoubleImp::stype() && static_cast<const DoubleImp &>(other).data() == value;
+    }
+    // returns the stored imp as a new ObjectImp, that the caller owns
+    ObjectImp *take()
     {
+        ObjectImp *ret = imp ? imp : new DoubleImp(value);
+        imp = nullptr;
+        return ret;
     }
 };
+}
+
+class ChangeObjectConstCalcersTask::Private
+{
+public:
+    std::vector<StoredImp> imps;
+};
+
+ChangeObjectConstCalcersTask::ChangeObjectConstCalcersTask()
+    : KigCommandTask()
+    , d(new Private)
+{
+}
+
+ChangeObjectConstCalcersTask::~ChangeObjectConstCalcersTask()
+{
+    for (std::vector<StoredImp>::iterator i = d->imps.begin(); i != d->imps.end(); ++i)
+        delete i->imp;
+    delete d;
+}
+
+void ChangeObjectConstCalcersTask::add(ObjectConstCalcer *calcer, ObjectImp *newimp)
+{
+    d->imps.push_back(StoredImp(calcer, newimp));
+}
+
+bool ChangeObjectConstCalcersTask::empty() const
+{
+    return d->imps.empty();
+}
+
+bool ChangeObjectConstCalcersTask::changesSameCalcers(const ChangeObjectConstCalcersTask &other) const
+{
+    if (d->imps.size() != other.d->imps.size())
+        return false;
+    for (uint i = 0; i < d->imps.size(); ++i)
+        if (d->imps[i].calcer != other.d->imps[i].calcer)
+            return false;
+    return true;
+}
+
+void ChangeObjectConstCalcersTask::execute(KigPart &doc)
+{
+    std::vector<ObjectCalcer *> changed;
+    for (std::vector<StoredImp>::iterator i = d->imps.begin(); i != d->imps.end(); ++i) {
+        ObjectImp *oldimp = i->calcer->switchImp(i->take());
+        *i = StoredImp(i->calcer.get(), oldimp);
+        changed.push_back(i->calcer.get());
+    }
+    if (doc.deferringCalc())
+        return;
+
+    std::set<ObjectCalcer *> allchildren;
+    for (std::vector<ObjectCalcer *>::iterator i = changed.begin(); i != changed.end(); ++i) {
+        std::set<ObjectCalcer *> children = getAllChildren(*i);
+        allchildren.insert(children.begin(), children.end());
+    }
+    std::vector<ObjectCalcer *> allchildrenvect(allchildren.begin(), allchildren.end());
+    calcAll(calcPath(allchildrenvect), doc.document());
+}
+
+void ChangeObjectConstCalcersTask::unexecute(KigPart &doc)
+{
+    execute(doc);
+}
+
+qint64 ChangeObjectConstCalcersTask::memoryUsage() const
+{
+    qint64 ret = sizeof(ChangeObjectConstCalcersTask) + sizeof(Private) + d->imps.capacity() * sizeof(StoredImp);
+    for (std::vector<StoredImp>::const_iterator i = d->imps.begin(); i != d->imps.end(); ++i)
+        if (i->imp)
+            ret += impMemoryUsage(i->imp);
+    return ret;
+}
 
 class MonitorDataObjects::Private
 {
 public:
-    vector<MoveDataStruct> movedata;
+    vector<StoredImp> movedata;
 };
 
 MonitorDataObjects::MonitorDataObjects(const std::vector<ObjectCalcer *> &objs)
@@ -212,23 +408,26 @@ MonitorDataObjects::MonitorDataObjects(const std::vector<ObjectCalcer *> &objs)
 void MonitorDataObjects::monitor(const std::vector<ObjectCalcer *> &objs)
 {
     for (std::vector<ObjectCalcer *>::const_iterator i = objs.begin(); i != objs.end(); ++i)
-        if (dynamic_cast<ObjectConstCalcer *>(*i)) {
-            MoveDataStruct n(static_cast<ObjectConstCalcer *>(*i), (*i)->imp()->copy());
-            d->movedata.push_back(n);
-        };
+        if (dynamic_cast<ObjectConstCalcer *>(*i))
+            d->movedata.push_back(StoredImp(static_cast<ObjectConstCalcer *>(*i), (*i)->imp()->copy()));
 }
 
 void MonitorDataObjects::finish(KigCommand *comm)
 {
+    ChangeObjectConstCalcersTask *task = new ChangeObjectConstCalcersTask;
     for (uint i = 0; i < d->movedata.size(); ++i) {
-        ObjectConstCalcer *o = d->movedata[i].o;
-        if (!d->movedata[i].oldimp->equals(*o->imp())) {
-            ObjectImp *newimp = o->switchImp(d->movedata[i].oldimp);
-            comm->addTask(new ChangeObjectConstCalcerTask(o, newimp));
+        ObjectConstCalcer *o = d->movedata[i].calcer.get();
+        if (!d->movedata[i].equals(*o->imp())) {
+            ObjectImp *newimp = o->switchImp(d->movedata[i].take());
+            task->add(o, newimp);
         } else
-            delete d->movedata[i].oldimp;
+            delete d->movedata[i].imp;
     };
     d->movedata.clear();
+    if (task->empty())
+        delete task;
+    else
+        comm->addTask(task);
 }
 
 MonitorDataObjects::~MonitorDataObjects()
@@ -246,10 +445,10 @@ ChangeCoordSystemTask::ChangeCoordSystemTask(CoordinateSystem *s)
 void ChangeCoordSystemTask::execute(KigPart &doc)
 {
     mcs = doc.document().switchCoordinateSystem(mcs);
-    std::vector<ObjectCalcer *> calcpath = calcPath(getAllCalcers(doc.document().objects()));
-    for (std::vector<ObjectCalcer *>::iterator i = calcpath.begin(); i != calcpath.end(); ++i)
-        (*i)->calc(doc.document());
     doc.coordSystemChanged(doc.document().coordinateSystem().id());
+    if (doc.deferringCalc())
+        return;
+    calcAll(calcPath(getAllCalcers(doc.document().objects())), doc.document());
 }
 
 void ChangeCoordSystemTask::unexecute(KigPart &doc)
@@ -297,15 +496,15 @@ void ChangeParentsAndTypeTask::execute(KigPart &doc)
         newparents.push_back(i->get());
     d->o->setParents(newparents);
     d->newparents = oldparents;
+    if (doc.deferringCalc())
+        return;
 
     for (std::vector<ObjectCalcer *>::iterator i = newparents.begin(); i != newparents.end(); ++i)
         (*i)->calc(doc.document());
     d->o->calc(doc.document());
     std::set<ObjectCalcer *> allchildren = getAllChildren(d->o);
     std::vector<ObjectCalcer *> allchildrenvect(allchildren.begin(), allchildren.end());
-    allchildrenvect = calcPath(allchildrenvect);
-    for (std::vector<ObjectCalcer *>::iterator i = allchildrenvect.begin(); i != allchildrenvect.end(); ++i)
-        (*i)->calc(doc.document());
+    calcAll(calcPath(allchildrenvect), doc.document());
 }
 
 void ChangeParentsAndTypeTask::unexecute(KigPart &doc)
@@ -340,7 +539,8 @@ void KigViewShownRectChangeTask::execute(KigPart &doc)
 {
     Rect oldrect = d->v.showingRect();
     d->v.setShowingRect(d->rect);
-    doc.mode()->redrawScreen(&d->v);
+    if (!doc.deferringCalc())
+        doc.mode()->redrawScreen(&d->v);
     d->v.updateScrollBars();
     d->rect = oldrect;
 }
@@ -375,10 +575,8 @@ void ChangeObjectDrawerTask::unexecute(KigPart &doc)
 MonitorDataObjects::MonitorDataObjects(ObjectCalcer *c)
     : d(new Private)
 {
-    if (dynamic_cast<ObjectConstCalcer *>(c)) {
-        MoveDataStruct n(static_cast<ObjectConstCalcer *>(c), c->imp()->copy());
-        d->movedata.push_back(n);
-    };
+    if (dynamic_cast<ObjectConstCalcer *>(c))
+        d->movedata.push_back(StoredImp(static_cast<ObjectConstCalcer *>(c), c->imp()->copy()));
 }
 
 ChangeObjectConstCalcerTask::~ChangeObjectConstCalcerTask()
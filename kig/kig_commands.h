@@ -64,6 +64,27 @@ public:
     void redo() override;
     void undo() override;
 
+    /**
+     * Commands that only change data objects ( see MonitorDataObjects )
+     * have an id, so that consecutive changes to the same objects,
+     * like dragging a point around a few times, are merged into one.
+     */
+    int id() const override;
+    bool mergeWith(const QUndoCommand *other) override;
+
+    /**
+     * A rough estimate of the memory this command holds on to, in
+     * bytes.  \sa KigPart::historyMemoryUsage
+     */
+    qint64 memoryUsage() const;
+    /**
+     * Frees the contents of this command, and makes it obsolete, so
+     * that QUndoStack deletes it instead of undoing it.  This is how
+     * KigPart evicts the oldest commands when the history uses too
+     * much memory.
+     */
+    void drop();
+
 private:
     Q_DISABLE_COPY(KigCommand)
 };
@@ -79,6 +100,11 @@ public:
 
     virtual void execute(KigPart &doc) = 0;
     virtual void unexecute(KigPart &doc) = 0;
+
+    /**
+     * A rough estimate of the memory this task holds on to, in bytes.
+     */
+    virtual qint64 memoryUsage() const;
 };
 
 class AddObjectsTask : public KigCommandTask
@@ -88,6 +114,7 @@ public:
     ~AddObjectsTask();
     void execute(KigPart &doc) override;
     void unexecute(KigPart &doc) override;
+    qint64 memoryUsage() const override;
 
 protected:
     bool undone;
@@ -111,12 +138,45 @@ public:
 
     void execute(KigPart &) override;
     void unexecute(KigPart &) override;
+    qint64 memoryUsage() const override;
 
 protected:
     ObjectConstCalcer::shared_ptr mcalcer;
     ObjectImp *mnewimp;
 };
 
+/**
+ * Changes the imps of a number of ObjectConstCalcer's at once, and
+ * recalculates their children only once.  This is the task that
+ * MonitorDataObjects generates.  Moving objects mostly changes
+ * DoubleImp's ( e.g. the coordinates of a fixed point ), so those are
+ * kept as plain doubles.
+ */
+class ChangeObjectConstCalcersTask : public KigCommandTask
+{
+    class Private;
+    Private *d;
+
+public:
+    ChangeObjectConstCalcersTask();
+    ~ChangeObjectConstCalcersTask();
+
+    /**
+     * Let this task set the imp of \p calcer to \p newimp.  The task
+     * takes ownership of \p newimp.
+     */
+    void add(ObjectConstCalcer *calcer, ObjectImp *newimp);
+    bool empty() const;
+    /**
+     * Whether \p other changes exactly the same calcers as this task.
+     */
+    bool changesSameCalcers(const ChangeObjectConstCalcersTask &other) const;
+
+    void execute(KigPart &) override;
+    void unexecute(KigPart &) override;
+    qint64 memoryUsage() const override;
+};
+
 /**
  * this class monitors a set of DataObjects for changes and returns an
  * appropriate ChangeObjectImpsCommand if necessary.
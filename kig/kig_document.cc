@@ -8,6 +8,7 @@
 #include "../misc/common.h"
 #include "../misc/coordinate_system.h"
 #include "../misc/rect.h"
+#include "../misc/tracer.h"
 #include "../objects/object_calcer.h"
 #include "../objects/object_holder.h"
 #include "../objects/point_imp.h"
@@ -24,6 +25,8 @@ KigDocument::KigDocument(const std::set<ObjectHolder *> &objects, CoordinateSyst
     , mshowaxes(showaxes)
     , mnightvision(nv)
     , mcoordinatePrecision(-1)
+    , mfixedboundsinited(false)
+    , mfixedboundsvalid(false)
     , mcachedparam(0.0)
 {
 }
@@ -58,6 +61,7 @@ CoordinateSystem *KigDocument::switchCoordinateSystem(CoordinateSystem *s)
 
 std::vector<ObjectHolder *> KigDocument::whatAmIOn(const Coordinate &p, const KigWidget &w) const
 {
+    Tracer::Span span("KigDocument::whatAmIOn", "hittest");
     std::vector<ObjectHolder *> ret;
     std::vector<ObjectHolder *> curves;
     std::vector<ObjectHolder *> fatobjects;
@@ -94,22 +98,42 @@ std::vector<ObjectHolder *> KigDocument::whatIsInHere(const Rect &p, const KigWi
     return ret;
 }
 
+// extends r with the bounds of o, if it is shown and has bounds..
+static void addBounds(const ObjectHolder *o, Rect &r, bool &rectInited)
+{
+    if (!o->shown())
+        return;
+    Rect cr = o->imp()->surroundingRect();
+    if (!cr.valid())
+        return;
+    if (!rectInited) {
+        r = cr;
+        rectInited = true;
+    } else
+        r.eat(cr);
+}
+
 Rect KigDocument::suggestedRect() const
 {
     bool rectInited = false;
     Rect r(0., 0., 0., 0.);
-    for (std::set<ObjectHolder *>::const_iterator i = mobjects.begin(); i != mobjects.end(); ++i) {
-        if ((*i)->shown()) {
-            Rect cr = (*i)->imp()->surroundingRect();
-            if (!cr.valid())
-                continue;
-            if (!rectInited) {
-                r = cr;
-                rectInited = true;
-            } else
-                r.eat(cr);
-        };
-    };
+    if (mchanging.empty()) {
+        for (std::set<ObjectHolder *>::const_iterator i = mobjects.begin(); i != mobjects.end(); ++i)
+            addBounds(*i, r, rectInited);
+    } else {
+        // the objects that don't change only need to be looked at once..
+        if (!mfixedboundsvalid) {
+            mfixedboundsinited = false;
+            for (std::set<ObjectHolder *>::const_iterator i = mobjects.begin(); i != mobjects.end(); ++i)
+                if (mchanging.find(*i) == mchanging.end())
+                    addBounds(*i, mfixedbounds, mfixedboundsinited);
+            mfixedboundsvalid = true;
+        }
+        r = mfixedbounds;
+        rectInited = mfixedboundsinited;
+        for (std::set<ObjectHolder *>::const_iterator i = mchanging.begin(); i != mchanging.end(); ++i)
+            addBounds(*i, r, rectInited);
+    }
 
     if (!rectInited)
         return Rect(-5.5, -5.5, 11., 11.);
@@ -127,6 +151,7 @@ Rect KigDocument::suggestedRect() const
 void KigDocument::addObject(ObjectHolder *o)
 {
     mobjects.insert(o);
+    mfixedboundsvalid = false;
 }
 
 void KigDocument::addObjects(const std::vector<ObjectHolder *> &os)
@@ -134,17 +159,38 @@ void KigDocument::addObjects(const std::vector<ObjectHolder *> &os)
     for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
         (*i)->calc(*this);
     std::copy(os.begin(), os.end(), std::inserter(mobjects, mobjects.begin()));
+    mfixedboundsvalid = false;
 }
 
 void KigDocument::delObject(ObjectHolder *o)
 {
     mobjects.erase(o);
+    mchanging.erase(o);
+    mfixedboundsvalid = false;
 }
 
 void KigDocument::delObjects(const std::vector<ObjectHolder *> &os)
 {
-    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i) {
         mobjects.erase(*i);
+        mchanging.erase(*i);
+    }
+    mfixedboundsvalid = false;
+}
+
+void KigDocument::startChanging(const std::vector<ObjectHolder *> &os)
+{
+    mchanging.clear();
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
+        if (mobjects.find(*i) != mobjects.end())
+            mchanging.insert(*i);
+    mfixedboundsvalid = false;
+}
+
+void KigDocument::endChanging()
+{
+    mchanging.clear();
+    mfixedboundsvalid = false;
 }
 
 KigDocument::KigDocument()
@@ -154,6 +200,8 @@ KigDocument::KigDocument()
     mshowaxes = true;
     mnightvision = false;
     mcoordinatePrecision = -1;
+    mfixedboundsinited = false;
+    mfixedboundsvalid = false;
 }
 
 KigDocument::~KigDocument()
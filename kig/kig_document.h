@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include "../misc/rect.h"
+
+#include <atomic>
 #include <set>
 #include <vector>
 
@@ -12,7 +15,6 @@ class CoordinateSystem;
 class KigWidget;
 class ObjectHolder;
 class ObjectCalcer;
-class Rect;
 
 /**
  * KigDocument is the class holding the real data in a Kig document.
@@ -54,8 +56,22 @@ class KigDocument
      */
     int mcoordinatePrecision;
 
+    /**
+     * The objects that are changing continuously at the moment, see
+     * startChanging().  While there are any, suggestedRect() combines
+     * their bounds with mfixedbounds, the bounds of all other objects,
+     * which are only calculated once.
+     */
+    std::set<ObjectHolder *> mchanging;
+    mutable Rect mfixedbounds;
+    // whether any of the other objects has bounds at all..
+    mutable bool mfixedboundsinited;
+    mutable bool mfixedboundsvalid;
+
 public:
-    mutable double mcachedparam;
+    // see CurveImp::getParam().  This is atomic because loci are drawn
+    // from several threads at once by the image exporter.
+    mutable std::atomic<double> mcachedparam;
 
 public:
     KigDocument();
@@ -117,6 +133,16 @@ public:
      */
     Rect suggestedRect() const;
 
+    /**
+     * Tells the document that the objects \p os will be changing
+     * continuously ( e.g. because the user is dragging them around )
+     * until endChanging() is called, and that the other objects won't.
+     * This makes suggestedRect() cost proportional to the number of
+     * changing objects instead of to the size of the document.
+     */
+    void startChanging(const std::vector<ObjectHolder *> &os);
+    void endChanging();
+
     /**
      * Add the objects \p o to the document.
      */
@@ -23,17 +23,23 @@
 #include "../misc/kigcoordinateprecisiondialog.h"
 #include "../misc/kigpainter.h"
 #include "../misc/lists.h"
+#include "../misc/macro_cache.h"
 #include "../misc/object_constructor.h"
+#include "../misc/profiler.h"
+#include "../misc/tracer.h"
 #include "../misc/screeninfo.h"
 #include "../modes/normal.h"
+#include "../objects/bogus_imp.h"
 #include "../objects/object_drawer.h"
 #include "../objects/point_imp.h"
 
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#include <set>
 
 #include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileDialog>
 #include <QMimeDatabase>
@@ -45,11 +51,13 @@
 #include <QTimer>
 
 #include <KActionCollection>
+#include <KConfigGroup>
 #include <KIconEngine>
 #include <KIconLoader>
 #include <KMessageBox>
 #include <KParts/OpenUrlArguments>
 #include <KPluginFactory>
+#include <KSharedConfig>
 #include <KStandardAction>
 #include <KToggleAction>
 #include <KUndoActions>
@@ -170,7 +178,12 @@ KigPart::KigPart(QWidget *parentWidget, QObject *parent, const QVariantList &)
     , mMode(nullptr)
     , mRememberConstruction(nullptr)
     , mdocument(new KigDocument())
+    , mpendingpos(0)
+    , mdeferringcalc(false)
+    , mhistorylimit(0)
 {
+    Tracer::startFromEnvironment();
+
     mMode = new NormalMode(*this);
 
     // we need a widget, to actually show the document
@@ -193,6 +206,9 @@ KigPart::KigPart(QWidget *parentWidget, QObject *parent, const QVariantList &)
     KUndoActions::createUndoAction(mhistory, actionCollection());
     KUndoActions::createRedoAction(mhistory, actionCollection());
     connect(mhistory, &QUndoStack::cleanChanged, this, &KigPart::setHistoryClean);
+    connect(mhistory, &QUndoStack::indexChanged, this, &KigPart::trimHistory);
+    KConfigGroup undocg = KSharedConfig::openConfig()->group("Undo");
+    mhistorylimit = undocg.readEntry("MaxMemory", 128) * Q_INT64_C(1024) * 1024;
 
     // we are read-write by default
     setReadWrite(true);
@@ -362,6 +378,11 @@ KigPart::~KigPart()
     delete_all(aActions.begin(), aActions.end());
     aActions.clear();
 
+    if (Profiler::enabled())
+        Profiler::instance()->dump(*mdocument);
+    if (Tracer::enabled())
+        Tracer::instance()->flush();
+
     // cleanup
     delete mMode;
     delete mhistory;
@@ -371,6 +392,7 @@ KigPart::~KigPart()
 
 bool KigPart::openFile()
 {
+    Tracer::Span span("KigPart::openFile", "io");
     QFileInfo fileinfo(localFilePath());
     if (!fileinfo.exists()) {
         KMessageBox::error(widget(),
@@ -417,9 +439,35 @@ bool KigPart::openFile()
     setModified(false);
     mhistory->clear();
 
-    std::vector<ObjectCalcer *> tmp = calcPath(getAllParents(getAllCalcers(document().objects())));
+    // we only calculate what is needed to show the document ( which
+    // is also all that suggestedRect() looks at ) before showing it,
+    // the rest is calculated in the background by calcPendingObjects().
+    // Objects whose imp was stored in the document ( see
+    // KigFilterNative::save ) are shown with that imp at first, and
+    // only recalculated in the background.
+    const std::vector<ObjectHolder *> os = document().objects();
+    std::vector<ObjectCalcer *> shown;
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
+        if ((*i)->shown())
+            shown.push_back((*i)->calcer());
+    std::vector<ObjectCalcer *> tmp = calcPath(getAllParents(shown));
+    std::vector<ObjectCalcer *> initial;
     for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
-        (*i)->calc(document());
+        if ((*i)->imp()->inherits(InvalidImp::stype()))
+            initial.push_back(*i);
+    calcAll(initial, document());
+    std::set<ObjectCalcer *> done(initial.begin(), initial.end());
+
+    const bool scheduled = mpendingpos < mpendingcalc.size();
+    tmp = calcPath(getAllParents(getAllCalcers(os)));
+    mpendingcalc.clear();
+    mpendingpos = 0;
+    for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
+        if (done.find(*i) == done.end())
+            mpendingcalc.push_back(*i);
+    if (!scheduled && !mpendingcalc.empty())
+        QTimer::singleShot(0, this, &KigPart::calcPendingObjects);
+
     Q_EMIT recenterScreen();
 
     redrawScreen();
@@ -429,12 +477,13 @@ bool KigPart::openFile()
 
 bool KigPart::saveFile()
 {
+    Tracer::Span span("KigPart::saveFile", "io");
     if (url().isEmpty())
         return internalSaveAs();
     // mimetype:
     const QMimeDatabase mimeDb;
     const QMimeType mimeType = mimeDb.mimeTypeForFile(localFilePath());
-    if (mimeType.name() != QLatin1String("application/x-kig")) {
+    if (mimeType.name() != QLatin1String("application/x-kig") && mimeType.name() != QLatin1String("application/x-kig-binary")) {
         // we don't support this mime type...
 #if KWIDGETSADDONS_VERSION >= QT_VERSION_CHECK(5, 100, 0)
         if (KMessageBox::warningTwoActions(widget(),
@@ -470,7 +519,13 @@ bool KigPart::saveFile()
         internalSaveAs();
     }
 
-    if (KigFilters::instance()->save(document(), localFilePath())) {
+    // storing the calculated objects in the document makes it open
+    // faster, at the cost of a larger file
+    KConfigGroup cg = KSharedConfig::openConfig()->group("Native Format");
+    const bool impcache = cg.readEntry("SaveComputedObjects", false);
+    if (impcache)
+        finishPendingCalc();
+    if (KigFilters::instance()->save(document(), localFilePath(), impcache)) {
         setModified(false);
         mhistory->setClean();
         return true;
@@ -537,6 +592,7 @@ void KigPart::_delObject(ObjectHolder *o)
 
 void KigPart::setMode(KigMode *m)
 {
+    finishPendingCalc();
     mMode = m;
     m->enableActions();
     redrawScreen();
@@ -610,6 +666,52 @@ void KigPart::browseHistory()
     mode()->browseHistory();
 }
 
+void KigPart::calcPendingObjects()
+{
+    // calculate for a short while, and then give the event loop a
+    // chance, so that Kig stays responsive..
+    QElapsedTimer t;
+    t.start();
+    while (mpendingpos < mpendingcalc.size() && t.elapsed() < 20)
+        mpendingcalc[mpendingpos++]->calc(document());
+    if (mpendingpos < mpendingcalc.size())
+        QTimer::singleShot(0, this, &KigPart::calcPendingObjects);
+    else {
+        mpendingcalc.clear();
+        mpendingpos = 0;
+        // shown objects may have been recalculated too, see openFile()
+        redrawScreen();
+    }
+}
+
+void KigPart::finishPendingCalc()
+{
+    calcAll(std::vector<ObjectCalcer *>(mpendingcalc.begin() + mpendingpos, mpendingcalc.end()), document());
+    mpendingcalc.clear();
+    mpendingpos = 0;
+}
+
+void KigPart::startDeferredCalc()
+{
+    mdeferringcalc = true;
+}
+
+void KigPart::finishDeferredCalc()
+{
+    mdeferringcalc = false;
+    // everything gets calculated here, so there is no need to finish
+    // a background calculation after loading anymore
+    mpendingcalc.clear();
+    mpendingpos = 0;
+    calcAll(calcPath(getAllParents(getAllCalcers(document().objects()))), document());
+    redrawScreen();
+}
+
+bool KigPart::deferringCalc() const
+{
+    return mdeferringcalc;
+}
+
 void KigPart::setHistoryClean(bool clean)
 {
     setModified(!clean);
@@ -631,6 +733,34 @@ QUndoStack *KigPart::history()
     return mhistory;
 }
 
+qint64 KigPart::historyMemoryUsage() const
+{
+    qint64 ret = 0;
+    for (int i = 0; i < mhistory->count(); ++i)
+        if (const KigCommand *c = dynamic_cast<const KigCommand *>(mhistory->command(i)))
+            ret += c->memoryUsage();
+    return ret;
+}
+
+void KigPart::trimHistory()
+{
+    if (mhistorylimit <= 0)
+        return;
+    // QUndoStack cannot remove its oldest commands, so we empty them
+    // instead, and mark them obsolete, so that they are deleted as soon
+    // as they are undone.  Only commands that are done can go, the ones
+    // that can be redone are still needed..
+    qint64 usage = historyMemoryUsage();
+    for (int i = 0; i < mhistory->index() && usage > mhistorylimit; ++i) {
+        const KigCommand *c = dynamic_cast<const KigCommand *>(mhistory->command(i));
+        if (!c || c->isObsolete())
+            continue;
+        usage -= c->memoryUsage();
+        const_cast<KigCommand *>(c)->drop();
+        usage += c->memoryUsage();
+    }
+}
+
 void KigPart::delObjects(const std::vector<ObjectHolder *> &os)
 {
     if (os.size() < 1)
@@ -702,7 +832,7 @@ void KigPart::fileSave()
 bool KigPart::internalSaveAs()
 {
     // this slot is connected to the KStandardAction::saveAs action...
-    QString formats = i18n("Kig Documents (*.kig);;Compressed Kig Documents (*.kigz)");
+    QString formats = i18n("Kig Documents (*.kig);;Compressed Kig Documents (*.kigz);;Binary Kig Documents (*.kigb)");
     QString currentDir = url().toLocalFile();
 
     if (currentDir.isNull()) {
@@ -805,6 +935,7 @@ void KigPart::setupMacroTypes()
             copy(nmacros.begin(), nmacros.end(), back_inserter(macros));
         }
         MacroList::instance()->add(macros);
+        MacroCache::instance()->sync();
     };
     // hack: we need to plug the action lists _after_ the gui is
     // built.. i can't find a better solution than this...
@@ -836,6 +967,7 @@ void KigPart::setupBuiltinMacros()
                 delete macro;
             };
         };
+        MacroCache::instance()->sync();
     };
 }
 
@@ -936,6 +1068,7 @@ void KigPart::hideObjects(const std::vector<ObjectHolder *> &inos)
 
 void KigPart::showObjects(const std::vector<ObjectHolder *> &inos)
 {
+    finishPendingCalc();
     std::vector<ObjectHolder *> os;
     for (std::vector<ObjectHolder *>::const_iterator i = inos.begin(); i != inos.end(); ++i) {
         if (!(*i)->shown())
@@ -1008,11 +1141,8 @@ extern "C" KIGPART_EXPORT int convertToNative(const QUrl &url, const QByteArray
         return -1;
     }
 
-    std::vector<ObjectCalcer *> tmp = calcPath(getAllParents(getAllCalcers(doc->objects())));
-    for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
-        (*i)->calc(*doc);
-    for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
-        (*i)->calc(*doc);
+    // no need to calculate the document: saving only needs the data
+    // objects, and the loader has calculated the parents of properties
 
     QString out = (outfile == "-") ? QString() : outfile;
     bool success = KigFilters::instance()->save(*doc, out);
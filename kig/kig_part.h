@@ -14,6 +14,8 @@
 
 #include <vector>
 
+#include "../objects/object_calcer.h"
+
 class KAboutData;
 class KToggleAction;
 class QUndoStack;
@@ -118,6 +120,10 @@ public Q_SLOTS:
 
     void setCoordinatePrecision();
 
+private Q_SLOTS:
+    void calcPendingObjects();
+    void trimHistory();
+
     /****************** cooperation with stuff ******************/
 public:
     void addWidget(KigWidget *);
@@ -134,6 +140,29 @@ public:
     void rememberConstruction(ConstructibleAction *);
     void coordSystemChanged(int);
 
+    /**
+     * After loading a document, only the objects that are needed to
+     * show it are calculated right away, the others are calculated in
+     * the background ( see openFile() ).  This calculates whatever is
+     * still pending right now.  It is called before anything that may
+     * need the hidden objects, like entering a mode or showing
+     * objects.
+     */
+    void finishPendingCalc();
+
+    /**
+     * While calculation is deferred, the KigCommandTask's don't
+     * recalculate the objects they change, and KigCommand's don't
+     * redraw the screen.  finishDeferredCalc() then calculates the
+     * whole document once, and redraws it.  Objects that are not in the
+     * document then are recalculated by AddObjectsTask when they are
+     * added again.  This is used to replay many history steps at once,
+     * see HistoryDialog.
+     */
+    void startDeferredCalc();
+    void finishDeferredCalc();
+    bool deferringCalc() const;
+
 Q_SIGNALS: // these signals are for telling KigView it should do something...
     /**
      * emitted when we want to suggest a new size for the view
@@ -252,6 +281,13 @@ public:
     void endGUIActionUpdate(GUIUpdateToken &t);
 
     QUndoStack *history();
+    /**
+     * A rough estimate of the memory used by the commands in the
+     * history, in bytes.  When this exceeds the "MaxMemory" entry of
+     * the "Undo" group in kigrc ( in MiB, default 128, 0 for no limit ),
+     * the oldest commands are dropped.
+     */
+    qint64 historyMemoryUsage() const;
 
     void enableConstructActions(bool enabled);
 
@@ -278,6 +314,24 @@ protected:
      */
     std::vector<ObjectHolder *> mcurrentObjectGroup;
 
+    /**
+     * The objects of the loaded document that still need to be
+     * calculated, in calc order, and the position of the next one.
+     */
+    std::vector<ObjectCalcer::shared_ptr> mpendingcalc;
+    uint mpendingpos;
+
+    /**
+     * \sa See also startDeferredCalc finishDeferredCalc
+     */
+    bool mdeferringcalc;
+
+    /**
+     * The maximum memory the history may use, in bytes, or 0.
+     * \sa See also historyMemoryUsage
+     */
+    qint64 mhistorylimit;
+
 public:
     const KigDocument &document() const;
     KigDocument &document();
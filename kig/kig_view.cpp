@@ -10,6 +10,8 @@
 #include "../misc/coordinate_system.h"
 #include "../misc/kiginputdialog.h"
 #include "../misc/kigpainter.h"
+#include "../misc/profiler.h"
+#include "../misc/tracer.h"
 #include "../modes/dragrectmode.h"
 #include "../modes/mode.h"
 #include "kig_commands.h"
@@ -17,6 +19,7 @@
 #include "kig_part.h"
 
 #include <QGridLayout>
+#include <QRegion>
 #include <QScrollBar>
 #include <QWheelEvent>
 
@@ -34,6 +37,7 @@ KigWidget::KigWidget(KigPart *part, KigView *view, QWidget *parent, bool fullscr
     , misfullscreen(fullscreen)
     , mispainting(false)
     , malreadyresized(false)
+    , mculledobjects(0)
 {
     part->addWidget(this);
 
@@ -52,14 +56,16 @@ KigWidget::~KigWidget()
 
 void KigWidget::paintEvent(QPaintEvent *e)
 {
+    Tracer::Span span("KigWidget::paintEvent", "paint");
     mispainting = true;
-    std::vector<QRect> overlay;
-    overlay.push_back(e->rect());
+    const QRegion &region = e->region();
+    std::vector<QRect> overlay(region.begin(), region.end());
     updateWidget(overlay);
 }
 
 void KigWidget::mousePressEvent(QMouseEvent *e)
 {
+    Tracer::Span span("KigWidget::mousePressEvent", "input");
     if (e->button() & Qt::LeftButton)
         return mpart->mode()->leftClicked(e, this);
     if (e->button() & Qt::MiddleButton)
@@ -70,6 +76,7 @@ void KigWidget::mousePressEvent(QMouseEvent *e)
 
 void KigWidget::mouseMoveEvent(QMouseEvent *e)
 {
+    Tracer::Span span("KigWidget::mouseMoveEvent", "input");
     if ((e->buttons() & Qt::LeftButton) == Qt::LeftButton)
         return mpart->mode()->leftMouseMoved(e, this);
     if ((e->buttons() & Qt::MiddleButton) == Qt::MidButton)
@@ -81,6 +88,7 @@ void KigWidget::mouseMoveEvent(QMouseEvent *e)
 
 void KigWidget::mouseReleaseEvent(QMouseEvent *e)
 {
+    Tracer::Span span("KigWidget::mouseReleaseEvent", "input");
     if (e->button() & Qt::LeftButton)
         return mpart->mode()->leftReleased(e, this);
     if (e->button() & Qt::MiddleButton)
@@ -89,33 +97,63 @@ void KigWidget::mouseReleaseEvent(QMouseEvent *e)
         return mpart->mode()->rightReleased(e, this);
 }
 
+// An overlay easily consists of a few hundred small rects ( e.g. for a
+// curve ).  Uniting all of them in a QRegion is slow, and blitting them
+// one by one is not faster than blitting a slightly larger area, so if
+// there are many of them, we first snap them to a grid of
+// damageCellSize pixels.  If the resulting region is still very
+// fragmented, or covers most of its bounding rect anyway, we just use
+// that bounding rect.
+static const uint maxDamageRects = 32;
+static const int damageCellSize = 32;
+
+static QRegion damageRegion(const std::vector<QRect> &a, const std::vector<QRect> &b, const QRect &bounds)
+{
+    const bool snap = a.size() + b.size() > maxDamageRects;
+    QRegion ret;
+    const std::vector<QRect> *lists[] = {&a, &b};
+    for (uint l = 0; l < 2; ++l) {
+        for (std::vector<QRect>::const_iterator i = lists[l]->begin(); i != lists[l]->end(); ++i) {
+            QRect r = i->normalized() & bounds;
+            if (r.isEmpty())
+                continue;
+            if (snap) {
+                const QPoint tl((r.left() / damageCellSize) * damageCellSize, (r.top() / damageCellSize) * damageCellSize);
+                const QPoint br((r.right() / damageCellSize + 1) * damageCellSize - 1, (r.bottom() / damageCellSize + 1) * damageCellSize - 1);
+                r = QRect(tl, br) & bounds;
+            }
+            ret += r;
+        }
+    }
+
+    const QRect br = ret.boundingRect();
+    if (static_cast<uint>(ret.rectCount()) > maxDamageRects)
+        return br;
+    qint64 area = 0;
+    for (QRegion::const_iterator i = ret.begin(); i != ret.end(); ++i)
+        area += static_cast<qint64>(i->width()) * i->height();
+    if (4 * area > 3 * static_cast<qint64>(br.width()) * br.height())
+        return br;
+    return ret;
+}
+
 void KigWidget::updateWidget(const std::vector<QRect> &overlay)
 {
+    Tracer::Span span("KigWidget::updateWidget", "paint");
     if (!mispainting) {
-        QRect r;
-        int rectinited = false;
-        for (std::vector<QRect>::const_iterator i = oldOverlay.begin(); i != oldOverlay.end(); ++i)
-            if (rectinited)
-                r |= *i;
-            else {
-                r = *i;
-                rectinited = true;
-            }
-        for (std::vector<QRect>::const_iterator i = overlay.begin(); i != overlay.end(); ++i)
-            if (rectinited)
-                r |= *i;
-            else {
-                r = *i;
-                rectinited = true;
-            }
-        repaint(r);
+        // only the parts of the widget that were drawn upon before, and
+        // the ones that are drawn upon now, need to be repainted..
+        const QRegion damage = damageRegion(oldOverlay, overlay, rect());
+        if (!damage.isEmpty())
+            repaint(damage);
         return;
     }
 
     oldOverlay = overlay;
 
     QPainter p(this);
-    p.drawPixmap(overlay.front().topLeft(), curPix, overlay.front());
+    for (std::vector<QRect>::const_iterator i = overlay.begin(); i != overlay.end(); ++i)
+        p.drawPixmap(i->topLeft(), curPix, *i);
     p.end();
     mispainting = false;
 }
@@ -157,17 +195,17 @@ void KigWidget::resizeEvent(QResizeEvent *e)
 
 void KigWidget::updateCurPix(const std::vector<QRect> &ol)
 {
-    // we make curPix look like stillPix again...
+    // we make curPix look like stillPix again, but only where it was
+    // drawn upon...
+    const QRegion damage = damageRegion(oldOverlay, ol, curPix.rect());
     QPainter p(&curPix);
-    for (std::vector<QRect>::const_iterator i = oldOverlay.begin(); i != oldOverlay.end(); ++i)
-        p.drawPixmap(i->topLeft(), stillPix, *i);
-    for (std::vector<QRect>::const_iterator i = ol.begin(); i != ol.end(); ++i)
+    for (QRegion::const_iterator i = damage.begin(); i != damage.end(); ++i)
         p.drawPixmap(i->topLeft(), stillPix, *i);
     p.end();
 
-    // we add ol to oldOverlay, so that part of the widget will be
-    // updated too in updateWidget...
-    std::copy(ol.begin(), ol.end(), std::back_inserter(oldOverlay));
+    // the damaged region becomes oldOverlay, so that part of the widget
+    // will be updated too in updateWidget...
+    oldOverlay.assign(damage.begin(), damage.end());
 }
 
 void KigWidget::recenterScreen()
@@ -218,6 +256,7 @@ void KigWidget::clearStillPix()
 
 void KigWidget::redrawScreen(const std::vector<ObjectHolder *> &_selection, bool dos)
 {
+    Tracer::Span span("KigWidget::redrawScreen", "paint");
     std::vector<ObjectHolder *> nonselection;
     std::vector<ObjectHolder *> selection = _selection;
     std::set<ObjectHolder *> objs = mpart->document().objectsSet();
@@ -230,11 +269,19 @@ void KigWidget::redrawScreen(const std::vector<ObjectHolder *> &_selection, bool
     p.drawGrid(mpart->document().coordinateSystem(), mpart->document().grid(), mpart->document().axes());
     p.drawObjects(selection, true);
     p.drawObjects(nonselection, false);
+    mculledobjects = p.culledObjects();
+    if (Profiler::enabled())
+        Profiler::instance()->recordRedraw(culledObjects());
     updateCurPix(p.overlay());
     if (dos)
         updateEntireWidget();
 }
 
+int KigWidget::culledObjects() const
+{
+    return mculledobjects;
+}
+
 const ScreenInfo &KigWidget::screenInfo() const
 {
     return msi;
@@ -86,6 +86,9 @@ protected:
 
     bool malreadyresized;
 
+    // the number of objects the last redrawScreen() did not draw..
+    int mculledobjects;
+
 public:
     /**
      * standard qwidget constructor.  if fullscreen is true, we're a
@@ -201,6 +204,12 @@ public:
     void zoomArea();
 
     void redrawScreen(const std::vector<ObjectHolder *> &selection, bool paintOnWidget = true);
+
+    /**
+     * The number of objects that the last redrawScreen() skipped,
+     * because they were entirely outside of the shown rect.
+     */
+    int culledObjects() const;
 };
 
 /**
@@ -25,18 +25,58 @@
 #include "aboutdata.h"
 #include <KLocalizedString>
 
-static int convertToNative(const QUrl &file, const QByteArray &outfile)
+// looks up the function \p name that the kig part exports..
+static QFunctionPointer resolvePartFunction(const char *name)
 {
     KPluginLoader libraryLoader(QStringLiteral("kf" QT_STRINGIFY(QT_VERSION_MAJOR)) + QStringLiteral("/parts/kigpart"));
     QLibrary library(libraryLoader.fileName());
+    return library.resolve(name);
+}
+
+static int convertToNative(const QUrl &file, const QByteArray &outfile)
+{
     int (*converterfunction)(const QUrl &, const QByteArray &);
-    converterfunction = (int (*)(const QUrl &, const QByteArray &))library.resolve("convertToNative");
+    converterfunction = (int (*)(const QUrl &, const QByteArray &))resolvePartFunction("convertToNative");
     if (!converterfunction) {
         qCritical() << "Error: broken Kig installation: different library and application version !";
         return -1;
     }
     return (*converterfunction)(file, outfile);
 }
+
+static int runScriptWorker()
+{
+    int (*workerfunction)();
+    workerfunction = (int (*)())resolvePartFunction("runScriptWorker");
+    if (!workerfunction) {
+        qCritical() << "Error: this Kig installation was built without Python scripting support.";
+        return -1;
+    }
+    return (*workerfunction)();
+}
+
+static void enableProfiler()
+{
+    void (*enablefunction)();
+    enablefunction = (void (*)())resolvePartFunction("enableProfiler");
+    if (!enablefunction) {
+        qCritical() << "Error: broken Kig installation: different library and application version !";
+        return;
+    }
+    (*enablefunction)();
+}
+
+static void enableTracer(const QString &file)
+{
+    void (*enablefunction)(const QString &);
+    enablefunction = (void (*)(const QString &))resolvePartFunction("enableTracer");
+    if (!enablefunction) {
+        qCritical() << "Error: broken Kig installation: different library and application version !";
+        return;
+    }
+    (*enablefunction)(file);
+}
+
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 static bool configMigration()
 {
@@ -85,6 +125,15 @@ int main(int argc, char **argv)
     QCommandLineOption outfileOption(QStringList() << QStringLiteral("o") << QStringLiteral("outfile"),
                                      i18n("File to output the created native file to. '-' means output to stdout. Default is stdout as well."),
                                      QStringLiteral("file"));
+    // used internally to run Python scripts out of process, see
+    // ScriptWorkerPool
+    QCommandLineOption scriptWorkerOption(QStringLiteral("script-worker"), i18n("Run as a Python script worker process."));
+    scriptWorkerOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    QCommandLineOption profileOption(QStringLiteral("profile"),
+                                     i18n("Measure the time spent calculating and drawing each object, and print the slowest ones when a document is closed."));
+    QCommandLineOption traceOption(QStringLiteral("trace"),
+                                   i18n("Write a trace of input handling, calculation, drawing and file access to a file, in the Chrome trace event format."),
+                                   QStringLiteral("file"));
 
     QCoreApplication::setApplicationName(QStringLiteral("kig"));
     QCoreApplication::setApplicationVersion(KIG_VERSION_STRING);
@@ -95,13 +144,18 @@ int main(int argc, char **argv)
     about.setupCommandLine(&parser);
     parser.addOption(convertToNativeOption);
     parser.addOption(outfileOption);
+    parser.addOption(scriptWorkerOption);
+    parser.addOption(profileOption);
+    parser.addOption(traceOption);
     parser.addPositionalArgument(QStringLiteral("URL"), i18n("Document to open"));
     parser.process(app);
     about.processCommandLine(&parser);
 
     QStringList urls = parser.positionalArguments();
 
-    if (parser.isSet(QStringLiteral("convert-to-native"))) {
+    if (parser.isSet(QStringLiteral("script-worker"))) {
+        return runScriptWorker();
+    } else if (parser.isSet(QStringLiteral("convert-to-native"))) {
         QString outfile = parser.value(QStringLiteral("outfile"));
         if (outfile.isNull())
             outfile = '-';
@@ -125,6 +179,11 @@ int main(int argc, char **argv)
             kRestoreMainWindows<Kig>();
         }
 
+        if (parser.isSet(QStringLiteral("profile")))
+            enableProfiler();
+        if (parser.isSet(QStringLiteral("trace")))
+            enableTracer(parser.value(QStringLiteral("trace")));
+
         Kig *widget = new Kig;
         widget->show();
 
@@ -129,6 +129,20 @@ ArgsParser ArgsParser::without(const ObjectImpType *type) const
     return ArgsParser(ret);
 }
 
+std::vector<const ObjectImpType *> ArgsParser::argumentTypes() const
+{
+    std::vector<const ObjectImpType *> ret;
+    ret.reserve(margs.size());
+    for (uint i = 0; i < margs.size(); ++i)
+        ret.push_back(margs[i].type);
+    return ret;
+}
+
+const std::vector<ArgsParser::spec> &ArgsParser::specs() const
+{
+    return margs;
+}
+
 ArgsParser::spec ArgsParser::findSpec(const ObjectImp *obj, const Args &parents) const
 {
     spec ret;
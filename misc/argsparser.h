@@ -125,6 +125,10 @@ public:
      * ones of the given type.
      */
     ArgsParser without(const ObjectImpType *type) const;
+    // the types of the arguments this parser wants, in order.
+    std::vector<const ObjectImpType *> argumentTypes() const;
+    // the full argument spec this parser was initialized with.
+    const std::vector<spec> &specs() const;
     // checks if os matches the argument list this parser should parse.
     int check(const Args &os) const;
     int check(const std::vector<ObjectCalcer *> &os) const;
@@ -4,10 +4,18 @@
 
 #include "calcpaths.h"
 
+#include "tracer.h"
+
 #include "../objects/object_calcer.h"
 #include "../objects/object_imp.h"
+#include "../objects/object_type.h"
+
+#include <QThreadPool>
 
 #include <algorithm>
+#include <functional>
+#include <map>
+#include <unordered_map>
 
 // mp:
 // The previous algorithm by Dominique had an exponential complexity
@@ -273,3 +281,103 @@ bool isPointOnCurve(const ObjectCalcer *point, const ObjectCalcer *curve)
 {
     return point->isDefinedOnOrThrough(curve) || curve->isDefinedOnOrThrough(point);
 }
+
+// below these sizes, starting threads costs more than it gains..
+static const uint minParallelPath = 256;
+static const uint minParallelLevel = 32;
+
+// the type of \p o if it is calculated with ObjectType::calcMany(),
+// and 0 otherwise..
+static const ObjectType *calcManyType(const ObjectCalcer *o)
+{
+    const ObjectTypeCalcer *t = dynamic_cast<const ObjectTypeCalcer *>(o);
+    return t && t->type()->hasCalcMany() ? t->type() : nullptr;
+}
+
+typedef std::map<const ObjectType *, std::vector<ObjectTypeCalcer *>> CalcManyGroups;
+
+// moves the objects of \p level that calcManyType() returns a type for
+// to \p groups..
+static void takeCalcMany(std::vector<ObjectCalcer *> &level, CalcManyGroups &groups)
+{
+    groups.clear();
+    std::vector<ObjectCalcer *>::iterator rest = level.begin();
+    for (std::vector<ObjectCalcer *>::iterator i = level.begin(); i != level.end(); ++i) {
+        if (const ObjectType *type = calcManyType(*i))
+            groups[type].push_back(static_cast<ObjectTypeCalcer *>(*i));
+        else
+            *rest++ = *i;
+    }
+    level.erase(rest, level.end());
+}
+
+void calcAll(const std::vector<ObjectCalcer *> &path, const KigDocument &doc)
+{
+    Tracer::Span span("calcAll", "calc");
+    if (path.size() < minParallelPath && std::count_if(path.begin(), path.end(), calcManyType) < 2) {
+        for (std::vector<ObjectCalcer *>::const_iterator i = path.begin(); i != path.end(); ++i)
+            (*i)->calc(doc);
+        return;
+    }
+
+    // the level of an object is one more than the highest level of its
+    // parents in path.  Parents that are not in path are already
+    // calc'ed, and don't count.
+    std::unordered_map<const ObjectCalcer *, uint> levelof;
+    levelof.reserve(path.size());
+    std::vector<std::vector<ObjectCalcer *>> levels;
+    for (std::vector<ObjectCalcer *>::const_iterator i = path.begin(); i != path.end(); ++i) {
+        uint level = 0;
+        const std::vector<ObjectCalcer *> parents = (*i)->parents();
+        for (std::vector<ObjectCalcer *>::const_iterator j = parents.begin(); j != parents.end(); ++j) {
+            std::unordered_map<const ObjectCalcer *, uint>::const_iterator p = levelof.find(*j);
+            if (p != levelof.end())
+                level = std::max(level, p->second + 1);
+        }
+        levelof[*i] = level;
+        if (levels.size() <= level)
+            levels.resize(level + 1);
+        levels[level].push_back(*i);
+    }
+
+    QThreadPool pool;
+    const uint nthreads = std::max(1, pool.maxThreadCount());
+    std::vector<ObjectCalcer *> unsafe;
+    CalcManyGroups groups;
+    for (std::vector<std::vector<ObjectCalcer *>>::iterator l = levels.begin(); l != levels.end(); ++l) {
+        std::vector<ObjectCalcer *> &level = *l;
+        // e.g. the script objects, which go to the script worker
+        // processes together..
+        takeCalcMany(level, groups);
+        if (level.size() < minParallelLevel || nthreads == 1) {
+            for (std::vector<ObjectCalcer *>::iterator i = level.begin(); i != level.end(); ++i)
+                (*i)->calc(doc);
+            for (CalcManyGroups::const_iterator i = groups.begin(); i != groups.end(); ++i)
+                ObjectTypeCalcer::calcMany(i->second, doc);
+            continue;
+        }
+
+        unsafe.clear();
+        std::vector<ObjectCalcer *>::iterator safeend =
+            std::stable_partition(level.begin(), level.end(), std::mem_fn(&ObjectCalcer::isThreadSafe));
+        unsafe.assign(safeend, level.end());
+        level.erase(safeend, level.end());
+
+        // every thread gets a contiguous part of the level
+        const uint chunk = (level.size() + nthreads - 1) / nthreads;
+        for (uint begin = 0; begin < level.size(); begin += chunk) {
+            const uint end = std::min<uint>(begin + chunk, level.size());
+            pool.start([&level, &doc, begin, end]() {
+                for (uint i = begin; i < end; ++i)
+                    level[i]->calc(doc);
+            });
+        }
+        // the objects that can't be calc'ed concurrently don't depend
+        // on the others in this level, so we do them meanwhile..
+        for (CalcManyGroups::const_iterator i = groups.begin(); i != groups.end(); ++i)
+            ObjectTypeCalcer::calcMany(i->second, doc);
+        for (std::vector<ObjectCalcer *>::iterator i = unsafe.begin(); i != unsafe.end(); ++i)
+            (*i)->calc(doc);
+        pool.waitForDone();
+    }
+}
@@ -24,6 +24,20 @@ std::vector<ObjectCalcer *> calcPath(const std::vector<ObjectCalcer *> &os);
  */
 std::vector<ObjectCalcer *> calcPath(const std::vector<ObjectCalcer *> &from, const ObjectCalcer *to);
 
+/**
+ * This calc()'s all objects in \p path, which should be ordered like
+ * the result of calcPath(), against \p doc.  Objects that don't depend
+ * on each other are calc'ed concurrently: \p path is split into
+ * levels, so that every object only depends on objects in earlier
+ * levels, and the objects of a level are divided over a number of
+ * threads.  Objects for which ObjectCalcer::isThreadSafe() returns
+ * false are calc'ed on the calling thread, and so are those whose type
+ * has ObjectType::hasCalcMany(), with one ObjectType::calcMany() call
+ * per type and level.  Short paths without such objects are simply
+ * calc'ed one by one.
+ */
+void calcAll(const std::vector<ObjectCalcer *> &path, const KigDocument &doc);
+
 /**
  * This function returns all objects on the side of the path through
  * the dependency tree from \p from down to \p to . This means that we
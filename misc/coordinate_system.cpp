@@ -15,8 +15,10 @@
 #include "goniometry.h"
 #include "kigpainter.h"
 
+#include <algorithm>
 #include <cmath>
 #include <string>
+#include <vector>
 
 #include <QDoubleValidator>
 #include <QRegExp>
@@ -180,6 +182,9 @@ Coordinate EuclideanCoords::toScreen(const QString &s, bool &ok) const
     return Coordinate();
 }
 
+// the maximum number of circles in the polar grid..
+static const double maxGridCircles = 200;
+
 /**
  * copied and adapted from a ( public domain ) function i found in the
  * first Graphics Gems book.  Credits to Paul S. Heckbert, who wrote
@@ -216,7 +221,10 @@ static double nicenum(double x, bool round)
 
 void EuclideanCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
 {
-    p.setWholeWinOverlay();
+    // the grid lines cover the entire window anyway, the axes and their
+    // numbers get their own overlay..
+    if (showgrid)
+        p.setWholeWinOverlay();
 
     // this instruction in not necessary, but there is a little
     // optimization when there are no grid and no axes.
@@ -227,10 +235,11 @@ void EuclideanCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) cons
     // first Graphics Gems book.  Credits to Paul S. Heckbert, who wrote
     // the "Nice number for graph labels" gem.
 
-    const double hmax = ceil(p.window().right());
-    const double hmin = floor(p.window().left());
-    const double vmax = ceil(p.window().top());
-    const double vmin = floor(p.window().bottom());
+    const Rect gridwindow = p.gridWindow();
+    const double hmax = ceil(gridwindow.right());
+    const double hmin = floor(gridwindow.left());
+    const double vmax = ceil(gridwindow.top());
+    const double vmin = floor(gridwindow.bottom());
 
     // the number of intervals we would like to have:
     // we try to have one of them per 40 pixels or so..
@@ -407,8 +416,6 @@ Coordinate PolarCoords::toScreen(const QString &s, bool &ok) const
 
 void PolarCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
 {
-    p.setWholeWinOverlay();
-
     // this instruction in not necessary, but there is a little
     // optimization when there are no grid and no axes.
     if (!(showgrid || showaxes))
@@ -418,10 +425,11 @@ void PolarCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
     // the corners, that intersect with the axes outside of the
     // screen..
 
-    const double hmax = M_SQRT2 * p.window().right();
-    const double hmin = M_SQRT2 * p.window().left();
-    const double vmax = M_SQRT2 * p.window().top();
-    const double vmin = M_SQRT2 * p.window().bottom();
+    const Rect gridwindow = p.gridWindow();
+    const double hmax = M_SQRT2 * gridwindow.right();
+    const double hmin = M_SQRT2 * gridwindow.left();
+    const double vmax = M_SQRT2 * gridwindow.top();
+    const double vmin = M_SQRT2 * gridwindow.bottom();
 
     // the intervals:
     // we try to have one of them per 40 pixels or so..
@@ -444,18 +452,30 @@ void PolarCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
 
     /****** the grid lines ******/
     if (showgrid) {
+        // only the circles that cross the window are drawn: their radii
+        // lie between the distance from the origin to the window and the
+        // distance to its farthest corner.  This way, the number of
+        // circles depends on the size of the window, and not on its
+        // distance to the origin..
+        const Rect window = p.window();
+        const double dx = kigMax(0., kigMax(window.left(), -window.right()));
+        const double dy = kigMax(0., kigMax(window.bottom(), -window.top()));
+        const double rmin = std::hypot(dx, dy);
+        const double rmax = std::hypot(kigMax(kigAbs(window.left()), kigAbs(window.right())), kigMax(kigAbs(window.bottom()), kigAbs(window.top())));
+
+        // if that would still be too many circles ( e.g. for a window
+        // that is long and narrow ), we thin them out..
         double d = kigMin(hd, vd);
-        double begin = kigMin(kigAbs(hgraphmin), kigAbs(vgraphmin));
-        if (kigSgn(hgraphmin) != kigSgn(hgraphmax) && kigSgn(vgraphmin) != kigSgn(vgraphmax))
-            begin = d;
-        double end = kigMax(hgraphmax, vgraphmax);
+        while ((rmax - rmin) / d > maxGridCircles)
+            d = nicenum(2 * d, true);
 
-        // we also want the circles that don't fit entirely in the
-        // screen..
         Coordinate c(0, 0);
         p.setPen(QPen(Qt::lightGray, 0, Qt::DotLine));
-        for (double i = begin; i <= end + d / 2; i += d)
-            drawGridLine(p, c, fabs(i));
+        // we count in multiples of d, to not accumulate rounding errors
+        // far away from the origin..
+        const double last = floor(rmax / d);
+        for (double i = kigMax(1., ceil(rmin / d)); i <= last; ++i)
+            drawGridLine(p, c, i * d);
     }
 
     /****** the axes ******/
@@ -653,65 +673,68 @@ Coordinate PolarCoords::snapToGrid(const Coordinate &c, const KigWidget &w) cons
 
 void PolarCoords::drawGridLine(KigPainter &p, const Coordinate &c, double r) const
 {
-#ifdef KIG_TESSELLATE_POLAR_GRID_CIRCLE
-    Rect rect = p.window();
-
-    struct iterdata_t {
-        int xd;
-        int yd;
-        Coordinate (Rect::*point)() const;
-        Coordinate (Rect::*oppositepoint)() const;
-        double horizAngle;
-        double vertAngle;
-    };
-
-    static const iterdata_t iterdata[] = {{+1, +1, &Rect::topRight, &Rect::bottomLeft, 0, M_PI / 2},
-                                          {-1, +1, &Rect::topLeft, &Rect::bottomRight, M_PI, M_PI / 2},
-                                          {-1, -1, &Rect::bottomLeft, &Rect::topRight, M_PI, 3 * M_PI / 2},
-                                          {+1, -1, &Rect::bottomRight, &Rect::topLeft, 2 * M_PI, 3 * M_PI / 2}};
-    for (int i = 0; i < 4; ++i) {
-        int xd = iterdata[i].xd;
-        int yd = iterdata[i].yd;
-        Coordinate point = (rect.*iterdata[i].point)();
-        Coordinate opppoint = (rect.*iterdata[i].oppositepoint)();
-        double horizangle = iterdata[i].horizAngle;
-        double vertangle = iterdata[i].vertAngle;
-
-        if ((c.x - point.x) * xd > 0 || (c.y - point.y) * yd > 0)
-            continue;
-        if ((c.x - opppoint.x) * -xd > r || (c.y - opppoint.y) * -yd > r)
-            continue;
-
-        int posdir = xd * yd;
-        double hd = (point.x - c.x) * xd;
-        assert(hd >= 0);
-        if (hd < r) {
-            double anglediff = acos(hd / r);
-            horizangle += posdir * anglediff;
+    // we only draw the parts of the circle that lie inside the window.
+    // They are drawn as polylines, since the arcs of QPainter are not
+    // precise enough for circles that are a lot bigger than the
+    // window..
+    const Rect window = p.window();
+
+    // the angles at which the circle crosses the borders of the window..
+    std::vector<double> angles;
+    const double xs[] = {window.left(), window.right()};
+    for (int i = 0; i < 2; ++i) {
+        const double x = (xs[i] - c.x) / r;
+        if (fabs(x) <= 1) {
+            angles.push_back(acos(x));
+            angles.push_back(2 * M_PI - acos(x));
         }
-
-        hd = (c.x - opppoint.x) * -xd;
-        if (hd >= 0) {
-            double anglediff = asin(hd / r);
-            vertangle -= posdir * anglediff;
+    }
+    const double ys[] = {window.bottom(), window.top()};
+    for (int i = 0; i < 2; ++i) {
+        const double y = (ys[i] - c.y) / r;
+        if (fabs(y) <= 1) {
+            angles.push_back(asin(y));
+            angles.push_back(M_PI - asin(y));
         }
+    }
+    for (std::vector<double>::iterator i = angles.begin(); i != angles.end(); ++i)
+        if (*i < 0)
+            *i += 2 * M_PI;
+    std::sort(angles.begin(), angles.end());
+
+    if (angles.empty()) {
+        // the circle lies either entirely inside or entirely outside the
+        // window..
+        if (window.contains(c + Coordinate(r, 0)))
+            drawGridArc(p, c, r, 0, 2 * M_PI);
+        return;
+    }
 
-        double vd = (point.y - c.y) * yd;
-        assert(vd >= 0);
-        if (vd < r) {
-            double anglediff = acos(vd / r);
-            vertangle -= posdir * anglediff;
-        }
+    // between two crossings, the circle is either entirely inside or
+    // entirely outside the window..
+    for (uint i = 0; i < angles.size(); ++i) {
+        const double begin = angles[i];
+        const double end = i + 1 < angles.size() ? angles[i + 1] : angles[0] + 2 * M_PI;
+        const double middle = (begin + end) / 2;
+        if (end - begin > 1e-12 && window.contains(c + r * Coordinate(cos(middle), sin(middle))))
+            drawGridArc(p, c, r, begin, end);
+    }
+}
 
-        vd = (c.y - opppoint.y) * -xd;
-        if (vd >= 0) {
-            double anglediff = asin(hd / r);
-            horizangle += posdir * anglediff;
-        }
+void PolarCoords::drawGridArc(KigPainter &p, const Coordinate &c, double r, double begin, double end) const
+{
+    // we choose the step so that the polyline is never more than about
+    // half a pixel away from the arc..
+    const double rpixels = r / p.pixelWidth();
+    const double step = kigMin(M_PI / 32, 2 / sqrt(rpixels));
+    const int n = kigMin(static_cast<int>(ceil((end - begin) / step)), 10000);
 
-        p.drawArc(c, r, kigMin(horizangle, vertangle), kigMax(horizangle, vertangle));
+    // one polyline, so that the dots of the pen run on along the arc..
+    std::vector<Coordinate> pts;
+    pts.reserve(n + 1);
+    for (int i = 0; i <= n; ++i) {
+        const double a = begin + (end - begin) * i / n;
+        pts.push_back(c + r * Coordinate(cos(a), sin(a)));
     }
-#else
-    p.drawCircle(c, r);
-#endif
+    p.drawPolyline(pts);
 }
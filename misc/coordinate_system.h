@@ -92,6 +92,7 @@ public:
 class PolarCoords : public CoordinateSystem
 {
     void drawGridLine(KigPainter &p, const Coordinate &center, double radius) const;
+    void drawGridArc(KigPainter &p, const Coordinate &center, double radius, double begin, double end) const;
 
 public:
     PolarCoords();
@@ -0,0 +1,227 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "curve_sampler.h"
+
+#include "../objects/curve_imp.h"
+#include "rect.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stack>
+#include <utility>
+
+namespace
+{
+struct Sample {
+    double t;
+    Coordinate p;
+};
+
+struct Interval {
+    Sample a;
+    Sample b;
+};
+}
+
+std::vector<std::vector<Coordinate>> sampleCurve(const CurveImp *curve, const KigDocument &doc, const Rect &window, double tolerance, int maxpoints)
+{
+    // distance between two parameter values cannot be too small
+    static const double hmin = 3e-5;
+    // distance between two parameter values cannot be too large
+    static const double hmax = 1. / 40;
+
+    std::vector<std::vector<Coordinate>> ret;
+    const double tolerancesq = tolerance * tolerance;
+
+    // we don't use recursion, but a stack based approach.  The left
+    // half of an interval is always processed before its right half,
+    // so the accepted intervals come out in order.
+    std::stack<Interval> workstack;
+    Interval first = {{0., curve->getPoint(0., doc)}, {1., curve->getPoint(1., doc)}};
+    workstack.push(first);
+    int count = 2;
+    // the end of the last interval we accepted
+    double lastt = -1.;
+
+    while (!workstack.empty() && count++ < maxpoints) {
+        const Interval cur = workstack.top();
+        workstack.pop();
+
+        const double t2 = (cur.a.t + cur.b.t) / 2;
+        const double h = (cur.b.t - cur.a.t) / 2;
+        const Coordinate p2 = curve->getPoint(t2, doc);
+        const bool valid0 = cur.a.p.valid();
+        const bool valid1 = cur.b.p.valid();
+        const bool allvalid = p2.valid() && valid0 && valid1;
+
+        if (allvalid && h < hmax && (0.5 * cur.a.p + 0.5 * cur.b.p - p2).squareLength() < tolerancesq) {
+            if (ret.empty() || cur.a.t != lastt)
+                ret.push_back(std::vector<Coordinate>(1, cur.a.p));
+            ret.back().push_back(p2);
+            ret.back().push_back(cur.b.p);
+            lastt = cur.b.t;
+        } else if (h >= hmin) // we do not continue to subdivide indefinitely!
+        {
+            const bool addn = window.contains(p2) || h >= hmax;
+            const Sample mid = {t2, p2};
+            if (addn || (valid1 && window.contains(cur.b.p))) {
+                Interval right = {mid, cur.b};
+                workstack.push(right);
+            }
+            if (addn || (valid0 && window.contains(cur.a.p))) {
+                Interval left = {cur.a, mid};
+                workstack.push(left);
+            }
+        }
+    }
+
+    // if we ran out of points, we don't drop the rest of the curve, but
+    // finish it coarsely: the intervals that are left are cut into
+    // pieces of at most hmax, which are used as they are.  The intervals
+    // left together span at most the whole parameter range, so this
+    // costs about 1 / hmax more points..
+    const double windowsize = std::max(window.width(), window.height());
+    while (!workstack.empty()) {
+        const Interval cur = workstack.top();
+        workstack.pop();
+        const int n = static_cast<int>(std::ceil((cur.b.t - cur.a.t) / hmax));
+        Sample prev = cur.a;
+        for (int i = 1; i <= n; ++i) {
+            Sample next = cur.b;
+            if (i < n) {
+                next.t = cur.a.t + (cur.b.t - cur.a.t) * i / n;
+                next.p = curve->getPoint(next.t, doc);
+            }
+            // we still must not join the two sides of a jump, like the
+            // branches of a hyperbola.  A piece longer than the window
+            // whose middle is farther from the middle of its chord than
+            // half its length is taken to be one..
+            bool jump = !prev.p.valid() || !next.p.valid();
+            const double length = jump ? 0. : (next.p - prev.p).length();
+            if (length > windowsize) {
+                const Coordinate mid = curve->getPoint((prev.t + next.t) / 2, doc);
+                jump = !mid.valid() || (0.5 * prev.p + 0.5 * next.p - mid).length() > length / 2;
+            }
+            if (!jump) {
+                if (ret.empty() || prev.t != lastt)
+                    ret.push_back(std::vector<Coordinate>(1, prev.p));
+                ret.back().push_back(next.p);
+                lastt = next.t;
+            }
+            prev = next;
+        }
+    }
+
+    std::vector<std::vector<Coordinate>>::iterator out = ret.begin();
+    for (std::vector<std::vector<Coordinate>>::iterator i = ret.begin(); i != ret.end(); ++i) {
+        simplifyPolyline(*i, tolerance / 2);
+        if (i->size() > 1)
+            std::swap(*out++, *i);
+    }
+    ret.erase(out, ret.end());
+    return ret;
+}
+
+// cuts the segment from a to b down to the part in r ( the
+// Liang-Barsky algorithm ), returns false if nothing of it is in r..
+static bool clipSegment(Coordinate &a, Coordinate &b, const Rect &r)
+{
+    const Coordinate d = b - a;
+    const double p[4] = {-d.x, d.x, -d.y, d.y};
+    const double q[4] = {a.x - r.left(), r.right() - a.x, a.y - r.bottom(), r.top() - a.y};
+    double t0 = 0.;
+    double t1 = 1.;
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0.) {
+            if (q[i] < 0.)
+                return false;
+            continue;
+        }
+        const double t = q[i] / p[i];
+        if (p[i] < 0.) {
+            if (t > t1)
+                return false;
+            t0 = std::max(t0, t);
+        } else {
+            if (t < t0)
+                return false;
+            t1 = std::min(t1, t);
+        }
+    }
+    const Coordinate start = a + t0 * d;
+    b = a + t1 * d;
+    a = start;
+    return true;
+}
+
+std::vector<std::vector<Coordinate>> clipPolylines(const std::vector<std::vector<Coordinate>> &polylines, const Rect &window)
+{
+    std::vector<std::vector<Coordinate>> ret;
+    for (std::vector<std::vector<Coordinate>>::const_iterator i = polylines.begin(); i != polylines.end(); ++i) {
+        // whether ret.back() ends where the next segment starts
+        bool open = false;
+        for (uint j = 1; j < i->size(); ++j) {
+            Coordinate a = (*i)[j - 1];
+            Coordinate b = (*i)[j];
+            if (!clipSegment(a, b, window)) {
+                open = false;
+                continue;
+            }
+            if (!open || !(a == (*i)[j - 1]))
+                ret.push_back(std::vector<Coordinate>(1, a));
+            ret.back().push_back(b);
+            open = b == (*i)[j];
+        }
+    }
+    return ret;
+}
+
+// the distance from p to the segment [a,b]
+static double distanceToSegment(const Coordinate &p, const Coordinate &a, const Coordinate &b)
+{
+    const Coordinate ab = b - a;
+    const double lensq = ab.squareLength();
+    if (lensq == 0.)
+        return (p - a).length();
+    double u = ((p - a) * ab) / lensq;
+    u = u < 0. ? 0. : (u > 1. ? 1. : u);
+    return (p - (a + u * ab)).length();
+}
+
+void simplifyPolyline(std::vector<Coordinate> &points, double tolerance)
+{
+    if (points.size() < 3)
+        return;
+    std::vector<bool> keep(points.size(), false);
+    keep.front() = true;
+    keep.back() = true;
+
+    std::stack<std::pair<uint, uint>> workstack;
+    workstack.push(std::make_pair(0u, static_cast<uint>(points.size() - 1)));
+    while (!workstack.empty()) {
+        const std::pair<uint, uint> cur = workstack.top();
+        workstack.pop();
+        double maxdist = 0.;
+        uint farthest = cur.first;
+        for (uint i = cur.first + 1; i < cur.second; ++i) {
+            const double dist = distanceToSegment(points[i], points[cur.first], points[cur.second]);
+            if (dist > maxdist) {
+                maxdist = dist;
+                farthest = i;
+            }
+        }
+        if (maxdist > tolerance) {
+            keep[farthest] = true;
+            workstack.push(std::make_pair(cur.first, farthest));
+            workstack.push(std::make_pair(farthest, cur.second));
+        }
+    }
+
+    uint j = 0;
+    for (uint i = 0; i < points.size(); ++i)
+        if (keep[i])
+            points[j++] = points[i];
+    points.resize(j);
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "coordinate.h"
+
+#include <vector>
+
+class CurveImp;
+class KigDocument;
+class Rect;
+
+/**
+ * Approximates \p curve by polylines, the way both KigPainter and the
+ * exporters draw curves.  The parameter interval of the curve is
+ * subdivided until the middle of each piece lies within \p tolerance
+ * ( in document coordinates ) of the middle of its chord.  Only the
+ * parts of the curve that are in or near \p window are subdivided that
+ * finely.
+ *
+ * Points where the curve is invalid, and jumps ( pieces that don't get
+ * any smaller when they are subdivided, like the asymptotes of a
+ * hyperbola ) split the result into separate polylines.  The
+ * polylines are simplified with simplifyPolyline() before they are
+ * returned, using half of \p tolerance, so they stay within one and a
+ * half \p tolerance of the curve.
+ *
+ * Once \p maxpoints points of the curve have been calculated, the
+ * parts of the curve that are left are not subdivided any further, but
+ * finished coarsely, in pieces of a fortieth of the parameter range.
+ * Pieces that look like jumps still split the result then.
+ *
+ * Pieces of the curve that are flat enough are accepted wherever their
+ * end points are, so the result can reach far outside of \p window,
+ * see clipPolylines().
+ */
+std::vector<std::vector<Coordinate>> sampleCurve(const CurveImp *curve, const KigDocument &doc, const Rect &window, double tolerance, int maxpoints);
+
+/**
+ * Cuts off the parts of \p polylines that are outside \p window,
+ * splitting them where they leave it and come back.  The exporters use
+ * this, as e.g. TeX fails on coordinates that are too large.
+ */
+std::vector<std::vector<Coordinate>> clipPolylines(const std::vector<std::vector<Coordinate>> &polylines, const Rect &window);
+
+/**
+ * Removes the points of \p points that lie within \p tolerance of the
+ * simplified polyline ( the Douglas-Peucker algorithm ).  The first and
+ * the last point are always kept.
+ */
+void simplifyPolyline(std::vector<Coordinate> &points, double tolerance);
@@ -11,21 +11,27 @@
 #include "../kig/kig_view.h"
 #include "../misc/goniometry.h"
 #include "../objects/curve_imp.h"
+#include "../objects/line_imp.h"
+#include "../objects/object_drawer.h"
 #include "../objects/object_holder.h"
 #include "../objects/point_imp.h"
+#include "../objects/text_imp.h"
 #include "common.h"
 #include "conic-common.h"
 #include "coordinate_system.h"
 #include "cubic-common.h"
+#include "curve_sampler.h"
 #include "object_hierarchy.h"
 
+#include <QCache>
 #include <QPen>
 #include <QPolygon>
+#include <QStaticText>
+#include <QVector>
 
 #include <algorithm>
 #include <cmath>
 #include <functional>
-#include <stack>
 
 using std::cos;
 using std::fabs;
@@ -41,9 +47,16 @@ KigPainter::KigPainter(const ScreenInfo &si, QPaintDevice *device, const KigDocu
     , brushColor(Qt::blue)
     , mdoc(doc)
     , msi(si)
+    , mgridwindow(si.shownRect())
     , mNeedOverlay(no)
     , overlayenlarge(0)
     , mSelected(false)
+    , mculled(0)
+    , mbatchkind(NoBatch)
+    , mbatchwidth(-1)
+    , mbatchstyle(Qt::SolidLine)
+    , mbatchpointstyle(Kig::Round)
+    , mbatchselected(false)
 {
     mP.setBackground(QBrush(Qt::white));
 }
@@ -88,78 +101,60 @@ void KigPainter::drawSegment(const Coordinate &from, const Coordinate &to)
 }
 
 void KigPainter::drawFatPoint(const Coordinate &p)
+{
+    drawFatPoints(std::vector<Coordinate>(1, p));
+}
+
+void KigPainter::drawFatPoints(const std::vector<Coordinate> &pts)
 {
     int twidth = width == -1 ? 5 : width;
+    double radius = twidth * pixelWidth();
+    Coordinate rad(radius, radius);
+    rad /= 2;
+
+    QVector<QRect> rects;
+    rects.reserve(pts.size());
+    for (std::vector<Coordinate>::const_iterator i = pts.begin(); i != pts.end(); ++i) {
+        Rect r(*i - rad, *i + rad);
+        QRect qr = toScreen(r);
+        rects.push_back(qr);
+        if (mNeedOverlay)
+            mOverlay.push_back(qr);
+    }
+
     mP.setPen(QPen(color, 1, style));
     switch (pointstyle) {
     case Kig::Round: {
-        double radius = twidth * pixelWidth();
         setBrushStyle(Qt::SolidPattern);
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.drawEllipse(qr);
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+        for (QVector<QRect>::const_iterator i = rects.constBegin(); i != rects.constEnd(); ++i)
+            mP.drawEllipse(*i);
         break;
     }
     case Kig::RoundEmpty: {
-        double radius = twidth * pixelWidth();
         setBrushStyle(Qt::NoBrush);
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.drawEllipse(qr);
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+        for (QVector<QRect>::const_iterator i = rects.constBegin(); i != rects.constEnd(); ++i)
+            mP.drawEllipse(*i);
         break;
     }
     case Kig::Rectangular: {
-        double radius = twidth * pixelWidth();
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.drawRect(qr);
-        mP.fillRect(qr, QBrush(color, Qt::SolidPattern));
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+        mP.setBrush(QBrush(color, Qt::SolidPattern));
+        mP.drawRects(rects);
+        mP.setBrush(QBrush(brushColor, brushStyle));
         break;
     }
     case Kig::RectangularEmpty: {
-        double radius = twidth * pixelWidth();
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.drawRect(qr);
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+        mP.drawRects(rects);
         break;
     }
     case Kig::Cross: {
-        double radius = twidth * pixelWidth();
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
+        QVector<QLine> lines;
+        lines.reserve(2 * rects.size());
+        for (QVector<QRect>::const_iterator i = rects.constBegin(); i != rects.constEnd(); ++i) {
+            lines.push_back(QLine(i->topLeft(), i->bottomRight()));
+            lines.push_back(QLine(i->topRight(), i->bottomLeft()));
+        }
         mP.setPen(QPen(color, 2));
-        mP.drawLine(qr.topLeft(), qr.bottomRight());
-        mP.drawLine(qr.topRight(), qr.bottomLeft());
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+        mP.drawLines(lines);
         break;
     }
     default: {
@@ -169,6 +164,18 @@ void KigPainter::drawFatPoint(const Coordinate &p)
     mP.setPen(QPen(color, twidth, style));
 }
 
+void KigPainter::drawSegments(const std::vector<Coordinate> &pts)
+{
+    QVector<QLineF> lines;
+    lines.reserve(pts.size() / 2);
+    for (uint i = 0; i + 1 < pts.size(); i += 2) {
+        lines.push_back(QLineF(toScreenF(pts[i]), toScreenF(pts[i + 1])));
+        if (mNeedOverlay)
+            segmentOverlay(pts[i], pts[i + 1]);
+    }
+    mP.drawLines(lines);
+}
+
 void KigPainter::drawPoint(const Coordinate &p)
 {
     mP.drawPoint(toScreen(p));
@@ -209,6 +216,54 @@ const Rect KigPainter::boundingRect(const Rect &r, const QString &s, int f) cons
     return fromScreen(qr);
 }
 
+namespace
+{
+struct TextLayout {
+    QStaticText text;
+    // the size of the text in pixels
+    QSize size;
+};
+}
+
+// returns the layout of \p s in \p font, wrapped at \p width pixels,
+// or not wrapped at all if \p width is -1.
+static TextLayout cachedTextLayout(const QString &s, const QFont &font, int width)
+{
+    // QStaticText is not thread-safe, and the image exporter draws from
+    // several threads, so every thread has its own cache.
+    static thread_local QCache<QString, TextLayout> cache(2000);
+    const QString key = font.key() + QLatin1Char('\0') + QString::number(width) + QLatin1Char('\0') + s;
+    if (TextLayout *cached = cache.object(key))
+        return *cached;
+
+    TextLayout *ret = new TextLayout;
+    // QPainter::drawText() does this for us..
+    QString text = s;
+    text.replace(QLatin1Char('\n'), QChar::LineSeparator);
+    ret->text.setTextFormat(Qt::PlainText);
+    ret->text.setTextWidth(width);
+    ret->text.setText(text);
+    ret->text.prepare(QTransform(), font);
+    ret->size = ret->text.size().toSize();
+    const TextLayout layout = *ret;
+    cache.insert(key, ret);
+    return layout;
+}
+
+// returns the layout of \p s in \p font, word wrapped like
+// Qt::TextWordWrap would if there are less than \p width pixels
+// left for it.  See simpleBoundingRect().
+static TextLayout textLayout(const QString &s, const QFont &font, int width)
+{
+    // most labels fit, and their layout doesn't depend on where they
+    // are, so that we don't lay them out again while they are being
+    // dragged around..
+    const TextLayout layout = cachedTextLayout(s, font, -1);
+    if (width <= 0 || layout.size.width() <= width)
+        return layout;
+    return cachedTextLayout(s, font, width);
+}
+
 void KigPainter::setColor(const QColor &c)
 {
     color = c;
@@ -477,6 +532,37 @@ void KigPainter::unsetSelected()
     mSelected = false;
 }
 
+void KigPainter::arcOverlay(const QPointF &centre, double radius, double startangle, double angle)
+{
+    // we cut the arc in pieces of about 20 pixels long, and cover each
+    // piece by the bounding rect of its end points and the point where
+    // the tangents in those end points meet.  Huge arcs are cut in at
+    // most maxpieces pieces, which are then a bit longer..
+    const int maxpieces = 1000;
+    const double length = std::fabs(angle) * radius;
+    // pieces of more than a quarter of the circle would not be covered
+    // by the tangent construction..
+    const int minpieces = static_cast<int>(std::ceil(std::fabs(angle) / M_PI_2));
+    const int pieces = std::max(std::max(1, minpieces), std::min(maxpieces, static_cast<int>(std::ceil(length / 20))));
+    const double step = angle / pieces;
+    const double tangentradius = radius / std::cos(step / 2);
+    const QRect viewport = mP.viewport();
+
+    for (int i = 0; i < pieces; ++i) {
+        const double a = startangle + i * step;
+        const double m = a + step / 2;
+        // widget coordinates have their y axis pointing down..
+        const QPointF p0 = centre + radius * QPointF(std::cos(a), -std::sin(a));
+        const QPointF p1 = centre + radius * QPointF(std::cos(a + step), -std::sin(a + step));
+        const QPointF pm = centre + tangentradius * QPointF(std::cos(m), -std::sin(m));
+        QRectF piece(p0, p1);
+        piece = piece.normalized() | QRectF(pm, QSizeF(0, 0));
+        const QRect r = piece.toAlignedRect().adjusted(-overlayenlarge - 1, -overlayenlarge - 1, overlayenlarge + 1, overlayenlarge + 1);
+        if (r.intersects(viewport))
+            mOverlay.push_back(r);
+    }
+}
+
 void KigPainter::pointOverlay(const Coordinate &p1)
 {
     Rect r(p1, 3 * pixelWidth(), 3 * pixelWidth());
@@ -509,8 +595,8 @@ QPointF KigPainter::toScreenF(const Coordinate &p) const
 
 void KigPainter::drawGrid(const CoordinateSystem &c, bool showGrid, bool showAxes)
 {
+    // the coordinate system takes care of the overlay itself..
     c.drawGrid(*this, showGrid, showAxes);
-    setWholeWinOverlay();
 }
 
 void KigPainter::drawObject(const ObjectHolder *o, bool ss)
@@ -523,6 +609,121 @@ void KigPainter::drawObjects(const std::vector<ObjectHolder *> &os, bool sel)
     drawObjects(os.begin(), os.end(), sel);
 }
 
+// whether the line through l.a and l.b, or with \p ray the ray from
+// l.a through l.b, misses r entirely..
+static bool lineMissesRect(const LineData &l, const Rect &r, bool ray)
+{
+    const Coordinate d = l.b - l.a;
+    const Coordinate corners[] = {r.bottomLeft(), r.bottomRight(), r.topLeft(), r.topRight()};
+    int left = 0;
+    int right = 0;
+    int behind = 0;
+    for (int i = 0; i < 4; ++i) {
+        const Coordinate c = corners[i] - l.a;
+        const double cross = d.x * c.y - d.y * c.x;
+        if (cross > 0)
+            ++left;
+        else if (cross < 0)
+            ++right;
+        if (d.x * c.x + d.y * c.y < 0)
+            ++behind;
+    }
+    return left == 4 || right == 4 || (ray && behind == 4);
+}
+
+bool KigPainter::outsideWindow(const ObjectImp *imp)
+{
+    // texts are sized in pixels, and we only know the bounds of a text
+    // after it has been drawn at the current zoom level..
+    if (imp->inherits(TextImp::stype()))
+        return false;
+
+    // points, angles and the arrows of vectors are drawn with a size in
+    // pixels, so we look a bit beyond the window..
+    const double margin = cullMargin * pixelWidth();
+    const Rect w = window();
+    const Rect r(w.bottomLeft() - Coordinate(margin, margin), w.width() + 2 * margin, w.height() + 2 * margin);
+
+    // lines and rays have no bounds, but we know what they look like..
+    const bool ray = imp->inherits(RayImp::stype());
+    if (ray || imp->inherits(LineImp::stype()))
+        return lineMissesRect(static_cast<const AbstractLineImp *>(imp)->data(), r, ray);
+
+    Rect bounds = imp->surroundingRect();
+    if (!bounds.valid())
+        return false;
+    return !bounds.normalized().intersects(r);
+}
+
+void KigPainter::batchObject(const ObjectHolder *o, bool sel)
+{
+    // this mirrors what ObjectDrawer::draw() does..
+    const ObjectDrawer *d = o->drawer();
+    if (!(d->shown() || getNightVision()))
+        return;
+
+    const ObjectImp *imp = o->imp();
+    if (outsideWindow(imp)) {
+        ++mculled;
+        return;
+    }
+
+    BatchKind kind = NoBatch;
+    if (imp->type() == PointImp::stype())
+        kind = PointBatch;
+    else if (imp->type() == SegmentImp::stype())
+        kind = SegmentBatch;
+    if (kind == NoBatch) {
+        flushBatch();
+        drawObject(o, sel);
+        return;
+    }
+
+    const QColor c = sel ? Qt::red : (d->shown() ? d->color() : Qt::gray);
+    if (kind != mbatchkind || c != mbatchcolor || d->width() != mbatchwidth || d->style() != mbatchstyle || d->pointStyle() != mbatchpointstyle
+        || sel != mbatchselected) {
+        flushBatch();
+        mbatchkind = kind;
+        mbatchcolor = c;
+        mbatchwidth = d->width();
+        mbatchstyle = d->style();
+        mbatchpointstyle = d->pointStyle();
+        mbatchselected = sel;
+    }
+
+    if (kind == PointBatch)
+        mbatchpoints.push_back(static_cast<const PointImp *>(imp)->coordinate());
+    else {
+        const LineData l = static_cast<const SegmentImp *>(imp)->data();
+        mbatchpoints.push_back(l.a);
+        mbatchpoints.push_back(l.b);
+    }
+}
+
+int KigPainter::culledObjects() const
+{
+    return mculled;
+}
+
+void KigPainter::flushBatch()
+{
+    if (mbatchkind == NoBatch)
+        return;
+    setBrushStyle(Qt::NoBrush);
+    setBrushColor(mbatchcolor);
+    setPen(QPen(mbatchcolor, 1));
+    setWidth(mbatchwidth);
+    setStyle(mbatchstyle);
+    setPointStyle(mbatchpointstyle);
+    setSelected(mbatchselected);
+    if (mbatchkind == PointBatch)
+        drawFatPoints(mbatchpoints);
+    else
+        drawSegments(mbatchpoints);
+    mbatchpoints.clear();
+    mbatchkind = NoBatch;
+}
+
 void KigPainter::drawFilledRect(const QRect &r)
 {
     QPen pen(Qt::black, 1, Qt::DotLine);
@@ -579,8 +780,12 @@ void KigPainter::drawText(const Coordinate &p, const QString &s, int textFlags)
 }
 const Rect KigPainter::simpleBoundingRect(const Coordinate &c, const QString &s)
 {
-    int tf = Qt::AlignLeft | Qt::AlignTop | Qt::TextDontClip | Qt::TextWordWrap;
-    return boundingRect(c, s, tf);
+    const QPoint p = toScreen(c);
+    // the text is wrapped at the right edge of the window..
+    QRect qr(p, textLayout(s, mP.font(), mP.window().right() - p.x()).size);
+    qr.setWidth(qr.width() + 4);
+    qr.setHeight(qr.height() + 4);
+    return fromScreen(qr);
 }
 
 const Rect KigPainter::boundingRect(const Coordinate &c, const QString &s, int f) const
@@ -605,20 +810,6 @@ void KigPainter::drawRay(const Coordinate &a, const Coordinate &b)
     drawSegment(a, tb);
 }
 
-typedef std::pair<double, Coordinate> coordparampair;
-
-struct workitem {
-    workitem(const coordparampair &f, const coordparampair &s, Rect *o)
-        : first(f)
-        , second(s)
-        , overlay(o)
-    {
-    }
-    coordparampair first;
-    coordparampair second;
-    Rect *overlay;
-};
-
 void KigPainter::drawLine(const LineData &d)
 {
     if (d.a != d.b) {
@@ -664,9 +855,10 @@ void KigPainter::drawAngle(const Coordinate &point, double startangle, double an
     setBrushStyle(Qt::SolidPattern);
     mP.drawPolygon(arrow);
 
-    //  if ( mNeedOverlay ) mOverlay.push_back( toScreen( r ) );
-    setWholeWinOverlay(); // mp: ugly! why not compute a correct overlay?
-                          //     mOverlay.push_back( arrow.boundingRect() );
+    if (mNeedOverlay) {
+        arcOverlay(screenPoint, radius, startangle, angle);
+        mOverlay.push_back(arrow.boundingRect().adjusted(-overlayenlarge, -overlayenlarge, overlayenlarge, overlayenlarge));
+    }
 }
 
 void KigPainter::drawRightAngle(const Coordinate &point, double startangle, int diagonal)
@@ -685,7 +877,8 @@ void KigPainter::drawRightAngle(const Coordinate &point, double startangle, int
 
     mP.drawPolyline(rightAnglePolygon);
 
-    setWholeWinOverlay();
+    if (mNeedOverlay)
+        mOverlay.push_back(rightAnglePolygon.boundingRect().adjusted(-overlayenlarge, -overlayenlarge, overlayenlarge, overlayenlarge));
 }
 
 void KigPainter::drawPolygon(const std::vector<Coordinate> &pts, Qt::FillRule fillRule)
@@ -767,165 +960,62 @@ const double CurveImpPointCalcer::endinterval = 1.;
 
 void KigPainter::drawCurve(const CurveImp *curve)
 {
-    // we manage our own overlay
-    bool tNeedOverlay = mNeedOverlay;
-    mNeedOverlay = false;
-
-    QPen pen = mP.pen();
-
-    // this stack contains pairs of Coordinates ( parameter intervals )
-    // that we still need to process:
-    std::stack<workitem> workstack;
-    // mp: this stack contains all the generated overlays:
-    // the strategy for generating the overlay structure is the same
-    // recursive-like used to draw the segments: a new rectangle is
-    // generated whenever the length of a segment becomes lower than
-    // overlayRectSize(), or if the segment would be drawn anyway
-    // to avoid strange things from happening we impose that the distance
-    // in parameter space be less than a threshold before generating
-    // any overlay.
-    //
-    // The third parameter in workitem is a pointer into a stack of
-    // all generated rectangles (in real coordinate space); if 0
-    // there is no rectangles associated to that segment yet.
-    //
-    // Using the final mOverlay stack would be much more efficient, but
-    // 1. needs transformations into window space
-    // 2. would be more difficult to drop rectangles not intersecting
-    //    the window.
-    std::stack<Rect> overlaystack;
-
-    // mp: the original version in which an initial set of 20 intervals
-    // were pushed onto the stack is replaced by a single interval and
-    // by forcing subdivision till h < hmax (with more or less the same
-    // final result).
-    // First push the [0,1] interval into the stack:
-
-    Coordinate coo1 = curve->getPoint(0., mdoc);
-    Coordinate coo2 = curve->getPoint(1., mdoc);
-    workstack.push(workitem(coordparampair(0., coo1), coordparampair(1., coo2), nullptr));
-
-    // maxlength is the square of the maximum size that we allow
-    // between two points..
-    double maxlength = 1.5 * pixelWidth();
-    maxlength *= maxlength;
-    // error squared is required to be less that sigma (half pixel)
-    double sigma = maxlength / 4;
-    // distance between two parameter values cannot be too small
-    double hmin = 3e-5;
-    // distance between two parameter values cannot be too large
-    double hmax = 1. / 40;
-    double hmaxoverlay = 1. / 8;
-
-    int count = 1; // the number of segments we've already
-                   // visited...
+    // sampleCurve() approximates the curve with a set of polylines.
+    // We don't draw the individual segments, but use
+    // QPainter::drawPolyline() so that the line styles work properly.
+    // The error we allow is less than a pixel and a half: a pixel for
+    // the sampling, and half a pixel for the simplification of the
+    // polylines.
     static const int maxnumberofpoints = 1000;
+    const std::vector<std::vector<Coordinate>> pieces = sampleCurve(curve, mdoc, window(), pixelWidth(), maxnumberofpoints);
 
-    const Rect &sr = window();
+    for (std::vector<std::vector<Coordinate>>::const_iterator i = pieces.begin(); i != pieces.end(); ++i)
+        drawPolyline(*i);
+}
 
-    // what this algorithm does is approximating the curve with a set of
-    // segments.  we don't draw the individual segments, but use
-    // QPainter::drawPolyline() so that the line styles work properly.
-    // Possibly there are performance advantages as well ?  this array
-    // is a buffer of the polyline approximation of the part of the
-    // curve that we are currently processing.
-    QPolygon curpolyline(1000);
-    int curpolylinenextfree = 0;
-
-    // we don't use recursion, but a stack based approach for efficiency
-    // concerns...
-    while (!workstack.empty() && count < maxnumberofpoints) {
-        workitem curitem = workstack.top();
-        workstack.pop();
-        bool curitemok = true;
-        while (curitemok && count++ < maxnumberofpoints) {
-            double t0 = curitem.first.first;
-            double t1 = curitem.second.first;
-            Coordinate p0 = curitem.first.second;
-            bool valid0 = p0.valid();
-            Coordinate p1 = curitem.second.second;
-            bool valid1 = p1.valid();
-
-            // we take the middle parameter of the two previous points...
-            double t2 = (t0 + t1) / 2;
-            double h = fabs(t1 - t0) / 2;
-
-            // if exactly one of the two endpoints is invalid, then
-            // we prefer to find an internal value of the parameter
-            // separating valid points from invalid points.  We use
-            // a bisection strategy (this is not implemented yet!)
-            //      if ( ( valid0 && ! valid1 ) || ( valid1 && ! valid0 ) )
-            //      {
-            //	while ( h >= hmin )
-            //	{
-            //	  .......................................
-            //	}
-            //      }
-
-            Rect *overlaypt = curitem.overlay;
-            Coordinate p2 = curve->getPoint(t2, mdoc);
-            bool allvalid = p2.valid() && valid0 && valid1;
-            bool dooverlay =
-                !overlaypt && h < hmaxoverlay && valid0 && valid1 && fabs(p0.x - p1.x) <= overlayRectSize() && fabs(p0.y - p1.y) <= overlayRectSize();
-            bool addn = sr.contains(p2) || h >= hmax;
-            // estimated error between the curve and the segments
-            double errsq = 1e21;
-            if (allvalid)
-                errsq = (0.5 * p0 + 0.5 * p1 - p2).squareLength();
-            errsq /= 4;
-            curitemok = false;
-            //      bool dodraw = allvalid && h < hmax && ( errsq < sigma || h < hmin );
-            bool dodraw = allvalid && h < hmax && errsq < sigma;
-            if (tNeedOverlay && (dooverlay || dodraw)) {
-                Rect newoverlay(p0, p1);
-                overlaystack.push(newoverlay);
-                overlaypt = &overlaystack.top();
-            }
-            if (overlaypt)
-                overlaypt->setContains(p2);
-            if (dodraw) {
-                // draw the two segments
-                QPoint tp0 = toScreen(p0);
-                QPoint tp1 = toScreen(p1);
-                QPoint tp2 = toScreen(p2);
-                if (curpolylinenextfree > 0 && curpolyline[curpolylinenextfree - 1] != tp1) {
-                    // flush the current part of the curve
-                    mP.drawPolyline(curpolyline.constData(), curpolylinenextfree);
-                    curpolylinenextfree = 0;
-                }
-                if (curpolylinenextfree == 0)
-                    curpolyline[curpolylinenextfree++] = tp1;
-                curpolyline[curpolylinenextfree++] = tp2;
-                curpolyline[curpolylinenextfree++] = tp0;
-            } else if (h >= hmin) // we do not continue to subdivide indefinitely!
-            {
-                // push into stack in order to process both subintervals
-                if (addn || (valid0 && sr.contains(p0)))
-                    workstack.push(workitem(curitem.first, coordparampair(t2, p2), overlaypt));
-                if (addn || (valid1 && sr.contains(p1))) {
-                    curitem = workitem(coordparampair(t2, p2), curitem.second, overlaypt);
-                    curitemok = true;
-                }
+void KigPainter::drawPolyline(const std::vector<Coordinate> &pts)
+{
+    if (pts.empty())
+        return;
+    QPolygon polyline(pts.size());
+    for (uint i = 0; i < pts.size(); ++i)
+        polyline[i] = toScreen(pts[i]);
+    mP.drawPolyline(polyline);
+    if (mNeedOverlay)
+        polylineOverlay(pts);
+}
+
+void KigPainter::polylineOverlay(const std::vector<Coordinate> &pts)
+{
+    // mp: the overlay consists of rectangles no larger than
+    // overlayRectSize() that follow the polyline.  Segments that are
+    // longer than that ( the polylines of curves are simplified, so
+    // straight parts of a curve are a single segment ) are cut into
+    // pieces.
+    const double size = overlayRectSize();
+    const Rect border = window();
+    Coordinate prev = pts.front();
+    Rect overlay(prev, prev);
+    for (uint j = 1; j < pts.size(); ++j) {
+        const Coordinate &next = pts[j];
+        const int n = static_cast<int>(std::ceil(std::max(fabs(next.x - prev.x), fabs(next.y - prev.y)) / size));
+        for (int k = 1; k <= n; ++k) {
+            const Coordinate p = prev + (next - prev) * (static_cast<double>(k) / n);
+            Rect grown = overlay;
+            grown.setContains(p);
+            if (grown.width() > size || grown.height() > size) {
+                if (overlay.intersects(border))
+                    mOverlay.push_back(toScreenEnlarge(overlay));
+                const Coordinate last = prev + (next - prev) * (static_cast<double>(k - 1) / n);
+                grown = Rect(last, last);
+                grown.setContains(p);
             }
+            overlay = grown;
         }
+        prev = next;
     }
-    // flush the rest of the curve
-    mP.drawPolyline(curpolyline.constData(), curpolylinenextfree);
-    curpolylinenextfree = 0;
-
-    if (!workstack.empty())
-        qDebug() << "Stack not empty in KigPainter::drawCurve!\n";
-    assert(tNeedOverlay || overlaystack.empty());
-    if (tNeedOverlay) {
-        Rect border = window();
-        while (!overlaystack.empty()) {
-            Rect overlay = overlaystack.top();
-            overlaystack.pop();
-            if (overlay.intersects(border))
-                mOverlay.push_back(toScreenEnlarge(overlay));
-        }
-    }
-    mNeedOverlay = tNeedOverlay;
+    if (overlay.intersects(border))
+        mOverlay.push_back(toScreenEnlarge(overlay));
 }
 
 void KigPainter::drawTextFrame(const Rect &frame, const QString &s, bool needframe)
@@ -947,7 +1037,17 @@ void KigPainter::drawTextFrame(const Rect &frame, const QString &s, bool needfra
     };
     setPen(oldpen);
     setBrush(oldbrush);
-    drawText(frame, s, Qt::AlignVCenter | Qt::AlignLeft);
+
+    QRect t = toScreen(frame);
+    // wrapped the same way as in simpleBoundingRect()..
+    const TextLayout layout = textLayout(s, mP.font(), mP.window().right() - t.left());
+    t.translate(2, 2);
+    t.setWidth(t.width() - 4);
+    t.setHeight(t.height() - 4);
+    const QPoint pos(t.left(), t.top() + (t.height() - layout.size.height()) / 2);
+    mP.drawStaticText(pos, layout.text);
+    if (mNeedOverlay)
+        mOverlay.push_back(QRect(pos, layout.size + QSize(4, 4)));
 }
 
 void KigPainter::drawArc(const Coordinate &center, double radius, double dstartangle, double dangle)
@@ -967,6 +1067,7 @@ void KigPainter::drawArc(const Coordinate &center, double radius, double dstarta
         QRectF rect = toScreenF(krect);
 
         mP.drawArc(rect, startangle, angle);
-        setWholeWinOverlay();
+        if (mNeedOverlay)
+            arcOverlay(toScreenF(center), radius / pixelWidth(), dstartangle, dangle);
     }
 }
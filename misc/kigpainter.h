@@ -25,6 +25,7 @@ class LineData;
 class CurveImp;
 class KigDocument;
 class ObjectHolder;
+class ObjectImp;
 
 /**
  * KigPainter is an extended QPainter.
@@ -51,6 +52,7 @@ protected:
 
     const KigDocument &mdoc;
     ScreenInfo msi;
+    Rect mgridwindow;
 
     bool mNeedOverlay;
     int overlayenlarge;
@@ -71,6 +73,24 @@ public:
      * what rect are we drawing on ?
      */
     Rect window();
+    /**
+     * the rect from which the coordinate systems derive the spacing of
+     * the grid and the position of the arrows on the axes.  This is
+     * window(), unless it was changed with setGridWindow().
+     */
+    Rect gridWindow() const
+    {
+        return mgridwindow;
+    }
+    /**
+     * Draw the grid as if we were drawing on \p r, instead of on
+     * window().  This is used when a big image is painted in tiles, so
+     * that the grid is the same on all tiles.
+     */
+    void setGridWindow(const Rect &r)
+    {
+        mgridwindow = r;
+    }
 
     QPoint toScreen(const Coordinate &p) const;
     QRect toScreen(const Rect &r) const;
@@ -116,12 +136,23 @@ public:
      * draw an object ( by calling its draw function.. )
      */
     void drawObject(const ObjectHolder *o, bool sel);
+    /**
+     * draw a number of objects.  Consecutive points and segments that
+     * are drawn with the same color, width and style are collected, and
+     * drawn together with a single QPainter state, see batchObject().
+     */
     void drawObjects(const std::vector<ObjectHolder *> &os, bool sel);
+    /**
+     * The number of objects that drawObjects() skipped, because they
+     * lie entirely outside of the window.
+     */
+    int culledObjects() const;
     template<typename iter>
     void drawObjects(iter begin, iter end, bool sel)
     {
         for (; begin != end; ++begin)
-            drawObject(*begin, sel);
+            batchObject(*begin, sel);
+        flushBatch();
     }
 
     /**
@@ -129,6 +160,12 @@ public:
      */
     void drawCurve(const CurveImp *curve);
 
+    /**
+     * draw the polyline through the points in \p pts at once, so that
+     * the line style runs on from one segment to the next..
+     */
+    void drawPolyline(const std::vector<Coordinate> &pts);
+
     /**
      * draws text in a standard manner, convenience function...
      */
@@ -185,6 +222,15 @@ public:
      * certain radius...
      */
     void drawFatPoint(const Coordinate &p);
+    /**
+     * draw a number of thick points at once, with the current state..
+     */
+    void drawFatPoints(const std::vector<Coordinate> &pts);
+
+    /**
+     * draw the segments pts[0]pts[1], pts[2]pts[3], ... at once..
+     */
+    void drawSegments(const std::vector<Coordinate> &pts);
 
     /**
      * draw a polygon defined by the points in pts...
@@ -231,12 +277,26 @@ public:
     void drawText(const Coordinate &p, const QString &s, int textFlags = 0);
 
     void drawSimpleText(const Coordinate &c, const QString &s);
+    /**
+     * draw the text \p s, left aligned and vertically centered in \p
+     * frame, with a frame around it if \p needframe.  The layout of
+     * the text is cached, like in simpleBoundingRect().
+     */
     void drawTextFrame(const Rect &frame, const QString &s, bool needframe);
 
     const Rect boundingRect(const Rect &r, const QString &s, int f = 0) const;
 
     const Rect boundingRect(const Coordinate &c, const QString &s, int f = 0) const;
 
+    /**
+     * the rect that \p s takes when it is drawn with its top left
+     * corner at \p c, word wrapped at the right edge of the window.
+     * Laying out text is expensive, and unless the text has to be
+     * wrapped, the layout only depends on the text and the current
+     * font, not on where it is drawn or on the zoom level, so it is kept
+     * in a cache, and reused by drawTextFrame().  Wrapped layouts are
+     * cached together with the width they were wrapped at.
+     */
     const Rect simpleBoundingRect(const Coordinate &c, const QString &s);
 
     void drawGrid(const CoordinateSystem &c, bool showGrid = true, bool showAxes = true);
@@ -263,6 +323,19 @@ protected:
      */
     void segmentOverlay(const Coordinate &p1, const Coordinate &p2);
 
+    /**
+     * adds some rects to mOverlay, that follow the polyline through \p
+     * pts, see drawCurve()..
+     */
+    void polylineOverlay(const std::vector<Coordinate> &pts);
+
+    /**
+     * adds some rects to mOverlay, so that they cover the arc with
+     * centre \p centre and radius \p radius ( in widget coordinates )
+     * from \p startangle over \p angle ( in radians ).
+     */
+    void arcOverlay(const QPointF &centre, double radius, double startangle, double angle);
+
     /**
      * ...
      */
@@ -281,5 +354,34 @@ protected:
 
     void unsetSelected();
 
+    /**
+     * drawObjects() helpers: batchObject() draws \p o, unless it is a
+     * point or a segment, which are added to the current batch if they
+     * have the same drawer state.  Anything else flushes the batch
+     * first, so the objects are still drawn in the order given.
+     */
+    void batchObject(const ObjectHolder *o, bool sel);
+    void flushBatch();
+    /**
+     * whether \p imp certainly does not show up in the window, judging
+     * from its surroundingRect(), and for lines and rays, from where
+     * they cross the window.
+     */
+    bool outsideWindow(const ObjectImp *imp);
+    // the margin in pixels around the window that outsideWindow()
+    // allows for..
+    static const int cullMargin = 64;
+    int mculled;
+
     std::vector<QRect> mOverlay;
+
+    enum BatchKind { NoBatch, PointBatch, SegmentBatch };
+    BatchKind mbatchkind;
+    QColor mbatchcolor;
+    int mbatchwidth;
+    Qt::PenStyle mbatchstyle;
+    Kig::PointStyle mbatchpointstyle;
+    bool mbatchselected;
+    // the points, or the end points of the segments, in the batch..
+    std::vector<Coordinate> mbatchpoints;
 };
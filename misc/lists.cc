@@ -10,6 +10,9 @@
 #include "object_constructor.h"
 #include "object_hierarchy.h"
 
+#include "../objects/object_calcer.h"
+#include "../objects/object_imp.h"
+
 #include <KMessageBox>
 #include <QFile>
 #include <QRegExp>
@@ -118,7 +121,16 @@ ObjectConstructorList::vectype
 ObjectConstructorList::ctorsThatWantArgs(const std::vector<ObjectCalcer *> &os, const KigDocument &d, const KigWidget &w, bool co) const
 {
     vectype ret;
+    // an empty selection is wanted by everyone..
+    const bool filter = !os.empty();
+    ctorset cands;
+    if (filter)
+        cands = candidates(os);
+    // we walk mctors instead of cands, to keep the order in which the
+    // constructors were added
     for (vectype::const_iterator i = mctors.begin(); i != mctors.end(); ++i) {
+        if (filter && cands.find(*i) == cands.end() && munindexed.find(*i) == munindexed.end())
+            continue;
         int r = (*i)->wantArgs(os, d, w);
         if (r == ArgsParser::Complete || (!co && r == ArgsParser::Valid))
             ret.push_back(*i);
@@ -126,15 +138,64 @@ ObjectConstructorList::ctorsThatWantArgs(const std::vector<ObjectCalcer *> &os,
     return ret;
 }
 
+ObjectConstructorList::ctorset ObjectConstructorList::candidates(const std::vector<ObjectCalcer *> &os) const
+{
+    ctorset ret;
+    for (std::vector<ObjectCalcer *>::const_iterator o = os.begin(); o != os.end(); ++o) {
+        const ObjectImpType *t = (*o)->imp()->type();
+        // the indexed constructors that have an argument that o fits in..
+        ctorset fits;
+        for (std::map<const ObjectImpType *, ctorset>::const_iterator i = mindex.begin(); i != mindex.end(); ++i)
+            if (t->inherits(i->first))
+                fits.insert(i->second.begin(), i->second.end());
+        if (o == os.begin())
+            ret.swap(fits);
+        else {
+            ctorset both;
+            std::set_intersection(ret.begin(), ret.end(), fits.begin(), fits.end(), std::inserter(both, both.begin()));
+            ret.swap(both);
+        }
+        if (ret.empty())
+            break;
+    }
+    return ret;
+}
+
+void ObjectConstructorList::addToIndex(const ObjectConstructor *a)
+{
+    const ArgsParser *parser = a->argsParser();
+    if (!parser) {
+        munindexed.insert(a);
+        return;
+    }
+    std::vector<const ObjectImpType *> types = parser->argumentTypes();
+    for (std::vector<const ObjectImpType *>::const_iterator i = types.begin(); i != types.end(); ++i)
+        mindex[*i].insert(a);
+}
+
+void ObjectConstructorList::removeFromIndex(const ObjectConstructor *a)
+{
+    munindexed.erase(a);
+    for (std::map<const ObjectImpType *, ctorset>::iterator i = mindex.begin(); i != mindex.end();) {
+        i->second.erase(a);
+        if (i->second.empty())
+            mindex.erase(i++);
+        else
+            ++i;
+    }
+}
+
 void ObjectConstructorList::remove(ObjectConstructor *a)
 {
     vect_remove(mctors, a);
+    removeFromIndex(a);
     delete a;
 }
 
 void ObjectConstructorList::add(ObjectConstructor *a)
 {
     mctors.push_back(a);
+    addToIndex(a);
 }
 
 Macro::Macro(GUIAction *a, MacroConstructor *c)
@@ -253,9 +314,17 @@ bool MacroList::save(const std::vector<Macro *> &ms, const QString &f)
         }
 
         // data
-        QDomElement hierelem = doc.createElement(QStringLiteral("Construction"));
-        ctor->hierarchy().serialize(hierelem, doc);
-        macroelem.appendChild(hierelem);
+        const ObjectHierarchy *hier = ctor->hierarchy();
+        if (hier) {
+            QDomElement hierelem = doc.createElement(QStringLiteral("Construction"));
+            hier->serialize(hierelem, doc);
+            macroelem.appendChild(hierelem);
+        } else {
+            // keep what we have of a macro we couldn't build..
+            QDomDocument construction;
+            construction.setContent(ctor->construction());
+            macroelem.appendChild(doc.importNode(construction.documentElement(), true));
+        }
 
         docelem.appendChild(macroelem);
     };
@@ -270,24 +339,54 @@ bool MacroList::save(const std::vector<Macro *> &ms, const QString &f)
     return true;
 }
 
+// build the Macro for a MacroCache::Record.  If \p ctor is 0, the
+// MacroConstructor is created from the cached data, so that its
+// hierarchy is only parsed when it is first needed.  \p file and \p
+// index tell it where to find the macro if that fails.
+static Macro *buildMacro(const MacroCache::Record &r, MacroConstructor *ctor, int &unnamedindex, const QString &file = QString(), int index = -1)
+{
+    // if the macro has no name, we give it a bogus name...
+    QString name = r.name.isEmpty() ? i18n("Unnamed Macro #%1", unnamedindex++) : i18n(r.name.toUtf8());
+    QString description = r.description.isEmpty() ? QString() : i18n(r.description.toUtf8());
+    if (ctor) {
+        ctor->setName(name);
+        ctor->setDescription(description);
+    } else
+        ctor = new MacroConstructor(r.construction, r.args, r.numberofresults, r.lastresult, name, description, r.iconfile, file, index);
+    GUIAction *act = new ConstructibleAction(ctor, r.actionname);
+    return new Macro(act, ctor);
+}
+
 bool MacroList::load(const QString &f, std::vector<Macro *> &ret, const KigPart &kdoc)
 {
+    std::vector<MacroCache::Record> records;
+    if (MacroCache::instance()->lookup(f, records)) {
+        int unnamedindex = 1;
+        for (uint i = 0; i < records.size(); ++i)
+            ret.push_back(buildMacro(records[i], nullptr, unnamedindex, f, i));
+        return true;
+    }
+
     QFile file(f);
     if (!file.open(QIODevice::ReadOnly)) {
         KMessageBox::error(nullptr, i18n("Could not open macro file '%1'", f));
         return false;
     }
+    const QByteArray data = file.readAll();
+    file.close();
     QDomDocument doc(QStringLiteral("KigMacroFile"));
-    if (!doc.setContent(&file)) {
+    if (!doc.setContent(data)) {
         KMessageBox::error(nullptr, i18n("Could not open macro file '%1'", f));
         return false;
     }
-    file.close();
     QDomElement main = doc.documentElement();
 
-    if (main.tagName() == QLatin1String("KigMacroFile"))
-        return loadNew(main, ret, kdoc);
-    else {
+    if (main.tagName() == QLatin1String("KigMacroFile")) {
+        if (!loadNew(main, ret, records, kdoc))
+            return false;
+        MacroCache::instance()->insert(f, data, records);
+        return true;
+    } else {
         KMessageBox::detailedError(nullptr,
                                    i18n("Kig cannot open the macro file \"%1\".", f),
                                    i18n("This file was created by a very old Kig version (pre-0.4). "
@@ -299,7 +398,7 @@ bool MacroList::load(const QString &f, std::vector<Macro *> &ret, const KigPart
     }
 }
 
-bool MacroList::loadNew(const QDomElement &docelem, std::vector<Macro *> &ret, const KigPart &)
+bool MacroList::loadNew(const QDomElement &docelem, std::vector<Macro *> &ret, std::vector<MacroCache::Record> &records, const KigPart &)
 {
     bool sok = true;
     // unused..
@@ -320,41 +419,36 @@ bool MacroList::loadNew(const QDomElement &docelem, std::vector<Macro *> &ret, c
     QString tmp;
 
     for (QDomElement macroelem = docelem.firstChild().toElement(); !macroelem.isNull(); macroelem = macroelem.nextSibling().toElement()) {
-        QString name, description;
+        MacroCache::Record r;
         ObjectHierarchy *hierarchy = nullptr;
-        QByteArray actionname;
-        QByteArray iconfile("system-run");
+        r.iconfile = "system-run";
         if (macroelem.tagName() != QLatin1String("Macro"))
             continue; // forward compat ?
         for (QDomElement dataelem = macroelem.firstChild().toElement(); !dataelem.isNull(); dataelem = dataelem.nextSibling().toElement()) {
             if (dataelem.tagName() == QLatin1String("Name"))
-                name = dataelem.text();
+                r.name = dataelem.text();
             else if (dataelem.tagName() == QLatin1String("Description"))
-                description = dataelem.text();
-            else if (dataelem.tagName() == QLatin1String("Construction"))
+                r.description = dataelem.text();
+            else if (dataelem.tagName() == QLatin1String("Construction")) {
                 hierarchy = ObjectHierarchy::buildSafeObjectHierarchy(dataelem, tmp);
-            else if (dataelem.tagName() == QLatin1String("ActionName"))
-                actionname = dataelem.text().toLatin1();
+                QDomDocument construction;
+                construction.appendChild(construction.importNode(dataelem, true));
+                r.construction = construction.toByteArray(-1);
+            } else if (dataelem.tagName() == QLatin1String("ActionName"))
+                r.actionname = dataelem.text().toLatin1();
             else if (dataelem.tagName() == QLatin1String("IconFileName"))
-                iconfile = dataelem.text().toLatin1();
+                r.iconfile = dataelem.text().toLatin1();
             else
                 continue;
         };
         assert(hierarchy);
-        // if the macro has no name, we give it a bogus name...
-        bool name_i18ned = false;
-        if (name.isEmpty()) {
-            name = i18n("Unnamed Macro #%1", unnamedindex++);
-            name_i18ned = true;
-        }
-        MacroConstructor *ctor = new MacroConstructor(*hierarchy,
-                                                      name_i18ned ? name : i18n(name.toUtf8()),
-                                                      description.isEmpty() ? QString() : i18n(description.toUtf8()),
-                                                      iconfile);
+        MacroConstructor *ctor = new MacroConstructor(*hierarchy, QString(), QString(), r.iconfile);
         delete hierarchy;
-        GUIAction *act = new ConstructibleAction(ctor, actionname);
-        Macro *macro = new Macro(act, ctor);
-        ret.push_back(macro);
+        r.args = ctor->argsParser()->specs();
+        r.numberofresults = ctor->numberOfResults();
+        r.lastresult = r.numberofresults == 1 ? ctor->idOfLastResult() : nullptr;
+        ret.push_back(buildMacro(r, ctor, unnamedindex));
+        records.push_back(r);
     };
     return true;
 }
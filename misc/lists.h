@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include "macro_cache.h"
+
+#include <map>
 #include <set>
 #include <vector>
 
@@ -16,6 +19,7 @@ class KigWidget;
 class QString;
 class QDomElement;
 class ObjectCalcer;
+class ObjectImpType;
 
 /**
  * List of GUIActions for the parts to show.  Note that the list owns
@@ -64,6 +68,21 @@ public:
 
 private:
     vectype mctors;
+
+    /**
+     * An index of the constructors by the types of the arguments they
+     * accept ( see ObjectConstructor::argsParser() ).  A constructor
+     * can only want a selection if every selected object inherits one
+     * of its argument types, so ctorsThatWantArgs() only needs to ask
+     * the constructors that pass that test, and the unindexed ones.
+     */
+    typedef std::set<const ObjectConstructor *> ctorset;
+    std::map<const ObjectImpType *, ctorset> mindex;
+    ctorset munindexed;
+    void addToIndex(const ObjectConstructor *a);
+    void removeFromIndex(const ObjectConstructor *a);
+    ctorset candidates(const std::vector<ObjectCalcer *> &os) const;
+
     ObjectConstructorList();
     ~ObjectConstructorList();
 
@@ -148,6 +167,9 @@ public:
      * The fact that this functions requires a KigPart argument is
      * semantically incorrect, but i haven't been able to work around
      * it.
+     * The contents of \p f are looked up in, and stored in the
+     * MacroCache, call MacroCache::sync() after loading a batch of
+     * files.
      */
     bool load(const QString &f, vectype &ret, const KigPart &);
 
@@ -157,5 +179,5 @@ public:
     const vectype &macros() const;
 
 private:
-    bool loadNew(const QDomElement &docelem, std::vector<Macro *> &ret, const KigPart &);
+    bool loadNew(const QDomElement &docelem, std::vector<Macro *> &ret, std::vector<MacroCache::Record> &records, const KigPart &);
 };
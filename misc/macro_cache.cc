@@ -0,0 +1,246 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "macro_cache.h"
+
+#include "kig_version.h"
+
+#include "../objects/object_imp.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <map>
+
+static const quint32 cacheMagic = 0x4b4d4331; // "KMC1"
+// bump this when the format below changes.
+static const quint32 cacheFormat = 1;
+
+namespace
+{
+struct Entry {
+    qint64 mtime;
+    qint64 size;
+    QByteArray hash;
+    std::vector<MacroCache::Record> records;
+};
+}
+
+class MacroCache::Private
+{
+public:
+    bool loaded;
+    bool dirty;
+    std::map<QString, Entry> entries;
+
+    Private()
+        : loaded(false)
+        , dirty(false)
+    {
+    }
+
+    static QString cacheFile();
+    void read();
+    void write() const;
+};
+
+QString MacroCache::Private::cacheFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/macros.cache");
+}
+
+static QByteArray hashOf(const QByteArray &data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+// returns false if the record refers to a type that doesn't exist ( anymore ).
+static bool readRecord(QDataStream &in, MacroCache::Record &r)
+{
+    bool ok = true;
+    in >> r.name >> r.description >> r.actionname >> r.iconfile >> r.construction;
+    quint32 nargs;
+    in >> nargs;
+    for (quint32 i = 0; i < nargs && in.status() == QDataStream::Ok; ++i) {
+        QByteArray type, usetext, selectstat;
+        in >> type >> usetext >> selectstat;
+        ArgsParser::spec spec;
+        spec.type = ObjectImpType::typeFromInternalName(type.constData());
+        spec.usetext = usetext.toStdString();
+        spec.selectstat = selectstat.toStdString();
+        spec.onOrThrough = false;
+        ok = ok && spec.type;
+        r.args.push_back(spec);
+    }
+    quint32 nresults;
+    QByteArray lastresult;
+    in >> nresults >> lastresult;
+    r.numberofresults = nresults;
+    r.lastresult = nullptr;
+    if (!lastresult.isEmpty()) {
+        r.lastresult = ObjectImpType::typeFromInternalName(lastresult.constData());
+        ok = ok && r.lastresult;
+    }
+    return ok;
+}
+
+static void writeRecord(QDataStream &out, const MacroCache::Record &r)
+{
+    out << r.name << r.description << r.actionname << r.iconfile << r.construction;
+    out << static_cast<quint32>(r.args.size());
+    for (uint i = 0; i < r.args.size(); ++i) {
+        const ArgsParser::spec &spec = r.args[i];
+        out << QByteArray(spec.type->internalName()) << QByteArray::fromStdString(spec.usetext) << QByteArray::fromStdString(spec.selectstat);
+    }
+    out << static_cast<quint32>(r.numberofresults) << (r.lastresult ? QByteArray(r.lastresult->internalName()) : QByteArray());
+}
+
+void MacroCache::Private::read()
+{
+    loaded = true;
+    QFile file(cacheFile());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic, format;
+    QString version;
+    in >> magic >> format >> version;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic || format != cacheFormat || version != QStringLiteral(KIG_VERSION_STRING))
+        return;
+
+    quint32 nentries;
+    in >> nentries;
+    for (quint32 i = 0; i < nentries && in.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Entry e;
+        quint32 nrecords;
+        in >> path >> e.mtime >> e.size >> e.hash >> nrecords;
+        bool ok = true;
+        for (quint32 j = 0; j < nrecords && in.status() == QDataStream::Ok; ++j) {
+            MacroCache::Record r;
+            // an entry that refers to a type that no longer exists is
+            // dropped..
+            if (!readRecord(in, r))
+                ok = false;
+            e.records.push_back(r);
+        }
+        if (ok && in.status() == QDataStream::Ok)
+            entries[path] = e;
+    }
+    if (in.status() != QDataStream::Ok) {
+        // a truncated or corrupt cache, don't trust any of it..
+        entries.clear();
+    }
+}
+
+void MacroCache::Private::write() const
+{
+    const QString path = cacheFile();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+
+    out << cacheMagic << cacheFormat << QStringLiteral(KIG_VERSION_STRING);
+    out << static_cast<quint32>(entries.size());
+    for (std::map<QString, Entry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+        const Entry &e = i->second;
+        out << i->first << e.mtime << e.size << e.hash << static_cast<quint32>(e.records.size());
+        for (uint j = 0; j < e.records.size(); ++j)
+            writeRecord(out, e.records[j]);
+    }
+    file.commit();
+}
+
+MacroCache::MacroCache()
+    : d(new Private)
+{
+}
+
+MacroCache::~MacroCache()
+{
+    delete d;
+}
+
+MacroCache *MacroCache::instance()
+{
+    static MacroCache t;
+    return &t;
+}
+
+bool MacroCache::lookup(const QString &file, std::vector<Record> &ret)
+{
+    if (!d->loaded)
+        d->read();
+
+    std::map<QString, Entry>::iterator i = d->entries.find(file);
+    if (i == d->entries.end())
+        return false;
+    Entry &e = i->second;
+
+    QFileInfo info(file);
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    if (info.size() != e.size || mtime != e.mtime) {
+        // the file was touched, but maybe not changed..
+        QFile f(file);
+        if (!f.open(QIODevice::ReadOnly) || hashOf(f.readAll()) != e.hash) {
+            d->entries.erase(i);
+            d->dirty = true;
+            return false;
+        }
+        e.mtime = mtime;
+        e.size = info.size();
+        d->dirty = true;
+    }
+    ret = e.records;
+    return true;
+}
+
+void MacroCache::insert(const QString &file, const QByteArray &data, const std::vector<Record> &records)
+{
+    if (!d->loaded)
+        d->read();
+
+    QFileInfo info(file);
+    Entry &e = d->entries[file];
+    e.mtime = info.lastModified().toMSecsSinceEpoch();
+    e.size = data.size();
+    e.hash = hashOf(data);
+    e.records = records;
+    d->dirty = true;
+}
+
+void MacroCache::remove(const QString &file)
+{
+    if (!d->loaded)
+        d->read();
+
+    if (d->entries.erase(file))
+        d->dirty = true;
+}
+
+void MacroCache::sync()
+{
+    if (!d->dirty)
+        return;
+    // forget about files that have been removed..
+    for (std::map<QString, Entry>::iterator i = d->entries.begin(); i != d->entries.end();) {
+        if (QFileInfo::exists(i->first))
+            ++i;
+        else
+            i = d->entries.erase(i);
+    }
+    d->write();
+    d->dirty = false;
+}
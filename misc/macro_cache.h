@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "argsparser.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <vector>
+
+class ObjectImpType;
+
+/**
+ * MacroCache is a binary cache of the contents of Kig macro files
+ * ( builtin macro's and the user's saved types ).  Parsing a macro
+ * file with QDom and building the ObjectHierarchy's of its macro's is
+ * expensive, and Kig does this for every macro file at startup.  The
+ * cache stores, per macro, everything that is needed to register it (
+ * its names, icon, argument spec and result type ) together with the
+ * serialized form of its hierarchy, which MacroConstructor only parses
+ * when the macro is first used.
+ *
+ * A cache entry is valid as long as the size and modification time of
+ * its file are unchanged.  If they do change, the file is hashed, and
+ * the entry is still used if the contents are the same.  The cache is
+ * stored in the user's cache directory, and is discarded as a whole
+ * when the Kig version changes.
+ */
+class MacroCache
+{
+public:
+    /**
+     * One macro, as read from a macro file.  name and description are
+     * not yet translated.
+     */
+    struct Record {
+        QString name;
+        QString description;
+        QByteArray actionname;
+        QByteArray iconfile;
+        QByteArray construction;
+        std::vector<ArgsParser::spec> args;
+        uint numberofresults;
+        const ObjectImpType *lastresult;
+    };
+
+private:
+    class Private;
+    Private *d;
+    MacroCache();
+    ~MacroCache();
+
+public:
+    static MacroCache *instance();
+
+    /**
+     * Look up the macro's in file \p file.  Returns false if there is no
+     * valid entry for it, in which case the file should be parsed and
+     * the result passed to insert().
+     */
+    bool lookup(const QString &file, std::vector<Record> &ret);
+    /**
+     * Store the macro's \p records parsed from \p file, whose contents
+     * are \p data.
+     */
+    void insert(const QString &file, const QByteArray &data, const std::vector<Record> &records);
+    /**
+     * Forget about the entry for \p file, so that it is parsed again the
+     * next time.
+     */
+    void remove(const QString &file);
+    /**
+     * Write the cache back to disk, if it was changed.
+     */
+    void sync();
+};
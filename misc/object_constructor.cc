@@ -7,6 +7,7 @@
 #include "argsparser.h"
 #include "guiaction.h"
 #include "kigpainter.h"
+#include "macro_cache.h"
 
 #include "../kig/kig_part.h"
 #include "../kig/kig_view.h"
@@ -23,7 +24,10 @@
 
 #include "../modes/construct_mode.h"
 
+#include <QDebug>
+#include <QFile>
 #include <QPen>
+#include <qdom.h>
 
 #include <algorithm>
 #include <functional>
@@ -62,6 +66,11 @@ int StandardConstructorBase::wantArgs(const std::vector<ObjectCalcer *> &os, con
     return margsparser.check(os);
 }
 
+const ArgsParser *StandardConstructorBase::argsParser() const
+{
+    return &margsparser;
+}
+
 void StandardConstructorBase::handleArgs(const std::vector<ObjectCalcer *> &os, KigPart &d, KigWidget &v) const
 {
     std::vector<ObjectHolder *> bos = build(os, d.document(), v);
@@ -314,12 +323,16 @@ QString MergeObjectConstructor::selectStatement(const std::vector<ObjectCalcer *
 
 MacroConstructor::MacroConstructor(const ObjectHierarchy &hier, const QString &name, const QString &desc, const QByteArray &iconfile)
     : ObjectConstructor()
-    , mhier(hier)
+    , mhier(new ObjectHierarchy(hier))
+    , mnumberofresults(mhier->numberOfResults())
+    , mlastresult(nullptr)
     , mname(name)
     , mdesc(desc)
     , mbuiltin(false)
     , miconfile(iconfile)
-    , mparser(mhier.argParser())
+    , mparser(mhier->argParser())
+    , mindex(-1)
+    , mbroken(false)
 {
 }
 
@@ -329,17 +342,47 @@ MacroConstructor::MacroConstructor(const std::vector<ObjectCalcer *> &input,
                                    const QString &description,
                                    const QByteArray &iconfile)
     : ObjectConstructor()
-    , mhier(input, output)
+    , mhier(new ObjectHierarchy(input, output))
+    , mnumberofresults(mhier->numberOfResults())
+    , mlastresult(nullptr)
     , mname(name)
     , mdesc(description)
     , mbuiltin(false)
     , miconfile(iconfile)
-    , mparser(mhier.argParser())
+    , mparser(mhier->argParser())
+    , mindex(-1)
+    , mbroken(false)
+{
+}
+
+MacroConstructor::MacroConstructor(const QByteArray &construction,
+                                   const std::vector<ArgsParser::spec> &args,
+                                   uint numberofresults,
+                                   const ObjectImpType *lastresult,
+                                   const QString &name,
+                                   const QString &desc,
+                                   const QByteArray &iconfile,
+                                   const QString &file,
+                                   int index)
+    : ObjectConstructor()
+    , mhier(nullptr)
+    , mconstruction(construction)
+    , mnumberofresults(numberofresults)
+    , mlastresult(lastresult)
+    , mname(name)
+    , mdesc(desc)
+    , mbuiltin(false)
+    , miconfile(iconfile)
+    , mparser(args)
+    , mfile(file)
+    , mindex(index)
+    , mbroken(false)
 {
 }
 
 MacroConstructor::~MacroConstructor()
 {
+    delete mhier;
 }
 
 const QString MacroConstructor::descriptiveName() const
@@ -364,13 +407,23 @@ bool MacroConstructor::isAlreadySelectedOK(const std::vector<ObjectCalcer *> &,
 
 int MacroConstructor::wantArgs(const std::vector<ObjectCalcer *> &os, const KigDocument &, const KigWidget &) const
 {
+    if (mbroken)
+        return ArgsParser::Invalid;
     return mparser.check(os);
 }
 
+const ArgsParser *MacroConstructor::argsParser() const
+{
+    return &mparser;
+}
+
 void MacroConstructor::handleArgs(const std::vector<ObjectCalcer *> &os, KigPart &d, KigWidget &) const
 {
+    const ObjectHierarchy *hier = hierarchy();
+    if (!hier)
+        return;
     std::vector<ObjectCalcer *> args = mparser.parse(os);
-    std::vector<ObjectCalcer *> bos = mhier.buildObjects(args, d.document());
+    std::vector<ObjectCalcer *> bos = hier->buildObjects(args, d.document());
     std::vector<ObjectHolder *> hos;
     for (std::vector<ObjectCalcer *>::iterator i = bos.begin(); i != bos.end(); ++i) {
         hos.push_back(new ObjectHolder(*i));
@@ -406,14 +459,17 @@ QString MacroConstructor::useText(const ObjectCalcer &o, const std::vector<Objec
 
 void MacroConstructor::handlePrelim(KigPainter &p, const std::vector<ObjectCalcer *> &sel, const KigDocument &doc, const KigWidget &) const
 {
-    if (sel.size() != mhier.numberOfArgs())
+    if (sel.size() != mparser.specs().size())
+        return;
+    const ObjectHierarchy *hier = hierarchy();
+    if (!hier)
         return;
 
     using namespace std;
     Args args;
     transform(sel.begin(), sel.end(), back_inserter(args), mem_fun(&ObjectCalcer::imp));
     args = mparser.parse(args);
-    std::vector<ObjectImp *> ret = mhier.calc(args, doc);
+    std::vector<ObjectImp *> ret = hier->calc(args, doc);
     for (uint i = 0; i < ret.size(); ++i) {
         ObjectDrawer d;
         d.draw(*ret[i], p, true);
@@ -438,19 +494,19 @@ void MacroConstructor::plug(KigPart *doc, KigGUIAction *kact)
 {
     if (mbuiltin)
         return;
-    if (mhier.numberOfResults() != 1)
+    if (numberOfResults() != 1)
         doc->aMNewOther.append(kact);
     else {
-        if (mhier.idOfLastResult() == SegmentImp::stype())
+        if (idOfLastResult() == SegmentImp::stype())
             doc->aMNewSegment.append(kact);
-        else if (mhier.idOfLastResult() == PointImp::stype())
+        else if (idOfLastResult() == PointImp::stype())
             doc->aMNewPoint.append(kact);
-        else if (mhier.idOfLastResult() == CircleImp::stype())
+        else if (idOfLastResult() == CircleImp::stype())
             doc->aMNewCircle.append(kact);
-        else if (mhier.idOfLastResult()->inherits(AbstractLineImp::stype()))
+        else if (idOfLastResult()->inherits(AbstractLineImp::stype()))
             // line or ray
             doc->aMNewLine.append(kact);
-        else if (mhier.idOfLastResult() == ConicImp::stype())
+        else if (idOfLastResult() == ConicImp::stype())
             doc->aMNewConic.append(kact);
         else
             doc->aMNewOther.append(kact);
@@ -458,11 +514,73 @@ void MacroConstructor::plug(KigPart *doc, KigGUIAction *kact)
     doc->aMNewAll.append(kact);
 }
 
-const ObjectHierarchy &MacroConstructor::hierarchy() const
-{
+// read the hierarchy of this macro from its macro file again, and
+// check that it is still the macro we registered..
+ObjectHierarchy *MacroConstructor::readHierarchy() const
+{
+    QFile file(mfile);
+    if (mindex < 0 || !file.open(QIODevice::ReadOnly))
+        return nullptr;
+    QDomDocument doc;
+    if (!doc.setContent(&file))
+        return nullptr;
+
+    int index = 0;
+    QDomElement construction;
+    for (QDomElement macroelem = doc.documentElement().firstChildElement(QStringLiteral("Macro")); !macroelem.isNull();
+         macroelem = macroelem.nextSiblingElement(QStringLiteral("Macro")))
+        if (index++ == mindex)
+            construction = macroelem.firstChildElement(QStringLiteral("Construction"));
+    if (construction.isNull())
+        return nullptr;
+
+    QString error;
+    ObjectHierarchy *ret = ObjectHierarchy::buildSafeObjectHierarchy(construction, error);
+    if (ret && (ret->numberOfResults() != mnumberofresults || ret->argParser().argumentTypes() != mparser.argumentTypes())) {
+        delete ret;
+        ret = nullptr;
+    }
+    return ret;
+}
+
+const ObjectHierarchy *MacroConstructor::hierarchy() const
+{
+    if (!mhier && !mbroken) {
+        QDomDocument doc;
+        doc.setContent(mconstruction);
+        QString error;
+        mhier = ObjectHierarchy::buildSafeObjectHierarchy(doc.documentElement(), error);
+        if (!mhier) {
+            // the cache only contains hierarchies that were parsed
+            // successfully before, so it's damaged or out of date..
+            qWarning() << "Could not build macro" << mname << "from the macro cache:" << error;
+            MacroCache::instance()->remove(mfile);
+            MacroCache::instance()->sync();
+            mhier = readHierarchy();
+        }
+        if (!mhier) {
+            qWarning() << "Could not build macro" << mname << "from" << mfile << ", disabling it";
+            mbroken = true;
+        }
+    }
     return mhier;
 }
 
+const QByteArray &MacroConstructor::construction() const
+{
+    return mconstruction;
+}
+
+uint MacroConstructor::numberOfResults() const
+{
+    return mnumberofresults;
+}
+
+const ObjectImpType *MacroConstructor::idOfLastResult() const
+{
+    return mhier ? mhier->idOfLastResult() : mlastresult;
+}
+
 bool SimpleObjectTypeConstructor::isTransform() const
 {
     return mtype->isTransform();
@@ -549,6 +667,11 @@ bool ObjectConstructor::isTest() const
     return false;
 }
 
+const ArgsParser *ObjectConstructor::argsParser() const
+{
+    return nullptr;
+}
+
 BaseConstructMode *ObjectConstructor::constructMode(KigPart &doc)
 {
     return new ConstructMode(doc, this);
@@ -48,6 +48,17 @@ public:
      */
     virtual int wantArgs(const std::vector<ObjectCalcer *> &os, const KigDocument &d, const KigWidget &v) const = 0;
 
+    /**
+     * If this constructor only wants selections that \p parser accepts,
+     * i.e. wantArgs() returns ArgsParser::Invalid whenever
+     * argsParser()->check() does, return that parser.
+     * ObjectConstructorList uses it to index the constructors by the
+     * types of their arguments, so that it doesn't have to call
+     * wantArgs() on constructors that can't want a selection.  The
+     * default returns 0, meaning that wantArgs() is always called.
+     */
+    virtual const ArgsParser *argsParser() const;
+
     /**
      * do something fun with \p os .. This func is only called if wantArgs
      * returned Complete.. handleArgs should <i>not</i> do any
@@ -119,6 +130,7 @@ public:
 
     bool isAlreadySelectedOK(const std::vector<ObjectCalcer *> &os, const uint &) const override;
     int wantArgs(const std::vector<ObjectCalcer *> &os, const KigDocument &d, const KigWidget &v) const override;
+    const ArgsParser *argsParser() const override;
 
     void handleArgs(const std::vector<ObjectCalcer *> &os, KigPart &d, KigWidget &v) const override;
 
@@ -274,15 +286,31 @@ public:
  * output objects have been built from the input objects, and when
  * given similar input objects, it will produce objects in the given
  * way.  The data is saved in a \ref ObjectHierarchy.
+ *
+ * A MacroConstructor can also be created from the serialized form of
+ * its hierarchy, as stored in the macro cache ( see MacroCache ).  In
+ * that case, the hierarchy is only parsed the first time it is
+ * actually needed, which keeps Kig's startup time independent of the
+ * number of installed macro's.  If that fails, the cache entry is
+ * dropped and the macro is read from its file again, and if that fails
+ * too, the macro no longer accepts any arguments.
  */
 class MacroConstructor : public ObjectConstructor
 {
-    ObjectHierarchy mhier;
+    mutable ObjectHierarchy *mhier;
+    QByteArray mconstruction;
+    uint mnumberofresults;
+    const ObjectImpType *mlastresult;
     QString mname;
     QString mdesc;
     bool mbuiltin;
     QByteArray miconfile;
     ArgsParser mparser;
+    QString mfile;
+    int mindex;
+    mutable bool mbroken;
+
+    ObjectHierarchy *readHierarchy() const;
 
 public:
     MacroConstructor(const std::vector<ObjectCalcer *> &input,
@@ -291,9 +319,42 @@ public:
                      const QString &description,
                      const QByteArray &iconfile = nullptr);
     MacroConstructor(const ObjectHierarchy &hier, const QString &name, const QString &desc, const QByteArray &iconfile = nullptr);
+    /**
+     * Construct a MacroConstructor whose hierarchy is built lazily from
+     * \p construction, the XML of a "Construction" element as written
+     * by ObjectHierarchy::serialize.  \p args, \p numberofresults and
+     * \p lastresult must match that hierarchy's argParser(),
+     * numberOfResults() and idOfLastResult() ( \p lastresult is only
+     * used if there is exactly one result ).  The macro is the \p
+     * index'th one in the macro file \p file, which is read again if
+     * \p construction turns out to be unusable.
+     */
+    MacroConstructor(const QByteArray &construction,
+                     const std::vector<ArgsParser::spec> &args,
+                     uint numberofresults,
+                     const ObjectImpType *lastresult,
+                     const QString &name,
+                     const QString &desc,
+                     const QByteArray &iconfile,
+                     const QString &file,
+                     int index);
     ~MacroConstructor();
 
-    const ObjectHierarchy &hierarchy() const;
+    /**
+     * The hierarchy of this macro.  This parses it if that hasn't
+     * happened yet.  Returns 0 if the hierarchy could not be built.
+     */
+    const ObjectHierarchy *hierarchy() const;
+    /**
+     * The serialized hierarchy this macro was created from, if any.
+     */
+    const QByteArray &construction() const;
+    /**
+     * The result type of this macro, if it has exactly one result.
+     * This does not need the hierarchy to be parsed.
+     */
+    uint numberOfResults() const;
+    const ObjectImpType *idOfLastResult() const;
 
     const QString descriptiveName() const override;
     const QString description() const override;
@@ -301,6 +362,7 @@ public:
 
     bool isAlreadySelectedOK(const std::vector<ObjectCalcer *> &os, const uint &) const override;
     int wantArgs(const std::vector<ObjectCalcer *> &os, const KigDocument &d, const KigWidget &v) const override;
+    const ArgsParser *argsParser() const override;
 
     void handleArgs(const std::vector<ObjectCalcer *> &os, KigPart &d, KigWidget &v) const override;
 
@@ -30,6 +30,9 @@ public:
 
     virtual void apply(std::vector<ObjectCalcer *> &stack, int loc) const = 0;
 
+    // see ObjectHierarchy::isThreadSafe()..
+    virtual bool isThreadSafe() const;
+
     // this function is used to check whether the final objects depend
     // on the given objects.  The dependsstack contains a set of
     // booleans telling which parts of the hierarchy certainly depend on
@@ -49,6 +52,11 @@ ObjectHierarchy::Node::~Node()
 {
 }
 
+bool ObjectHierarchy::Node::isThreadSafe() const
+{
+    return true;
+}
+
 class PushStackNode : public ObjectHierarchy::Node
 {
     ObjectImp *mimp;
@@ -69,11 +77,17 @@ public:
     Node *copy() const override;
     void apply(std::vector<const ObjectImp *> &stack, int loc, const KigDocument &) const override;
     void apply(std::vector<ObjectCalcer *> &stack, int loc) const override;
+    bool isThreadSafe() const override;
 
     void checkDependsOnGiven(std::vector<bool> &dependsstack, int loc) const override;
     void checkArgumentsUsed(std::vector<bool> &usedstack) const override;
 };
 
+bool PushStackNode::isThreadSafe() const
+{
+    return mimp->isThreadSafe();
+}
+
 void PushStackNode::checkArgumentsUsed(std::vector<bool> &) const
 {
 }
@@ -135,11 +149,17 @@ public:
     int id() const override;
     void apply(std::vector<const ObjectImp *> &stack, int loc, const KigDocument &) const override;
     void apply(std::vector<ObjectCalcer *> &stack, int loc) const override;
+    bool isThreadSafe() const override;
 
     void checkDependsOnGiven(std::vector<bool> &dependsstack, int loc) const override;
     void checkArgumentsUsed(std::vector<bool> &usedstack) const override;
 };
 
+bool ApplyTypeNode::isThreadSafe() const
+{
+    return mtype->isThreadSafe();
+}
+
 int ApplyTypeNode::id() const
 {
     return ID_ApplyType;
@@ -266,6 +286,14 @@ void FetchPropertyNode::apply(std::vector<ObjectCalcer *> &stack, int loc) const
     stack[loc] = new ObjectPropertyCalcer(stack[mparent], mpropgid, false);
 }
 
+bool ObjectHierarchy::isThreadSafe() const
+{
+    for (uint i = 0; i < mnodes.size(); ++i)
+        if (!mnodes[i]->isThreadSafe())
+            return false;
+    return true;
+}
+
 std::vector<ObjectImp *> ObjectHierarchy::calc(const Args &a, const KigDocument &doc) const
 {
     assert(a.size() == mnumberofargs);
@@ -61,6 +61,14 @@ public:
 
     std::vector<ObjectImp *> calc(const Args &a, const KigDocument &doc) const;
 
+    /**
+     * Whether calc() may be called from another thread than the main
+     * one.  This is false if the hierarchy applies a type that is not
+     * thread-safe ( see ObjectType::isThreadSafe() ), or contains an
+     * ObjectImp that is not ( e.g. a locus of such a hierarchy ).
+     */
+    bool isThreadSafe() const;
+
     /**
      * saves the ObjectHierarchy data in children xml tags of \p parent .
      */
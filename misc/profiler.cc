@@ -0,0 +1,226 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "profiler.h"
+
+#include <kigpart_export.h>
+
+#include "calcpaths.h"
+
+#include "../kig/kig_document.h"
+#include "../objects/object_calcer.h"
+#include "../objects/imp_allocator.h"
+#include "../objects/object_holder.h"
+#include "../objects/object_imp.h"
+#include "../objects/object_type.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+bool Profiler::menabled = false;
+thread_local quint64 Profiler::mimps = 0;
+
+// the number of types and objects shown in the report..
+static const unsigned int maxReported = 25;
+
+static const char *const kindNames[Profiler::NumKinds] = {"calc", "draw", "contains"};
+
+namespace
+{
+struct Stats {
+    quint64 calls;
+    qint64 total;
+    qint64 max;
+    quint64 imps;
+
+    Stats()
+        : calls(0)
+        , total(0)
+        , max(0)
+        , imps(0)
+    {
+    }
+
+    void add(qint64 nsecs, quint64 nimps)
+    {
+        ++calls;
+        total += nsecs;
+        max = std::max(max, nsecs);
+        imps += nimps;
+    }
+};
+
+struct ObjectStats {
+    // the type of the last calc, to show in the report..
+    const char *type;
+    Stats stats[Profiler::NumKinds];
+
+    ObjectStats()
+        : type(nullptr)
+    {
+    }
+
+    qint64 total() const
+    {
+        qint64 ret = 0;
+        for (int i = 0; i < Profiler::NumKinds; ++i)
+            ret += stats[i].total;
+        return ret;
+    }
+};
+}
+
+class Profiler::Private
+{
+public:
+    QMutex mutex;
+    // the type names are all static strings ( ObjectType::fullName(),
+    // ObjectImpType::internalName() and the global property names ), so
+    // we can use their addresses as keys..
+    std::map<const char *, Stats> types[NumKinds];
+    std::map<const void *, ObjectStats> objects;
+    quint64 redraws;
+    quint64 culled;
+
+    Private()
+        : redraws(0)
+        , culled(0)
+    {
+    }
+};
+
+Profiler::Profiler()
+    : d(new Private)
+{
+}
+
+Profiler::~Profiler()
+{
+    delete d;
+}
+
+Profiler *Profiler::instance()
+{
+    static Profiler t;
+    return &t;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    menabled = enabled;
+}
+
+void Profiler::record(Kind kind, const char *type, const void *object, qint64 nsecs, quint64 imps)
+{
+    QMutexLocker locker(&d->mutex);
+    d->types[kind][type].add(nsecs, imps);
+    ObjectStats &o = d->objects[object];
+    o.stats[kind].add(nsecs, imps);
+    if (kind == Calc || !o.type)
+        o.type = type;
+}
+
+void Profiler::recordRedraw(int culled)
+{
+    QMutexLocker locker(&d->mutex);
+    ++d->redraws;
+    d->culled += culled;
+}
+
+const char *Profiler::name(const ObjectTypeCalcer *o)
+{
+    return o->type()->fullName();
+}
+
+const char *Profiler::name(const ObjectPropertyCalcer *o)
+{
+    return o->parent()->imp()->getPropName(o->propGid());
+}
+
+const char *Profiler::name(const ObjectHolder *o)
+{
+    return o->imp()->type()->internalName();
+}
+
+static QString formatStats(const Stats &s)
+{
+    return QStringLiteral("%1 %2 %3 %4")
+        .arg(s.calls, 10)
+        .arg(s.total / 1e6, 12, 'f', 3)
+        .arg(s.max / 1e6, 10, 'f', 3)
+        .arg(s.imps, 10);
+}
+
+void Profiler::dump(const KigDocument &doc) const
+{
+    QMutexLocker locker(&d->mutex);
+    QTextStream out(stderr);
+
+    const QString header = QStringLiteral("%1 %2 %3 %4").arg(QStringLiteral("calls"), 10).arg(QStringLiteral("total ms"), 12).arg(QStringLiteral("max ms"), 10).arg(QStringLiteral("imps"), 10);
+
+    out << "Kig profile, by type:\n";
+    out << QStringLiteral("%1 %2 ").arg(QStringLiteral("kind"), -8).arg(QStringLiteral("type"), -32) << header << "\n";
+    for (int k = 0; k < NumKinds; ++k) {
+        std::vector<std::pair<qint64, const char *>> sorted;
+        for (std::map<const char *, Stats>::const_iterator i = d->types[k].begin(); i != d->types[k].end(); ++i)
+            sorted.push_back(std::make_pair(i->second.total, i->first));
+        std::sort(sorted.rbegin(), sorted.rend());
+        for (uint i = 0; i < sorted.size() && i < maxReported; ++i)
+            out << QStringLiteral("%1 %2 ").arg(QLatin1String(kindNames[k]), -8).arg(QLatin1String(sorted[i].second), -32) << formatStats(d->types[k][sorted[i].second])
+                << "\n";
+    }
+
+    // only report the objects of this document, including the hidden
+    // ones that the shown objects depend on..
+    std::map<const ObjectCalcer *, const ObjectHolder *> holders;
+    std::vector<ObjectCalcer *> calcers;
+    const std::vector<ObjectHolder *> objs = doc.objects();
+    for (std::vector<ObjectHolder *>::const_iterator i = objs.begin(); i != objs.end(); ++i) {
+        holders[(*i)->calcer()] = *i;
+        calcers.push_back((*i)->calcer());
+    }
+    calcers = getAllParents(calcers);
+
+    std::vector<std::pair<qint64, const ObjectCalcer *>> sorted;
+    for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i) {
+        std::map<const void *, ObjectStats>::const_iterator s = d->objects.find(*i);
+        if (s != d->objects.end())
+            sorted.push_back(std::make_pair(s->second.total(), *i));
+    }
+    std::sort(sorted.rbegin(), sorted.rend());
+
+    out << "\nKig profile, hottest objects:\n";
+    out << QStringLiteral("%1 %2 ").arg(QStringLiteral("kind"), -8).arg(QStringLiteral("object"), -32) << header << "\n";
+    for (uint i = 0; i < sorted.size() && i < maxReported; ++i) {
+        const ObjectStats &s = d->objects[sorted[i].second];
+        QString name = s.type ? QString::fromLatin1(s.type) : QString();
+        std::map<const ObjectCalcer *, const ObjectHolder *>::const_iterator h = holders.find(sorted[i].second);
+        if (h == holders.end())
+            name += QStringLiteral(" (hidden)");
+        else if (!h->second->name().isNull())
+            name += QStringLiteral(" \"%1\"").arg(h->second->name());
+        for (int k = 0; k < NumKinds; ++k)
+            if (s.stats[k].calls > 0)
+                out << QStringLiteral("%1 %2 ").arg(QLatin1String(kindNames[k]), -8).arg(name, -32) << formatStats(s.stats[k]) << "\n";
+    }
+
+    if (d->redraws > 0)
+        out << "\nKig profile, " << d->redraws << " redraws, " << QString::number(double(d->culled) / d->redraws, 'f', 1)
+            << " objects outside of the window skipped per redraw\n";
+
+    const ImpAllocator::Stats allocs = ImpAllocator::stats();
+    out << "\nKig profile, imp allocator: " << allocs.allocated << " blocks from the heap, " << allocs.recycled << " recycled, " << allocs.inplace
+        << " imps recalculated in place\n";
+    out.flush();
+}
+
+extern "C" KIGPART_EXPORT void enableProfiler()
+{
+    Profiler::setEnabled(true);
+}
@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+class KigDocument;
+class ObjectHolder;
+class ObjectPropertyCalcer;
+class ObjectTypeCalcer;
+
+/**
+ * Profiler collects timings of the calculation, drawing and hit testing
+ * of objects, so that one can find out which objects make a document
+ * slow.  For every ObjectType ( or property, or ObjectImp type for
+ * drawing and hit testing ) and for every individual object, it counts
+ * the calls, their cumulative and maximum time, and the number of
+ * ObjectImp's created during them.  It also counts the redraws of the
+ * widgets, and the objects they didn't need to draw.
+ *
+ * It is off by default, and then costs no more than a test of a static
+ * bool per call.  It is enabled by starting Kig with --profile, and a
+ * report with the hottest types and objects of a document is written
+ * to stderr when the document is closed.
+ *
+ * Objects are identified by the address of their ObjectCalcer, so the
+ * counts of an object that is deleted can end up with another object
+ * that is created later at the same address.
+ */
+class Profiler
+{
+    class Private;
+    Private *d;
+    Profiler();
+    ~Profiler();
+
+    static bool menabled;
+    static thread_local quint64 mimps;
+
+public:
+    enum Kind { Calc, Draw, Contains, NumKinds };
+
+    static Profiler *instance();
+
+    static bool enabled()
+    {
+        return menabled;
+    }
+    /**
+     * Only call this at startup, before any objects are calculated.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Called by the ObjectImp constructor.
+     */
+    static void countImp()
+    {
+        if (menabled)
+            ++mimps;
+    }
+
+    /**
+     * Record one call of kind \p kind, for the type \p type and the
+     * object \p object, that took \p nsecs nanoseconds and created \p
+     * imps ObjectImp's.  This may be called from several threads at the
+     * same time, see calcAll().
+     */
+    void record(Kind kind, const char *type, const void *object, qint64 nsecs, quint64 imps);
+
+    /**
+     * Record a redraw of a KigWidget, in which \p culled objects were
+     * skipped because they lay outside of the shown rect.  Only call
+     * this on the main thread.
+     */
+    void recordRedraw(int culled);
+
+    /**
+     * The names under which the calculation of \p o, or the drawing and
+     * hit testing of \p o are recorded.  Looking them up takes a few
+     * virtual calls, so Scope and Tracer::Span only do that when they
+     * are enabled.
+     */
+    static const char *name(const ObjectTypeCalcer *o);
+    static const char *name(const ObjectPropertyCalcer *o);
+    static const char *name(const ObjectHolder *o);
+
+    /**
+     * Write the statistics for the objects in \p doc, and the totals per
+     * type, to stderr.
+     */
+    void dump(const KigDocument &doc) const;
+
+    /**
+     * Times its own lifetime, and records it in the Profiler if it is
+     * enabled.  \p type must stay valid until the Scope is destroyed.
+     */
+    class Scope
+    {
+        Kind mkind;
+        const char *mtype;
+        const void *mobject;
+        quint64 mimps;
+        QElapsedTimer mtimer;
+
+    public:
+        Scope(Kind kind, const char *type, const void *object)
+            : mkind(kind)
+            , mtype(type)
+            , mobject(object)
+            , mimps(0)
+        {
+            if (menabled) {
+                mimps = Profiler::mimps;
+                mtimer.start();
+            }
+        }
+        /**
+         * Time the calculation of \p o.
+         */
+        Scope(Kind kind, const ObjectTypeCalcer *o)
+            : Scope(kind, menabled ? name(o) : nullptr, o)
+        {
+        }
+        Scope(Kind kind, const ObjectPropertyCalcer *o)
+            : Scope(kind, menabled ? name(o) : nullptr, o)
+        {
+        }
+        /**
+         * Time the drawing or hit testing of \p o, whose calcer is \p
+         * object.
+         */
+        Scope(Kind kind, const ObjectHolder *o, const void *object)
+            : Scope(kind, menabled ? name(o) : nullptr, object)
+        {
+        }
+        ~Scope()
+        {
+            if (menabled)
+                Profiler::instance()->record(mkind, mtype, mobject, mtimer.nsecsElapsed(), Profiler::mimps - mimps);
+        }
+    };
+};
@@ -298,3 +298,13 @@ Rect Rect::invalidRect()
 {
     return Rect(Coordinate::invalidCoord(), double_inf, double_inf);
 }
+
+Rect Rect::boundingRect(const std::vector<Coordinate> &pts)
+{
+    if (pts.empty())
+        return invalidRect();
+    Rect ret(pts[0], 0., 0.);
+    for (uint i = 1; i < pts.size(); ++i)
+        ret.setContains(pts[i]);
+    return ret;
+}
@@ -12,6 +12,8 @@
 #include <QDebug>
 #include <QRect>
 
+#include <vector>
+
 /**
  * like Coordinate is a QPoint replacement with doubles, this is a
  * QRect replacement with doubles...
@@ -28,6 +30,11 @@ public:
     Rect(const Rect &r);
     Rect();
     static Rect invalidRect();
+    /**
+     * the smallest rect that contains all of \p pts, or an invalid rect
+     * if \p pts is empty.
+     */
+    static Rect boundingRect(const std::vector<Coordinate> &pts);
 
     bool valid();
 
@@ -0,0 +1,212 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "tracer.h"
+
+#include <kigpart_export.h>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+
+#include <csignal>
+
+bool Tracer::menabled = false;
+
+// the trace file has small numbers for the threads instead of their
+// real ids, 0 means that this thread has no number yet..
+static thread_local int threadNumber = 0;
+
+// events are collected in memory, and written out when this much has
+// piled up, or a second has passed..
+static const int bufferSize = 1 << 20;
+static const int flushInterval = 1000;
+
+class Tracer::Private
+{
+public:
+    // mutex guards everything but the file, filemutex guards the file.
+    // Whoever writes out the buffer takes filemutex before letting go
+    // of mutex, so that the chunks end up in the file in order, while
+    // the other threads already go on filling the next one..
+    QMutex mutex;
+    QMutex filemutex;
+    QFile file;
+    QElapsedTimer timer;
+    QByteArray buffer;
+    bool first;
+    QByteArray pid;
+    int lastthread;
+
+    Private()
+        : first(true)
+        , pid(QByteArray::number(QCoreApplication::applicationPid()))
+        , lastthread(0)
+    {
+    }
+
+    void append(const QByteArray &event);
+};
+
+void Tracer::Private::append(const QByteArray &event)
+{
+    if (!first)
+        buffer.append(",\n");
+    buffer.append(event);
+    first = false;
+}
+
+// the signals we write out the buffer on before Kig goes down, and the
+// handlers that were there before us ( KCrash's e.g. ), which we pass
+// the signal on to..
+static const int crashSignals[] = {SIGSEGV, SIGABRT, SIGFPE, SIGILL};
+static const int numberOfCrashSignals = sizeof(crashSignals) / sizeof(crashSignals[0]);
+static void (*previousHandlers[numberOfCrashSignals])(int);
+
+void Tracer::crashed(int signal)
+{
+    // we're going down anyway, so don't wait for the mutexes, the
+    // thread that crashed may well be holding one of them..
+    Private *d = instance()->d;
+    d->file.write(d->buffer);
+    d->file.flush();
+    for (int i = 0; i < numberOfCrashSignals; ++i)
+        if (crashSignals[i] == signal) {
+            void (*previous)(int) = previousHandlers[i];
+            if (previous == SIG_ERR || previous == SIG_IGN || !previous)
+                previous = SIG_DFL;
+            std::signal(signal, previous);
+        }
+    std::raise(signal);
+}
+
+static QByteArray escaped(const char *s)
+{
+    QByteArray ret(s);
+    ret.replace('\\', "\\\\");
+    ret.replace('"', "\\\"");
+    return ret;
+}
+
+Tracer::Tracer()
+    : d(new Private)
+{
+}
+
+Tracer::~Tracer()
+{
+    if (d->file.isOpen()) {
+        d->file.write(d->buffer);
+        d->file.write("\n]\n");
+        d->file.close();
+    }
+    delete d;
+}
+
+Tracer *Tracer::instance()
+{
+    static Tracer t;
+    return &t;
+}
+
+void Tracer::start(const QString &file)
+{
+    Tracer *t = instance();
+    t->d->file.setFileName(file);
+    if (!t->d->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not open the trace file" << file << ":" << t->d->file.errorString();
+        return;
+    }
+    t->d->file.write("[\n");
+    t->d->timer.start();
+
+    // write out what we have regularly, so that the trace can be
+    // looked at while Kig is running, and save it when Kig crashes..
+    if (QCoreApplication::instance()) {
+        QTimer *timer = new QTimer(QCoreApplication::instance());
+        QObject::connect(timer, &QTimer::timeout, [] {
+            Tracer::instance()->flush();
+        });
+        timer->start(flushInterval);
+    }
+    for (int i = 0; i < numberOfCrashSignals; ++i)
+        previousHandlers[i] = std::signal(crashSignals[i], crashed);
+
+    menabled = true;
+}
+
+void Tracer::startFromEnvironment()
+{
+    if (menabled)
+        return;
+    const QString file = qEnvironmentVariable("KIG_TRACE");
+    if (!file.isEmpty())
+        start(file);
+}
+
+qint64 Tracer::now() const
+{
+    return d->timer.nsecsElapsed();
+}
+
+void Tracer::add(const char *name, const char *category, qint64 start, qint64 end)
+{
+    QByteArray out;
+    {
+        QMutexLocker locker(&d->mutex);
+        const bool newthread = threadNumber == 0;
+        if (newthread)
+            threadNumber = ++d->lastthread;
+        const QByteArray tid = QByteArray::number(threadNumber);
+        if (newthread) {
+            // name the thread in the trace the first time we see it..
+            const bool mainthread = QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread();
+            QByteArray ev("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+            ev.append(d->pid).append(",\"tid\":").append(tid).append(",\"args\":{\"name\":\"");
+            ev.append(mainthread ? QByteArray("main") : "worker " + tid).append("\"}}");
+            d->append(ev);
+        }
+
+        // times are in microseconds..
+        QByteArray ev("{\"name\":\"");
+        ev.append(escaped(name)).append("\",\"cat\":\"").append(escaped(category)).append("\",\"ph\":\"X\"");
+        ev.append(",\"ts\":").append(QByteArray::number(start / 1e3, 'f', 3));
+        ev.append(",\"dur\":").append(QByteArray::number((end - start) / 1e3, 'f', 3));
+        ev.append(",\"pid\":").append(d->pid).append(",\"tid\":").append(tid).append("}");
+        d->append(ev);
+
+        if (d->buffer.size() < bufferSize)
+            return;
+        d->filemutex.lock();
+        out.swap(d->buffer);
+    }
+    // write the full buffer without keeping the other threads waiting..
+    d->file.write(out);
+    d->filemutex.unlock();
+}
+
+void Tracer::flush()
+{
+    QByteArray out;
+    {
+        QMutexLocker locker(&d->mutex);
+        d->filemutex.lock();
+        out.swap(d->buffer);
+    }
+    if (d->file.isOpen()) {
+        d->file.write(out);
+        d->file.flush();
+    }
+    d->filemutex.unlock();
+}
+
+extern "C" KIGPART_EXPORT void enableTracer(const QString &file)
+{
+    Tracer::start(file);
+}
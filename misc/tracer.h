@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "profiler.h"
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * Tracer writes spans of what Kig is doing to a file in the Chrome
+ * trace event format, which can be opened in Perfetto or
+ * chrome://tracing.  Spans are recorded for input events, the mouse
+ * handling of the modes, the calculation of objects, drawing and
+ * painting, and loading and saving documents.  This is meant for
+ * finding out where the time goes when e.g. dragging a point stutters,
+ * without having to build Kig with a profiler.
+ *
+ * It is off by default, and then costs no more than a test of a static
+ * bool per span.  It is enabled by starting Kig with --trace <file>, or
+ * by setting the KIG_TRACE environment variable to a file name.  Spans
+ * are collected in memory and written to the file every second, when a
+ * megabyte of them has piled up, at exit, and when Kig crashes, so a
+ * trace is usable even then, trace viewers don't mind a missing closing
+ * bracket.
+ */
+class Tracer
+{
+    class Private;
+    Private *d;
+    Tracer();
+    ~Tracer();
+
+    static bool menabled;
+
+    static void crashed(int signal);
+
+public:
+    static Tracer *instance();
+
+    static bool enabled()
+    {
+        return menabled;
+    }
+    /**
+     * Start writing a trace to \p file.  Only call this at startup,
+     * before any spans are recorded.
+     */
+    static void start(const QString &file);
+    /**
+     * Start tracing if the KIG_TRACE environment variable is set, and
+     * we are not tracing yet.
+     */
+    static void startFromEnvironment();
+
+    /**
+     * Record the span \p name in category \p category, from \p start to
+     * \p end, as returned by now().  This may be called from several
+     * threads at the same time.
+     */
+    void add(const char *name, const char *category, qint64 start, qint64 end);
+    /**
+     * Nanoseconds since tracing started.
+     */
+    qint64 now() const;
+    /**
+     * Write out everything recorded so far.
+     */
+    void flush();
+
+    /**
+     * Records its own lifetime as a span, if tracing is enabled.  \p
+     * name and \p category must stay valid until the Span is destroyed.
+     */
+    class Span
+    {
+        const char *mname;
+        const char *mcategory;
+        qint64 mstart;
+
+    public:
+        Span(const char *name, const char *category)
+            : mname(name)
+            , mcategory(category)
+            , mstart(menabled ? Tracer::instance()->now() : 0)
+        {
+        }
+        /**
+         * Record the calculation, drawing or hit testing of \p o, under
+         * the name Profiler::name() gives it.
+         */
+        Span(const ObjectTypeCalcer *o, const char *category)
+            : Span(menabled ? Profiler::name(o) : nullptr, category)
+        {
+        }
+        Span(const ObjectPropertyCalcer *o, const char *category)
+            : Span(menabled ? Profiler::name(o) : nullptr, category)
+        {
+        }
+        Span(const ObjectHolder *o, const char *category)
+            : Span(menabled ? Profiler::name(o) : nullptr, category)
+        {
+        }
+        ~Span()
+        {
+            if (menabled) {
+                Tracer *t = Tracer::instance();
+                t->add(mname, mcategory, mstart, t->now());
+            }
+        }
+    };
+};
@@ -19,6 +19,7 @@
 #include "../misc/coordinate_system.h"
 #include "../misc/kigpainter.h"
 #include "../misc/object_constructor.h"
+#include "../misc/tracer.h"
 
 #include "popup/objectchooserpopup.h"
 #include "popup/popup.h"
@@ -87,6 +88,7 @@ void BaseConstructMode::leftReleased(QMouseEvent *e, KigWidget *v)
 
 void BaseConstructMode::leftClickedObject(ObjectHolder *o, const QPoint &p, KigWidget &w, bool)
 {
+    Tracer::Span span("BaseConstructMode::leftClickedObject", "mode");
     std::vector<ObjectHolder *>::iterator it = std::find(mparents.begin(), mparents.end(), o);
     std::vector<ObjectCalcer *> nargs = getCalcers(mparents);
     //
@@ -155,6 +157,7 @@ void BaseConstructMode::rightClicked(const std::vector<ObjectHolder *> &, const
 
 void BaseConstructMode::mouseMoved(const std::vector<ObjectHolder *> &os, const QPoint &p, KigWidget &w, bool shiftpressed)
 {
+    Tracer::Span span("BaseConstructMode::mouseMoved", "mode");
     mdoc.emitStatusBarText(selectStatement(getCalcers(mparents), w));
 
     w.updateCurPix();
@@ -9,17 +9,21 @@
 
 #include "ui_historywidget.h"
 
+#include "../kig/kig_part.h"
+
 #include <QDialogButtonBox>
 #include <QIcon>
 #include <QIntValidator>
+#include <QLocale>
 #include <QPushButton>
 #include <QUndoStack>
 #include <QVBoxLayout>
 
 
-HistoryDialog::HistoryDialog(QUndoStack *kch, QWidget *parent)
+HistoryDialog::HistoryDialog(KigPart &doc, QWidget *parent)
     : QDialog(parent)
-    , mch(kch)
+    , mdoc(doc)
+    , mch(doc.history())
 {
     setWindowTitle(i18nc("@title:window", "History Browser"));
     QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close);
@@ -63,12 +67,18 @@ HistoryDialog::~HistoryDialog()
     delete mwidget;
 }
 
+void HistoryDialog::goTo(int index)
+{
+    // replaying the steps one by one would recalculate the document
+    // after every single one of them..
+    mdoc.startDeferredCalc();
+    mch->setIndex(index);
+    mdoc.finishDeferredCalc();
+}
+
 void HistoryDialog::goToFirst()
 {
-    int undosteps = mch->index();
-    for (int i = 0; i < undosteps; ++i) {
-        mch->undo();
-    }
+    goTo(0);
 
     updateWidgets();
 }
@@ -89,16 +99,19 @@ void HistoryDialog::goToNext()
 
 void HistoryDialog::goToLast()
 {
-    int redosteps = mch->count() - mch->index();
-    for (int i = 0; i < redosteps; ++i) {
-        mch->redo();
-    }
+    goTo(mch->count());
 
     updateWidgets();
 }
 
 void HistoryDialog::updateWidgets()
 {
+    // steps that were dropped to save memory disappear once they are
+    // undone, see KigPart::trimHistory()
+    mtotalsteps = mch->count() + 1;
+    mwidget->labelSteps->setText(QString::number(mtotalsteps));
+    mwidget->labelMemory->setText(i18n("Memory used by the history: %1", QLocale().formattedDataSize(mdoc.historyMemoryUsage())));
+
     int currentstep = mch->index() + 1;
 
     mwidget->editStep->setText(QString::number(currentstep));
@@ -7,6 +7,7 @@
 
 #pragma once
 
+class KigPart;
 class QUndoStack;
 class QWidget;
 class Ui_HistoryWidget;
@@ -22,7 +23,7 @@ class HistoryDialog : public QDialog
     Q_OBJECT
 
 public:
-    HistoryDialog(QUndoStack *kch, QWidget *parent);
+    HistoryDialog(KigPart &doc, QWidget *parent);
     virtual ~HistoryDialog();
 
 private Q_SLOTS:
@@ -34,6 +35,13 @@ private Q_SLOTS:
     void goToLast();
 
 private:
+    /**
+     * undoes or redoes up to step \p index in one go, calculating the
+     * document only once at the end.
+     */
+    void goTo(int index);
+
+    KigPart &mdoc;
     QUndoStack *mch;
 
     Ui_HistoryWidget *mwidget;
@@ -13,6 +13,7 @@
 #include "../misc/calcpaths.h"
 #include "../misc/coordinate_system.h"
 #include "../misc/kigpainter.h"
+#include "../misc/tracer.h"
 #include "../objects/object_factory.h"
 #include "../objects/object_imp.h"
 
@@ -34,6 +35,9 @@ void MovingModeBase::initScreen(const std::vector<ObjectCalcer *> &in)
     for (std::vector<ObjectHolder *>::iterator i = docobjs.begin(); i != docobjs.end(); ++i)
         if (calcableset.find((*i)->calcer()) != calcableset.end())
             mdrawable.push_back(*i);
+    // while moving, only the bounds of the moving objects change, see
+    // mouseMoved()..
+    mdoc.document().startChanging(mdrawable);
 
     std::set<ObjectHolder *> docobjsset(docobjs.begin(), docobjs.end());
     std::set<ObjectHolder *> drawableset(mdrawable.begin(), mdrawable.end());
@@ -52,10 +56,12 @@ void MovingModeBase::initScreen(const std::vector<ObjectCalcer *> &in)
 
 void MovingModeBase::leftReleased(QMouseEvent *, KigWidget *v)
 {
+    Tracer::Span span("MovingModeBase::leftReleased", "mode");
     // clean up after ourselves:
     for (std::vector<ObjectCalcer *>::iterator i = mcalcable.begin(); i != mcalcable.end(); ++i)
         (*i)->calc(mdoc.document());
     stopMove();
+    mdoc.document().endChanging();
     mdoc.setModified(true);
 
     // refresh the screen:
@@ -67,6 +73,7 @@ void MovingModeBase::leftReleased(QMouseEvent *, KigWidget *v)
 
 void MovingModeBase::mouseMoved(QMouseEvent *e, KigWidget *v)
 {
+    Tracer::Span span("MovingModeBase::mouseMoved", "mode");
     v->updateCurPix();
     Coordinate c = v->fromScreen(e->pos());
 
@@ -186,6 +193,7 @@ MovingModeBase::MovingModeBase(KigPart &doc, KigWidget &v)
 
 MovingModeBase::~MovingModeBase()
 {
+    mdoc.document().endChanging();
 }
 
 void MovingModeBase::leftMouseMoved(QMouseEvent *e, KigWidget *v)
@@ -9,6 +9,7 @@
 #include "../kig/kig_part.h"
 #include "../kig/kig_view.h"
 #include "../misc/kigpainter.h"
+#include "../misc/tracer.h"
 #include "../objects/object_drawer.h"
 #include "../objects/object_factory.h"
 #include "../objects/object_imp.h"
@@ -107,7 +108,7 @@ void NormalMode::editTypes()
 void NormalMode::browseHistory()
 {
     KigMode::enableActions();
-    HistoryDialog d(mdoc.history(), mdoc.widget());
+    HistoryDialog d(mdoc, mdoc.widget());
     d.exec();
     enableActions();
 }
@@ -146,6 +147,7 @@ void NormalMode::dragRect(const QPoint &p, KigWidget &w)
 
 void NormalMode::dragObject(const std::vector<ObjectHolder *> &oco, const QPoint &pco, KigWidget &w, bool ctrlOrShiftDown)
 {
+    Tracer::Span span("NormalMode::dragObject", "mode");
     // first determine what to move...
     if (sos.find(oco.front()) == sos.end()) {
         // the user clicked on something that is currently not
@@ -163,6 +165,7 @@ void NormalMode::dragObject(const std::vector<ObjectHolder *> &oco, const QPoint
 
 void NormalMode::leftClickedObject(ObjectHolder *o, const QPoint &, KigWidget &w, bool ctrlOrShiftDown)
 {
+    Tracer::Span span("NormalMode::leftClickedObject", "mode");
     KigPainter pter(w.screenInfo(), &w.stillPix, mdoc.document());
 
     if (!o) {
@@ -224,6 +227,7 @@ void NormalMode::rightClicked(const std::vector<ObjectHolder *> &os, const QPoin
 
 void NormalMode::mouseMoved(const std::vector<ObjectHolder *> &os, const QPoint &plc, KigWidget &w, bool)
 {
+    Tracer::Span span("NormalMode::mouseMoved", "mode");
     w.updateCurPix();
     if (os.empty()) {
         w.setCursor(Qt::ArrowCursor);
@@ -35,9 +35,17 @@ BezierImp::BezierImp(const std::vector<Coordinate> &points)
     for (uint i = 0; i < npoints; ++i) {
         centerofmassn += points[i];
     }
-    mpoints = points;
-    mcenterofmass = centerofmassn / npoints;
-    mnpoints = npoints;
+    std::shared_ptr<Data> data = std::make_shared<Data>();
+    data->points = points;
+    data->centerofmass = centerofmassn / npoints;
+    data->npoints = npoints;
+    data->boundrect = Rect::boundingRect(points);
+    md = data;
+}
+
+BezierImp::BezierImp(const std::shared_ptr<const Data> &data)
+    : md(data)
+{
 }
 
 BezierImp::~BezierImp()
@@ -46,7 +54,7 @@ BezierImp::~BezierImp()
 
 Coordinate BezierImp::attachPoint() const
 {
-    return mcenterofmass;
+    return md->centerofmass;
 }
 
 ObjectImp *BezierImp::transform(const Transformation &t) const
@@ -60,8 +68,8 @@ ObjectImp *BezierImp::transform(const Transformation &t) const
         return new InvalidImp;
     }
     std::vector<Coordinate> np;
-    for (uint i = 0; i < mpoints.size(); ++i) {
-        Coordinate nc = t.apply(mpoints[i]);
+    for (uint i = 0; i < md->points.size(); ++i) {
+        Coordinate nc = t.apply(md->points[i]);
         if (!nc.valid())
             return new InvalidImp;
         np.push_back(nc);
@@ -77,14 +85,14 @@ void BezierImp::draw(KigPainter &p) const
 bool BezierImp::inRect(const Rect &r, int width, const KigWidget &w) const
 {
     bool ret = false;
-    uint reduceddim = mpoints.size() - 1;
+    uint reduceddim = md->points.size() - 1;
     for (uint i = 0; !ret && i < reduceddim; ++i) {
-        SegmentImp s(mpoints[i], mpoints[i + 1]);
-        ret = lineInRect(r, mpoints[i], mpoints[i + 1], width, &s, w);
+        SegmentImp s(md->points[i], md->points[i + 1]);
+        ret = lineInRect(r, md->points[i], md->points[i + 1], width, &s, w);
     }
     if (!ret) {
-        SegmentImp s(mpoints[reduceddim], mpoints[0]);
-        ret = lineInRect(r, mpoints[reduceddim], mpoints[0], width, &s, w);
+        SegmentImp s(md->points[reduceddim], md->points[0]);
+        ret = lineInRect(r, md->points[reduceddim], md->points[0], width, &s, w);
     }
 
     return ret;
@@ -92,7 +100,7 @@ bool BezierImp::inRect(const Rect &r, int width, const KigWidget &w) const
 
 bool BezierImp::valid() const
 {
-    if (mnpoints > 1)
+    if (md->npoints > 1)
         return true;
     else
         return false;
@@ -154,10 +162,10 @@ ObjectImp *BezierImp::property(int which, const KigDocument &w) const
         return Parent::property(which, w);
     else if (which == Parent::numberOfProperties()) {
         // number of points
-        return new IntImp(mnpoints);
+        return new IntImp(md->npoints);
     } else if (which == Parent::numberOfProperties() + 1) {
         // control polygon
-        return new OpenPolygonalImp(mpoints);
+        return new OpenPolygonalImp(md->points);
     } else if (which == Parent::numberOfProperties() + 2) {
         // cartesian equation
         return new StringImp(cartesianEquationString(w));
@@ -166,19 +174,19 @@ ObjectImp *BezierImp::property(int which, const KigDocument &w) const
     return new InvalidImp;
 }
 
-const std::vector<Coordinate> BezierImp::points() const
+const std::vector<Coordinate> &BezierImp::points() const
 {
-    return mpoints;
+    return md->points;
 }
 
 uint BezierImp::npoints() const
 {
-    return mnpoints;
+    return md->npoints;
 }
 
 BezierImp *BezierImp::copy() const
 {
-    return new BezierImp(mpoints);
+    return new BezierImp(md);
 }
 
 void BezierImp::visit(ObjectImpVisitor *vtor) const
@@ -191,7 +199,7 @@ bool BezierImp::equals(const ObjectImp &rhs) const
     // that's actually sufficient condition for equality
     // of Bks; there are many equal Bks with distinct
     // control points
-    return rhs.inherits(BezierImp::stype()) && static_cast<const BezierImp &>(rhs).points() == mpoints;
+    return rhs.inherits(BezierImp::stype()) && static_cast<const BezierImp &>(rhs).points() == md->points;
 }
 
 const ObjectImpType *BezierImp::stype()
@@ -247,7 +255,7 @@ const ObjectImpType *BezierImp::stype3()
 
 const ObjectImpType *BezierImp::type() const
 {
-    uint n = mpoints.size();
+    uint n = md->points.size();
 
     if (n == 3)
         return BezierImp::stype2();
@@ -266,11 +274,7 @@ bool BezierImp::isPropertyDefinedOnOrThroughThisImp(int which) const
 
 Rect BezierImp::surroundingRect() const
 {
-    Rect r(0., 0., 0., 0.);
-    for (uint i = 0; i < mpoints.size(); ++i) {
-        r.setContains(mpoints[i]);
-    }
-    return r;
+    return md->boundrect;
 }
 
 bool BezierImp::contains(const Coordinate &o, int width, const KigWidget &w) const
@@ -293,8 +297,8 @@ bool BezierImp::internalContainsPoint(const Coordinate &p, double threshold, con
 Coordinate BezierImp::deCasteljau(unsigned int m, unsigned int k, double p) const
 {
     if (m == 0)
-        return mpoints[k];
-    assert(k + 1 <= mnpoints);
+        return md->points[k];
+    assert(k + 1 <= md->npoints);
     return (1 - p) * deCasteljau(m - 1, k, p) + p * deCasteljau(m - 1, k + 1, p);
 }
 
@@ -304,7 +308,7 @@ const Coordinate BezierImp::getPoint(double p, const KigDocument &doc) const
      *  Algorithm de Casteljau
      */
     doc.mcachedparam = p;
-    return deCasteljau(mpoints.size() - 1, 0, p);
+    return deCasteljau(md->points.size() - 1, 0, p);
 }
 
 /*
@@ -323,10 +327,23 @@ RationalBezierImp::RationalBezierImp(const std::vector<Coordinate> &points, cons
         centerofmassn += points[i];
         totalweight += weights[i];
     }
-    mpoints = points;
-    mweights = weights;
-    mcenterofmass = centerofmassn / totalweight;
-    mnpoints = npoints;
+    std::shared_ptr<Data> data = std::make_shared<Data>();
+    data->points = points;
+    data->weights = weights;
+    data->centerofmass = centerofmassn / totalweight;
+    data->npoints = npoints;
+    data->boundrect = Rect::boundingRect(points);
+    // with a negative weight, the curve can leave the convex hull of
+    // its control points..
+    for (uint i = 0; i < npoints; ++i)
+        if (weights[i] <= 0)
+            data->boundrect = Rect::invalidRect();
+    md = data;
+}
+
+RationalBezierImp::RationalBezierImp(const std::shared_ptr<const Data> &data)
+    : md(data)
+{
 }
 
 RationalBezierImp::~RationalBezierImp()
@@ -335,7 +352,7 @@ RationalBezierImp::~RationalBezierImp()
 
 Coordinate RationalBezierImp::attachPoint() const
 {
-    return mcenterofmass;
+    return md->centerofmass;
 }
 
 ObjectImp *RationalBezierImp::transform(const Transformation &t) const
@@ -349,13 +366,13 @@ ObjectImp *RationalBezierImp::transform(const Transformation &t) const
         return new InvalidImp;
     }
     std::vector<Coordinate> np;
-    for (uint i = 0; i < mpoints.size(); ++i) {
-        Coordinate nc = t.apply(mpoints[i]);
+    for (uint i = 0; i < md->points.size(); ++i) {
+        Coordinate nc = t.apply(md->points[i]);
         if (!nc.valid())
             return new InvalidImp;
         np.push_back(nc);
     }
-    return new RationalBezierImp(np, mweights);
+    return new RationalBezierImp(np, md->weights);
 }
 
 void RationalBezierImp::draw(KigPainter &p) const
@@ -366,14 +383,14 @@ void RationalBezierImp::draw(KigPainter &p) const
 bool RationalBezierImp::inRect(const Rect &r, int width, const KigWidget &w) const
 {
     bool ret = false;
-    uint reduceddim = mpoints.size() - 1;
+    uint reduceddim = md->points.size() - 1;
     for (uint i = 0; !ret && i < reduceddim; ++i) {
-        SegmentImp s(mpoints[i], mpoints[i + 1]);
-        ret = lineInRect(r, mpoints[i], mpoints[i + 1], width, &s, w);
+        SegmentImp s(md->points[i], md->points[i + 1]);
+        ret = lineInRect(r, md->points[i], md->points[i + 1], width, &s, w);
     }
     if (!ret) {
-        SegmentImp s(mpoints[reduceddim], mpoints[0]);
-        ret = lineInRect(r, mpoints[reduceddim], mpoints[0], width, &s, w);
+        SegmentImp s(md->points[reduceddim], md->points[0]);
+        ret = lineInRect(r, md->points[reduceddim], md->points[0], width, &s, w);
     }
 
     return ret;
@@ -381,7 +398,7 @@ bool RationalBezierImp::inRect(const Rect &r, int width, const KigWidget &w) con
 
 bool RationalBezierImp::valid() const
 {
-    if (mnpoints > 1 && mnpoints == mweights.size())
+    if (md->npoints > 1 && md->npoints == md->weights.size())
         return true;
     else
         return false;
@@ -443,10 +460,10 @@ ObjectImp *RationalBezierImp::property(int which, const KigDocument &w) const
         return Parent::property(which, w);
     else if (which == Parent::numberOfProperties()) {
         // number of points
-        return new IntImp(mnpoints);
+        return new IntImp(md->npoints);
     } else if (which == Parent::numberOfProperties() + 1) {
         // control polygon
-        return new OpenPolygonalImp(mpoints);
+        return new OpenPolygonalImp(md->points);
     } else if (which == Parent::numberOfProperties() + 2) {
         // cartesian equation
         return new StringImp(cartesianEquationString(w));
@@ -455,19 +472,24 @@ ObjectImp *RationalBezierImp::property(int which, const KigDocument &w) const
     return new InvalidImp;
 }
 
-const std::vector<Coordinate> RationalBezierImp::points() const
+const std::vector<Coordinate> &RationalBezierImp::points() const
 {
-    return mpoints;
+    return md->points;
+}
+
+const std::vector<double> &RationalBezierImp::weights() const
+{
+    return md->weights;
 }
 
 uint RationalBezierImp::npoints() const
 {
-    return mnpoints;
+    return md->npoints;
 }
 
 RationalBezierImp *RationalBezierImp::copy() const
 {
-    return new RationalBezierImp(mpoints, mweights);
+    return new RationalBezierImp(md);
 }
 
 void RationalBezierImp::visit(ObjectImpVisitor *vtor) const
@@ -480,7 +502,7 @@ bool RationalBezierImp::equals(const ObjectImp &rhs) const
     // that's actually sufficient condition for equality of
     // RBks; there are many RBks which don't have the same
     // control points
-    return rhs.inherits(BezierImp::stype()) && static_cast<const BezierImp &>(rhs).points() == mpoints;
+    return rhs.inherits(BezierImp::stype()) && static_cast<const BezierImp &>(rhs).points() == md->points;
 }
 
 const ObjectImpType *RationalBezierImp::stype()
@@ -536,7 +558,7 @@ const ObjectImpType *RationalBezierImp::stype3()
 
 const ObjectImpType *RationalBezierImp::type() const
 {
-    uint n = mpoints.size();
+    uint n = md->points.size();
 
     if (n == 3)
         return RationalBezierImp::stype2();
@@ -555,11 +577,7 @@ bool RationalBezierImp::isPropertyDefinedOnOrThroughThisImp(int which) const
 
 Rect RationalBezierImp::surroundingRect() const
 {
-    Rect r(0., 0., 0., 0.);
-    for (uint i = 0; i < mpoints.size(); ++i) {
-        r.setContains(mpoints[i]);
-    }
-    return r;
+    return md->boundrect;
 }
 
 bool RationalBezierImp::contains(const Coordinate &o, int width, const KigWidget &w) const
@@ -582,16 +600,16 @@ bool RationalBezierImp::internalContainsPoint(const Coordinate &p, double thresh
 Coordinate RationalBezierImp::deCasteljauPoints(unsigned int m, unsigned int k, double p) const
 {
     if (m == 0)
-        return mpoints[k] * mweights[k];
-    assert(k + 1 <= mnpoints);
+        return md->points[k] * md->weights[k];
+    assert(k + 1 <= md->npoints);
     return (1 - p) * deCasteljauPoints(m - 1, k, p) + p * deCasteljauPoints(m - 1, k + 1, p);
 }
 
 double RationalBezierImp::deCasteljauWeights(unsigned int m, unsigned int k, double p) const
 {
     if (m == 0)
-        return mweights[k];
-    assert(k + 1 <= mnpoints);
+        return md->weights[k];
+    assert(k + 1 <= md->npoints);
     return (1 - p) * deCasteljauWeights(m - 1, k, p) + p * deCasteljauWeights(m - 1, k + 1, p);
 }
 
@@ -601,5 +619,5 @@ const Coordinate RationalBezierImp::getPoint(double p, const KigDocument &doc) c
      *  Algorithm de Casteljau
      */
     doc.mcachedparam = p;
-    return deCasteljauPoints(mpoints.size() - 1, 0, p) / deCasteljauWeights(mweights.size() - 1, 0, p);
+    return deCasteljauPoints(md->points.size() - 1, 0, p) / deCasteljauWeights(md->weights.size() - 1, 0, p);
 }
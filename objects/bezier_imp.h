@@ -8,7 +8,9 @@
 #include "curve_imp.h"
 
 #include "../misc/coordinate.h"
+#include "../misc/rect.h"
 #include "object_imp.h"
+#include <memory>
 #include <vector>
 
 /**
@@ -16,9 +18,19 @@
  */
 class BezierImp : public CurveImp
 {
-    uint mnpoints;
-    std::vector<Coordinate> mpoints;
-    Coordinate mcenterofmass;
+    // never changed after construction, and shared between copies ( see
+    // AbstractPolygonImp::Data )..
+    struct Data {
+        uint npoints;
+        std::vector<Coordinate> points;
+        Coordinate centerofmass;
+        // the curve lies in the convex hull of its control points, so this
+        // is their bounding rect..
+        Rect boundrect;
+    };
+    std::shared_ptr<const Data> md;
+
+    explicit BezierImp(const std::shared_ptr<const Data> &data);
 
     Coordinate deCasteljau(unsigned int m, unsigned int k, double p) const;
 
@@ -65,7 +77,7 @@ public:
     /**
      * Returns the vector with control points.
      */
-    const std::vector<Coordinate> points() const;
+    const std::vector<Coordinate> &points() const;
     /**
      * Returns the center of mass of the control polygon.
      */
@@ -83,10 +95,18 @@ public:
  */
 class RationalBezierImp : public CurveImp
 {
-    uint mnpoints;
-    std::vector<Coordinate> mpoints;
-    std::vector<double> mweights;
-    Coordinate mcenterofmass;
+    // see BezierImp..
+    struct Data {
+        uint npoints;
+        std::vector<Coordinate> points;
+        std::vector<double> weights;
+        Coordinate centerofmass;
+        // see BezierImp, this is only valid if all weights are positive..
+        Rect boundrect;
+    };
+    std::shared_ptr<const Data> md;
+
+    explicit RationalBezierImp(const std::shared_ptr<const Data> &data);
 
     Coordinate deCasteljauPoints(unsigned int m, unsigned int k, double p) const;
     double deCasteljauWeights(unsigned int m, unsigned int k, double p) const;
@@ -134,7 +154,11 @@ public:
     /**
      * Returns the vector with control points.
      */
-    const std::vector<Coordinate> points() const;
+    const std::vector<Coordinate> &points() const;
+    /**
+     * Returns the vector with the weights of the control points.
+     */
+    const std::vector<double> &weights() const;
     /**
      * Returns the center of mass of the control polygon.
      */
@@ -162,6 +162,11 @@ bool StringImp::equals(const ObjectImp &rhs) const
     return rhs.inherits(StringImp::stype()) && static_cast<const StringImp &>(rhs).data() == mdata;
 }
 
+bool HierarchyImp::isThreadSafe() const
+{
+    return mdata.isThreadSafe();
+}
+
 bool HierarchyImp::equals(const ObjectImp &rhs) const
 {
     return rhs.inherits(HierarchyImp::stype()) && static_cast<const HierarchyImp &>(rhs).data() == mdata;
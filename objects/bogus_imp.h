@@ -6,6 +6,7 @@
 
 #include "../misc/kigtransform.h"
 #include "../misc/object_hierarchy.h"
+#include "imp_allocator.h"
 #include "object_imp.h"
 
 #include <QString>
@@ -76,6 +77,8 @@ class DoubleImp : public BogusImp
     double mdata;
 
 public:
+    KIG_IMP_ALLOCATOR
+
     /**
      * Returns the ObjectImpType representing the DoubleImp type.
      */
@@ -121,6 +124,8 @@ class IntImp : public BogusImp
     int mdata;
 
 public:
+    KIG_IMP_ALLOCATOR
+
     /**
      * Returns the ObjectImpType representing the IntImp type.
      */
@@ -220,6 +225,7 @@ public:
 
     HierarchyImp *copy() const override;
     const char *baseName() const;
+    bool isThreadSafe() const override;
 
     const ObjectImpType *type() const override;
     void visit(ObjectImpVisitor *vtor) const override;
@@ -135,8 +135,9 @@ double CurveImp::getParam(const Coordinate &p, const KigDocument &doc) const
     // was itself computed previously using getPoint.  So the param used in getPoint
     // is cached in LocusImp, BezierImp, ... and then checked for validity here.
 
-    if (doc.mcachedparam >= 0. && doc.mcachedparam <= 1. && getPoint(doc.mcachedparam, doc) == p)
-        return doc.mcachedparam;
+    const double cachedparam = doc.mcachedparam;
+    if (cachedparam >= 0. && cachedparam <= 1. && getPoint(cachedparam, doc) == p)
+        return cachedparam;
 
     // consider the function that returns the distance for a point at
     // parameter x to the locus for a given parameter x.  What we do
@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "imp_allocator.h"
+
+#include <atomic>
+#include <new>
+
+namespace
+{
+// block sizes are rounded up to a multiple of this..
+const std::size_t granularity = 8;
+const std::size_t numSizes = ImpAllocator::maxSize / granularity;
+// a thread keeps at most this many free blocks of each size, the rest
+// is returned to the heap..
+const unsigned int maxFree = 4096;
+
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+struct FreeLists {
+    FreeBlock *heads[numSizes];
+    unsigned int counts[numSizes];
+
+    FreeLists()
+    {
+        for (std::size_t i = 0; i < numSizes; ++i) {
+            heads[i] = nullptr;
+            counts[i] = 0;
+        }
+    }
+    ~FreeLists()
+    {
+        for (std::size_t i = 0; i < numSizes; ++i) {
+            while (heads[i]) {
+                FreeBlock *b = heads[i];
+                heads[i] = b->next;
+                ::operator delete(b);
+            }
+            // imps deleted after this, e.g. by static objects at exit, go
+            // straight to the heap..
+            counts[i] = maxFree;
+        }
+    }
+};
+
+thread_local FreeLists freelists;
+
+std::atomic<std::uint64_t> allocatedcount(0);
+std::atomic<std::uint64_t> recycledcount(0);
+std::atomic<std::uint64_t> inplacecount(0);
+}
+
+static std::size_t sizeIndex(std::size_t size)
+{
+    return (size + granularity - 1) / granularity - 1;
+}
+
+void *ImpAllocator::allocate(std::size_t size)
+{
+    if (size > maxSize) {
+        allocatedcount.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+    const std::size_t i = sizeIndex(size);
+    FreeBlock *b = freelists.heads[i];
+    if (!b) {
+        allocatedcount.fetch_add(1, std::memory_order_relaxed);
+        // always allocate the full size, so that the block can be reused
+        // for anything of the same size class..
+        return ::operator new((i + 1) * granularity);
+    }
+    freelists.heads[i] = b->next;
+    --freelists.counts[i];
+    recycledcount.fetch_add(1, std::memory_order_relaxed);
+    return b;
+}
+
+void ImpAllocator::release(void *p, std::size_t size)
+{
+    if (!p)
+        return;
+    if (size > maxSize) {
+        ::operator delete(p);
+        return;
+    }
+    const std::size_t i = sizeIndex(size);
+    if (freelists.counts[i] >= maxFree) {
+        ::operator delete(p);
+        return;
+    }
+    FreeBlock *b = static_cast<FreeBlock *>(p);
+    b->next = freelists.heads[i];
+    freelists.heads[i] = b;
+    ++freelists.counts[i];
+}
+
+ImpAllocator::Stats ImpAllocator::stats()
+{
+    Stats ret;
+    ret.allocated = allocatedcount.load(std::memory_order_relaxed);
+    ret.recycled = recycledcount.load(std::memory_order_relaxed);
+    ret.inplace = inplacecount.load(std::memory_order_relaxed);
+    return ret;
+}
+
+void ImpAllocator::countInPlace()
+{
+    inplacecount.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * ImpAllocator recycles the memory of small ObjectImp's.  Every
+ * recalculation of an ObjectTypeCalcer deletes its old imp and
+ * allocates a new one, and while dragging, that means a lot of small
+ * PointImp's, DoubleImp's and line imps going through the heap.
+ *
+ * Classes use it by defining their own operator new and delete, see
+ * KIG_IMP_ALLOCATOR below.  Freed blocks are kept in a per thread free
+ * list for their size, so the threads of calcAll() don't need to lock
+ * anything.  A block may be freed on another thread than the one that
+ * allocated it, it then simply moves to that thread's list.  Blocks
+ * larger than maxSize, and blocks that don't fit in a full free list,
+ * go to the heap as usual.
+ *
+ * calcAll() runs on the threads of its own QThreadPool, which end when
+ * it returns.  The blocks freed on those threads go back to the heap
+ * then, along with their free lists, so the recycling mostly pays off
+ * on the main thread, e.g. while dragging.
+ */
+class ImpAllocator
+{
+public:
+    /**
+     * The largest block size that is recycled.
+     */
+    static const std::size_t maxSize = 64;
+
+    static void *allocate(std::size_t size);
+    static void release(void *p, std::size_t size);
+
+    struct Stats {
+        /**
+         * blocks that came from the heap.
+         */
+        std::uint64_t allocated;
+        /**
+         * blocks that were taken from a free list.
+         */
+        std::uint64_t recycled;
+        /**
+         * recalculations that updated the old imp in place, see
+         * ObjectType::calcInto().
+         */
+        std::uint64_t inplace;
+    };
+    /**
+     * The counts since the start of the program, for benchmarking.
+     * They are part of the --profile report, see Profiler::dump().
+     */
+    static Stats stats();
+    static void countInPlace();
+};
+
+#define KIG_IMP_ALLOCATOR                                                                                                                                      \
+    static void *operator new(std::size_t size)                                                                                                                \
+    {                                                                                                                                                          \
+        return ImpAllocator::allocate(size);                                                                                                                   \
+    }                                                                                                                                                          \
+    static void operator delete(void *p, std::size_t size)                                                                                                     \
+    {                                                                                                                                                          \
+        ImpAllocator::release(p, size);                                                                                                                        \
+    }
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "curve_imp.h"
+#include "imp_allocator.h"
 
 #include "../misc/common.h"
 
@@ -22,6 +23,8 @@ protected:
     AbstractLineImp(const Coordinate &a, const Coordinate &b);
 
 public:
+    KIG_IMP_ALLOCATOR
+
     typedef CurveImp Parent;
     /**
      * Returns the ObjectImpType representing the AbstractLineImp
@@ -16,18 +16,21 @@
 #include "point_imp.h"
 
 #include <KLazyLocalizedString>
+#include <QMutex>
+#include <QMutexLocker>
+
 #include <cmath>
+#include <unordered_map>
 
 using namespace std;
 
 LocusImp::~LocusImp()
 {
-    delete mcurve;
 }
 
 ObjectImp *LocusImp::transform(const Transformation &t) const
 {
-    return new LocusImp(mcurve->copy(), mhier.transformFinalObject(t));
+    return new LocusImp(mcurve, mhier.transformFinalObject(t));
 }
 
 void LocusImp::draw(KigPainter &p) const
@@ -46,7 +49,35 @@ bool LocusImp::inRect(const Rect &, int, const KigWidget &) const
     return false;
 }
 
+// the most points we keep per locus..
+static const uint maxCachedPoints = 20000;
+
+struct LocusImp::PointCache {
+    QMutex mutex;
+    std::unordered_map<double, Coordinate> points;
+};
+
 const Coordinate LocusImp::getPoint(double param, const KigDocument &doc) const
+{
+    {
+        QMutexLocker locker(&mpoints->mutex);
+        std::unordered_map<double, Coordinate>::const_iterator i = mpoints->points.find(param);
+        if (i != mpoints->points.end()) {
+            if (i->second.valid())
+                doc.mcachedparam = param;
+            return i->second;
+        }
+    }
+    const Coordinate ret = calcPoint(param, doc);
+    QMutexLocker locker(&mpoints->mutex);
+    // a locus that is looked at from everywhere gets a fresh start..
+    if (mpoints->points.size() >= maxCachedPoints)
+        mpoints->points.clear();
+    mpoints->points[param] = ret;
+    return ret;
+}
+
+const Coordinate LocusImp::calcPoint(double param, const KigDocument &doc) const
 {
     Coordinate arg = mcurve->getPoint(param, doc);
     if (!arg.valid())
@@ -71,9 +102,27 @@ const Coordinate LocusImp::getPoint(double param, const KigDocument &doc) const
 LocusImp::LocusImp(CurveImp *curve, const ObjectHierarchy &hier)
     : mcurve(curve)
     , mhier(hier)
+    , mthreadsafe(mcurve->isThreadSafe() && mhier.isThreadSafe())
+    , mpoints(new PointCache)
+    , mrestored(false)
 {
 }
 
+LocusImp::LocusImp(const std::shared_ptr<const CurveImp> &curve, const ObjectHierarchy &hier)
+    : mcurve(curve)
+    , mhier(hier)
+    , mthreadsafe(mcurve->isThreadSafe() && mhier.isThreadSafe())
+    , mpoints(new PointCache)
+    , mrestored(false)
+{
+}
+
+bool LocusImp::isThreadSafe() const
+{
+    // getPoint() calculates mhier..
+    return mthreadsafe;
+}
+
 int LocusImp::numberOfProperties() const
 {
     return Parent::numberOfProperties() + 1;
@@ -127,12 +176,50 @@ ObjectImp *LocusImp::property(int which, const KigDocument &w) const
 
 LocusImp *LocusImp::copy() const
 {
-    return new LocusImp(mcurve->copy(), mhier);
+    LocusImp *ret = new LocusImp(mcurve, mhier);
+    ret->mpoints = mpoints;
+    ret->mkey = mkey;
+    ret->mrestored = mrestored;
+    return ret;
+}
+
+LocusImp::CachedPoints LocusImp::cachedPoints() const
+{
+    QMutexLocker locker(&mpoints->mutex);
+    return CachedPoints(mpoints->points.begin(), mpoints->points.end());
+}
+
+void LocusImp::addCachedPoints(const CachedPoints &points)
+{
+    QMutexLocker locker(&mpoints->mutex);
+    for (CachedPoints::const_iterator i = points.begin(); i != points.end() && mpoints->points.size() < maxCachedPoints; ++i)
+        mpoints->points.insert(*i);
+}
+
+const QByteArray &LocusImp::key() const
+{
+    return mkey;
+}
+
+void LocusImp::setKey(const QByteArray &key)
+{
+    mkey = key;
+}
+
+void LocusImp::setRestored()
+{
+    mrestored = true;
+}
+
+void LocusImp::takeCachedPoints(const LocusImp &old)
+{
+    if (old.mrestored || (!mkey.isEmpty() && mkey == old.mkey))
+        mpoints = old.mpoints;
 }
 
 const CurveImp *LocusImp::curve() const
 {
-    return mcurve;
+    return mcurve.get();
 }
 
 const ObjectHierarchy &LocusImp::hierarchy() const
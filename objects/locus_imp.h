@@ -7,6 +7,12 @@
 #include "../misc/object_hierarchy.h"
 #include "curve_imp.h"
 
+#include <QByteArray>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
 /**
  * LocusImp is an imp that consists of a copy of the curveimp that the
  * moving point moves over, and an ObjectHierarchy that can calc (
@@ -42,8 +48,23 @@
 
 class LocusImp : public CurveImp
 {
-    CurveImp *mcurve;
+    // copies and transforms of a locus only differ in their hierarchy,
+    // so they share the curve..
+    std::shared_ptr<const CurveImp> mcurve;
     const ObjectHierarchy mhier;
+    // see isThreadSafe(), calculated once since it walks the hierarchy..
+    bool mthreadsafe;
+    // the points getPoint() calculated, shared with our copies, and
+    // the key of the arguments they were calculated for, see
+    // cachedPoints()..
+    struct PointCache;
+    std::shared_ptr<PointCache> mpoints;
+    QByteArray mkey;
+    bool mrestored;
+
+    LocusImp(const std::shared_ptr<const CurveImp> &, const ObjectHierarchy &);
+
+    const Coordinate calcPoint(double param, const KigDocument &) const;
 
     void getInterval(double &x1, double &x2, double incr, const Coordinate &p, const KigDocument &doc) const;
 
@@ -62,6 +83,7 @@ public:
     Rect surroundingRect() const override;
     bool inRect(const Rect &r, int width, const KigWidget &) const override;
     const Coordinate getPoint(double param, const KigDocument &) const override;
+    bool isThreadSafe() const override;
 
     // TODO ?
     int numberOfProperties() const override;
@@ -75,6 +97,39 @@ public:
     const CurveImp *curve() const;
     const ObjectHierarchy &hierarchy() const;
 
+    typedef std::vector<std::pair<double, Coordinate>> CachedPoints;
+    /**
+     * Every point of a locus is a calculation of its hierarchy, which
+     * makes sampling a locus expensive.  So getPoint() keeps the points
+     * it calculates, by parameter, and copies of the locus share them.
+     * They are stored with the locus in the imp cache of saved
+     * documents ( see KigFilterNative ), so reopening a document
+     * doesn't sample its loci again.
+     */
+    CachedPoints cachedPoints() const;
+    void addCachedPoints(const CachedPoints &points);
+    /**
+     * A hash of the arguments this locus was calculated from, in their
+     * binary form, or an empty array if it is unknown.  Set by
+     * LocusType::calcInto().
+     */
+    const QByteArray &key() const;
+    void setKey(const QByteArray &key);
+    /**
+     * Mark this locus as read back from the imp cache of a saved
+     * document, whose own key made sure that it belongs to the
+     * arguments it is loaded with.  Its key, which hashes the
+     * arguments with all their digits, would not survive saving them.
+     */
+    void setRestored();
+    /**
+     * Share the cached points of \p old, if it has the same key as we
+     * have, or was restored.  Recalculating a locus that didn't change,
+     * as KigPart does with everything after loading, thus keeps its
+     * points.
+     */
+    void takeCachedPoints(const LocusImp &old);
+
     const ObjectImpType *type() const override;
     void visit(ObjectImpVisitor *vtor) const override;
 
@@ -5,8 +5,11 @@
 #include "object_calcer.h"
 
 #include "../misc/coordinate.h"
+#include "../misc/profiler.h"
+#include "../misc/tracer.h"
 #include "bogus_imp.h"
 #include "common.h"
+#include "imp_allocator.h"
 #include "object_holder.h"
 #include "object_imp.h"
 #include "object_type.h"
@@ -18,10 +21,16 @@
 
 void ObjectTypeCalcer::calc(const KigDocument &doc)
 {
+    Profiler::Scope profile(Profiler::Calc, this);
+    Tracer::Span span(this, "calc");
     Args a;
     a.reserve(mparents.size());
     std::transform(mparents.begin(), mparents.end(), std::back_inserter(a), std::mem_fun(&ObjectCalcer::imp));
-    ObjectImp *n = mtype->calc(a, doc);
+    ObjectImp *n = mtype->calcInto(a, doc, mimp);
+    if (n == mimp) {
+        ImpAllocator::countInPlace();
+        return;
+    }
     delete mimp;
     mimp = n;
 }
@@ -29,7 +38,9 @@ void ObjectTypeCalcer::calc(const KigDocument &doc)
 ObjectTypeCalcer::ObjectTypeCalcer(const ObjectType *type, const std::vector<ObjectCalcer *> &parents, bool sort)
     : mparents((sort) ? type->sortArgs(parents) : parents)
     , mtype(type)
-    , mimp(nullptr)
+    // until calc() is called, we are invalid.  Objects are not always
+    // calculated right after construction, see KigPart::openFile()
+    , mimp(new InvalidImp)
 {
     std::for_each(mparents.begin(), mparents.end(), std::bind2nd(std::mem_fun(&ObjectCalcer::addChild), this));
 }
@@ -121,18 +132,16 @@ const ObjectType *ObjectTypeCalcer::type() const
 }
 
 ObjectPropertyCalcer::ObjectPropertyCalcer(ObjectCalcer *parent, const char *pname)
-    : mimp(nullptr)
+    : mimp(new InvalidImp)
     , mparent(parent)
-    , mparenttype(nullptr)
 {
     mparent->addChild(this);
     mpropgid = mparent->imp()->getPropGid(pname);
 }
 
 ObjectPropertyCalcer::ObjectPropertyCalcer(ObjectCalcer *parent, int propid, bool islocal)
-    : mimp(nullptr)
+    : mimp(new InvalidImp)
     , mparent(parent)
-    , mparenttype(nullptr)
 {
     mparent->addChild(this);
     if (islocal) {
@@ -162,22 +171,49 @@ std::vector<ObjectCalcer *> ObjectPropertyCalcer::parents() const
 
 void ObjectPropertyCalcer::calc(const KigDocument &doc)
 {
-    // if ( mparenttype != mparent->imp()->type() )
-    if (mparenttype == nullptr || *mparenttype != typeid(*(mparent->imp()))) {
-        mpropid = mparent->imp()->getPropLid(mpropgid);
-        //    mparenttype = mparent->imp()->type();
-        mparenttype = &typeid(*(mparent->imp()));
-        //    printf ("changing type, new type: %s\n", mparenttype->internalName());
-    }
+    // the parent may have changed its imp type, so we look up the
+    // local id every time, this is cheap..
+    const int propid = mparent->imp()->getPropLid(mpropgid);
+    Profiler::Scope profile(Profiler::Calc, this);
+    Tracer::Span span(this, "calc");
     ObjectImp *n;
-    if (mpropid >= 0) {
-        n = mparent->imp()->property(mpropid, doc);
+    if (propid >= 0) {
+        n = mparent->imp()->property(propid, doc);
     } else
         n = new InvalidImp;
     delete mimp;
     mimp = n;
 }
 
+void ObjectTypeCalcer::setImp(ObjectImp *newimp)
+{
+    delete mimp;
+    mimp = newimp;
+}
+
+void ObjectTypeCalcer::calcMany(const std::vector<ObjectTypeCalcer *> &os, const KigDocument &doc)
+{
+    if (os.empty())
+        return;
+    const ObjectType *type = os.front()->mtype;
+    Tracer::Span span(type->fullName(), "calc");
+    std::vector<Args> args(os.size());
+    for (uint i = 0; i < os.size(); ++i) {
+        args[i].reserve(os[i]->mparents.size());
+        std::transform(os[i]->mparents.begin(), os[i]->mparents.end(), std::back_inserter(args[i]), std::mem_fun(&ObjectCalcer::imp));
+    }
+    const std::vector<ObjectImp *> imps = type->calcMany(args, doc);
+    assert(imps.size() == os.size());
+    for (uint i = 0; i < os.size(); ++i)
+        os[i]->setImp(imps[i]);
+}
+
+void ObjectPropertyCalcer::setImp(ObjectImp *newimp)
+{
+    delete mimp;
+    mimp = newimp;
+}
+
 ObjectImp *ObjectConstCalcer::switchImp(ObjectImp *newimp)
 {
     ObjectImp *ret = mimp;
@@ -233,6 +269,11 @@ bool ObjectCalcer::canMove() const
     return false;
 }
 
+bool ObjectCalcer::isThreadSafe() const
+{
+    return true;
+}
+
 bool ObjectCalcer::isFreelyTranslatable() const
 {
     return false;
@@ -254,6 +295,24 @@ bool ObjectTypeCalcer::canMove() const
     return mtype->canMove(*this);
 }
 
+bool ObjectTypeCalcer::isThreadSafe() const
+{
+    if (!mtype->isThreadSafe())
+        return false;
+    // the type may evaluate its arguments, e.g. a point constrained to a
+    // locus calculates the locus' hierarchy, and LocusType gets its
+    // hierarchy as an argument..
+    for (std::vector<ObjectCalcer *>::const_iterator i = mparents.begin(); i != mparents.end(); ++i)
+        if (!(*i)->imp()->isThreadSafe())
+            return false;
+    return true;
+}
+
+bool ObjectPropertyCalcer::isThreadSafe() const
+{
+    return mparent->imp()->isThreadSafe();
+}
+
 bool ObjectTypeCalcer::isFreelyTranslatable() const
 {
     return mtype->isFreelyTranslatable(*this);
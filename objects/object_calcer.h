@@ -123,6 +123,14 @@ public:
      * Returns whether this ObjectCalcer supports moving.
      */
     virtual bool canMove() const;
+    /**
+     * Returns whether calc() may be called for this ObjectCalcer on
+     * another thread than the main one, while other, independent
+     * ObjectCalcer's are calc'ed at the same time.  See calcAll().
+     * This depends on the current imps of the parents too, see
+     * ObjectImp::isThreadSafe().
+     */
+    virtual bool isThreadSafe() const;
     /**
      * Returns whether this ObjectCalcer can be translated at any position
      * in the coordinate plane.  Note that a ConstrainedPointType can be
@@ -199,9 +207,23 @@ public:
 
     const ObjectType *type() const;
 
+    /**
+     * Set our ObjectImp to \p newimp, which has been calculated before,
+     * e.g. when it is taken from the imp cache of a saved document.
+     * The old one will be deleted.  The next calc() replaces it again.
+     */
+    void setImp(ObjectImp *newimp);
+
+    /**
+     * Calculate all of \p os with one ObjectType::calcMany() call.  They
+     * must have the same type, and none of them may depend on another.
+     */
+    static void calcMany(const std::vector<ObjectTypeCalcer *> &os, const KigDocument &doc);
+
     const ObjectImpType *impRequirement(ObjectCalcer *o, const std::vector<ObjectCalcer *> &os) const override;
     bool isDefinedOnOrThrough(const ObjectCalcer *o) const override;
     bool canMove() const override;
+    bool isThreadSafe() const override;
     bool isFreelyTranslatable() const override;
     std::vector<ObjectCalcer *> movableParents() const override;
     Coordinate moveReferencePoint() const override;
@@ -262,22 +284,6 @@ class ObjectPropertyCalcer : public ObjectCalcer
     ObjectImp *mimp;
     ObjectCalcer *mparent;
     int mpropgid;
-    /*
-     * The following two variables are used for a caching
-     * mechanism to avoid computing the Lid corresponding to
-     * a Gid each time.  The "typeid" function in C++ is
-     * used to compare the object class of the parent Imp;
-     * the new Lid is computed only when the object class
-     * of the parent imp changes.
-     * As an alternative we could use "type" that each
-     * object imp provides, but this is not completely
-     * safe since in future extensions, in principle, two
-     * different ObjectImps could return the same "type"
-     * (although this is quite unlikely to happen)
-     */
-    mutable int mpropid;
-    //  mutable const ObjectImpType* mparenttype;
-    mutable const std::type_info *mparenttype;
 
 public:
     /**
@@ -294,8 +300,14 @@ public:
 
     ObjectCalcer *parent() const;
 
+    /**
+     * \see ObjectTypeCalcer::setImp
+     */
+    void setImp(ObjectImp *newimp);
+
     const ObjectImpType *impRequirement(ObjectCalcer *o, const std::vector<ObjectCalcer *> &os) const override;
     bool isDefinedOnOrThrough(const ObjectCalcer *o) const override;
+    bool isThreadSafe() const override;
 
     int propLid() const;
     int propGid() const;
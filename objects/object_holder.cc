@@ -9,6 +9,8 @@
 #include "object_drawer.h"
 
 #include "../misc/coordinate.h"
+#include "../misc/profiler.h"
+#include "../misc/tracer.h"
 
 ObjectHolder::ObjectHolder(ObjectCalcer *calcer)
     : mcalcer(calcer)
@@ -69,11 +71,14 @@ void ObjectHolder::calc(const KigDocument &d)
 
 void ObjectHolder::draw(KigPainter &p, bool selected) const
 {
+    Profiler::Scope profile(Profiler::Draw, this, mcalcer.get());
+    Tracer::Span span(this, "draw");
     mdrawer->draw(*imp(), p, selected);
 }
 
 bool ObjectHolder::contains(const Coordinate &pt, const KigWidget &w, bool nv) const
 {
+    Profiler::Scope profile(Profiler::Contains, this, mcalcer.get());
     return mdrawer->contains(*imp(), pt, w, nv);
 }
 
@@ -7,24 +7,64 @@
 #include "bogus_imp.h"
 
 #include "../misc/coordinate.h"
+#include "../misc/profiler.h"
 
 #include <KLazyLocalizedString>
+#include <QHash>
+#include <QMutex>
+#include <QRecursiveMutex>
+#include <QReadWriteLock>
+
+#include <deque>
 #include <map>
 
+class ObjectImpType::AncestorSet
+{
+public:
+    // the number of types that existed when this set was built..
+    int size;
+    std::vector<quint64> bits;
+
+    bool contains(int id) const
+    {
+        return (bits[id >> 6] >> (id & 63)) & 1;
+    }
+};
+
 class ObjectImpType::StaticPrivate
 {
 public:
     std::map<QByteArray, const ObjectImpType *> namemap;
+    // all types, indexed by their id
+    std::vector<const ObjectImpType *> types;
+    // protects types and the building of ancestor sets.  It is
+    // recursive, since match() may construct types that are used for
+    // the first time while we are building an ancestor set.
+    QRecursiveMutex lock;
+    // ancestor sets that were replaced by bigger ones.  Other threads
+    // may still be looking at them, so we only free them at exit.
+    std::vector<const AncestorSet *> retired;
+
+    ~StaticPrivate()
+    {
+        delete_all(retired.begin(), retired.end());
+    }
 };
 
 ObjectImp::ObjectImp()
 {
+    Profiler::countImp();
 }
 
 ObjectImp::~ObjectImp()
 {
 }
 
+bool ObjectImp::isThreadSafe() const
+{
+    return true;
+}
+
 bool ObjectImp::valid() const
 {
     return !type()->inherits(InvalidImp::stype());
@@ -203,18 +243,52 @@ ObjectImpType::ObjectImpType(const ObjectImpType *parent,
     , mattachtothisstatement(attachtothisstatement)
     , mshowastatement(showastatement)
     , mhideastatement(hideastatement)
+    , mproptable(nullptr)
+    , mancestors(nullptr)
 {
+    QMutexLocker l(&sd()->lock);
     sd()->namemap[minternalname] = this;
+    mid = sd()->types.size();
+    sd()->types.push_back(this);
 }
 
 ObjectImpType::~ObjectImpType()
 {
+    delete mproptable.load();
+    delete mancestors.load();
 }
 
 bool ObjectImpType::inherits(const ObjectImpType *t) const
 {
-    //  return t == this || (mparent && mparent->inherits( t ) );
-    return t->match(this) || (mparent && mparent->inherits(t));
+    const AncestorSet *a = mancestors.load(std::memory_order_acquire);
+    if (!a || t->mid >= a->size)
+        a = buildAncestors();
+    return a->contains(t->mid);
+}
+
+bool ObjectImpType::slowInherits(const ObjectImpType *t) const
+{
+    return t->match(this) || (mparent && mparent->slowInherits(t));
+}
+
+const ObjectImpType::AncestorSet *ObjectImpType::buildAncestors() const
+{
+    QMutexLocker l(&sd()->lock);
+    const AncestorSet *old = mancestors.load(std::memory_order_relaxed);
+    const int ntypes = sd()->types.size();
+    if (old && old->size == ntypes)
+        return old; // another thread was faster..
+
+    AncestorSet *a = new AncestorSet;
+    a->size = ntypes;
+    a->bits.resize((ntypes + 63) / 64, 0);
+    for (int i = 0; i < ntypes; ++i)
+        if (slowInherits(sd()->types[i]))
+            a->bits[i >> 6] |= quint64(1) << (i & 63);
+    mancestors.store(a, std::memory_order_release);
+    if (old)
+        sd()->retired.push_back(old);
+    return a;
 }
 
 bool ObjectImpType::match(const ObjectImpType *t) const
@@ -319,34 +393,112 @@ bool ObjectImp::isPropertyDefinedOnOrThroughThisImp(int) const
     return false;
 }
 
-static QByteArrayList propertiesGlobalInternalNames;
+/**
+ * The global property names, indexed by their Gid.  Names are only
+ * ever added, so a Gid stays valid for the lifetime of the program.
+ */
+class PropertyNameTable
+{
+    mutable QReadWriteLock mlock;
+    QHash<QByteArray, int> mids;
+    // a deque, so that the names don't move when we add new ones, and
+    // name() can hand out pointers to them..
+    std::deque<QByteArray> mnames;
 
-int ObjectImp::getPropGid(const char *pname) const
+public:
+    int find(const char *name) const
+    {
+        QReadLocker l(&mlock);
+        return mids.value(QByteArray::fromRawData(name, qstrlen(name)), -1);
+    }
+
+    int intern(const QByteArray &name)
+    {
+        QWriteLocker l(&mlock);
+        QHash<QByteArray, int>::const_iterator i = mids.constFind(name);
+        if (i != mids.constEnd())
+            return i.value();
+        const int ret = mnames.size();
+        mnames.push_back(name);
+        mids.insert(name, ret);
+        return ret;
+    }
+
+    int size() const
+    {
+        QReadLocker l(&mlock);
+        return mnames.size();
+    }
+
+    const char *name(int gid) const
+    {
+        QReadLocker l(&mlock);
+        return mnames[gid].constData();
+    }
+};
+
+static PropertyNameTable &propertiesGlobalInternalNames()
+{
+    static PropertyNameTable t;
+    return t;
+}
+
+class ObjectImpType::PropertyTable
 {
-    int wp = propertiesGlobalInternalNames.indexOf(pname);
-    if (wp >= 0)
-        return wp;
+public:
+    // the Lid for every Gid, or -1 if imps of this type don't have that
+    // property.  Gids beyond the end are never properties of this type,
+    // since all of its properties got a Gid when the table was built.
+    std::vector<int> lids;
+
+    int lid(int gid) const
+    {
+        return gid < static_cast<int>(lids.size()) ? lids[gid] : -1;
+    }
+};
 
-    int lp = propertiesInternalNames().indexOf(pname);
-    if (lp < 0)
-        return lp; // insist that this exists as a property
+const ObjectImpType::PropertyTable &ObjectImpType::propertyTable(const ObjectImp *imp) const
+{
+    const PropertyTable *ret = mproptable.load(std::memory_order_acquire);
+    if (ret)
+        return *ret;
+
+    static QMutex buildlock;
+    QMutexLocker l(&buildlock);
+    ret = mproptable.load(std::memory_order_relaxed);
+    if (!ret) {
+        PropertyTable *t = new PropertyTable;
+        const QByteArrayList names = imp->propertiesInternalNames();
+        for (int lid = 0; lid < names.size(); ++lid) {
+            const int gid = propertiesGlobalInternalNames().intern(names[lid]);
+            if (gid >= static_cast<int>(t->lids.size()))
+                t->lids.resize(gid + 1, -1);
+            // like indexOf(), the first property with a name wins
+            if (t->lids[gid] < 0)
+                t->lids[gid] = lid;
+        }
+        mproptable.store(t, std::memory_order_release);
+        ret = t;
+    }
+    return *ret;
+}
 
-    propertiesGlobalInternalNames << pname;
-    wp = propertiesGlobalInternalNames.indexOf(pname);
-    assert(wp >= 0);
-    return wp;
+int ObjectImp::getPropGid(const char *pname) const
+{
+    // building our table interns all our property names, so if pname
+    // is not known after this, it is not one of our properties..
+    type()->propertyTable(this);
+    return propertiesGlobalInternalNames().find(pname);
 }
 
 int ObjectImp::getPropLid(int propgid) const
 {
-    assert(propgid >= 0 && propgid < propertiesGlobalInternalNames.size());
-    int proplid = propertiesInternalNames().indexOf(propertiesGlobalInternalNames[propgid]);
-    //  printf ("getPropLid: converting %d in %d\n", propgid, proplid);
-    return proplid;
+    assert(propgid >= 0 && propgid < propertiesGlobalInternalNames().size());
+    return type()->propertyTable(this).lid(propgid);
 }
 
 const char *ObjectImp::getPropName(int propgid) const
 {
-    assert(propgid >= 0 && propgid < propertiesGlobalInternalNames.size());
-    return propertiesGlobalInternalNames[propgid];
+    assert(propgid >= 0 && propgid < propertiesGlobalInternalNames().size());
+    return propertiesGlobalInternalNames().name(propgid);
 }
@@ -8,6 +8,8 @@
 
 #include <KLazyLocalizedString>
 
+#include <atomic>
+
 class IntImp;
 class DoubleImp;
 class StringImp;
@@ -96,6 +98,31 @@ class ObjectImpType
     class StaticPrivate;
     static StaticPrivate *sd();
 
+    /**
+     * \internal The table mapping the global property ids ( see
+     * ObjectImp::getPropGid ) to the local ones of imps of this type.
+     * It is built from the first imp of this type whose properties are
+     * asked for, and never changes afterwards.  This assumes that all
+     * ObjectImp's of the same type have the same properties.
+     */
+    class PropertyTable;
+    mutable std::atomic<const PropertyTable *> mproptable;
+    const PropertyTable &propertyTable(const ObjectImp *imp) const;
+    friend class ObjectImp;
+
+    /**
+     * \internal Every type gets a dense id when it is constructed.
+     * inherits() is answered from a bitset of the ids of all the types
+     * that this type inherits, which is built on first use, and
+     * rebuilt when it is asked about a type that was registered after
+     * it was built.
+     */
+    int mid;
+    class AncestorSet;
+    mutable std::atomic<const AncestorSet *> mancestors;
+    const AncestorSet *buildAncestors() const;
+    bool slowInherits(const ObjectImpType *t) const;
+
 public:
     /**
      * Returns the type with name n.
@@ -143,9 +170,18 @@ public:
 
     /**
      * Does the ObjectImp type represented by this instance inherit the
-     * ObjectImp type represented by t ?
+     * ObjectImp type represented by t ?  This is a single bit test.
      */
     bool inherits(const ObjectImpType *t) const;
+    /**
+     * Does \p t count as this type ?  By default only if it is this
+     * type, but union types like InvertibleImpType override this to
+     * accept a set of otherwise unrelated types.  t inherits this type
+     * if this returns true for t or one of its parents.
+     *
+     * \internal The result must not change over time, it is cached in
+     * the bitsets used by inherits().
+     */
     virtual bool match(const ObjectImpType *t) const;
 
     /**
@@ -248,10 +284,11 @@ public:
      * the association of Gid to properties is constructed runtime whenever
      * a new property is first used by populating a static vector
      * (see object_imp.cc).
-     * The conversion Gid->Lid requires a vector search, so that a caching
-     * mechanism has been set up in the ObjectPropertyCalcer that stores the
-     * Lid and recalculates it when the typeid of the ObjectImp of the parent
-     * changes.
+     * The conversion Gid->Lid is a lookup in a table that every
+     * ObjectImpType builds the first time one of its imps is asked for
+     * a property, so it is cheap enough to be done on every
+     * calculation.  The global names are interned in a table that is
+     * safe to use from multiple threads.
      *
      * getPropLid: returns the local numbering corresponding to a Gid
      * getPropGid: returns the Gid of a property given its internal name
@@ -259,10 +296,6 @@ public:
      *
      * Note: in object_hierarchy.cc the class "FetchPropertyNode" is quite
      * similar to "ObjectPropertyCalcer", and thus is similarly restructured.
-     * However the caching mechanism has not been setup in this case.
-     * It seems that "FetchPropertyNode" is only used for the "drawprelim"
-     * in constructions that involve a macro that in turn involves a property,
-     * so perhaps the caching is not that important.
      */
     int getPropLid(int propgid) const;
     int getPropGid(const char *pname) const;
@@ -314,6 +347,16 @@ public:
     virtual bool inRect(const Rect &r, int width, const KigWidget &si) const = 0;
     virtual Rect surroundingRect() const = 0;
 
+    /**
+     * Whether this ObjectImp may be used ( drawn, asked for its
+     * properties or for points on it, ... ) from another thread than
+     * the main one.  This is false for imps that evaluate an
+     * ObjectHierarchy containing a type that is not thread-safe, like
+     * the locus of a point that depends on a Python script.  See
+     * ObjectType::isThreadSafe().  The default is true.
+     */
+    virtual bool isThreadSafe() const;
+
     /**
      * Returns true if this is a valid ObjectImp.
      * If you want to return an invalid ObjectImp, you should return an
@@ -4,6 +4,7 @@
 
 #include "object_imp_factory.h"
 
+#include "bezier_imp.h"
 #include "bogus_imp.h"
 #include "circle_imp.h"
 #include "conic_imp.h"
@@ -13,10 +14,12 @@
 #include "object_imp.h"
 #include "other_imp.h"
 #include "point_imp.h"
+#include "polygon_imp.h"
 #include "text_imp.h"
 
 #include "../misc/coordinate.h"
 
+#include <QDataStream>
 #include <qdom.h>
 
 const ObjectImpFactory *ObjectImpFactory::instance()
@@ -440,3 +443,484 @@ ObjectImp *ObjectImpFactory::deserialize(const QString &type, const QDomElement
         type);
     return nullptr;
 }
+
+// the tags used by the binary form of serialize/deserialize.  Only
+// ever append to this list, the numbers are stored in streams.
+enum BinaryImpTag {
+    InvalidTag = 0,
+    IntTag,
+    DoubleTag,
+    StringTag,
+    TestResultTag,
+    TransformationTag,
+    PointTag,
+    LineTag,
+    SegmentTag,
+    RayTag,
+    AngleTag,
+    VectorTag,
+    ArcTag,
+    CircleTag,
+    ConicPolarTag,
+    ConicCartTag,
+    CubicTag,
+    TextTag,
+    NumericTextTag,
+    BoolTextTag,
+    FilledPolygonTag,
+    ClosedPolygonalTag,
+    OpenPolygonalTag,
+    BezierTag,
+    RationalBezierTag,
+    LocusTag
+};
+
+static int binaryTag(const ObjectImp &d)
+{
+    // order matters: subtypes have to be checked before their parents
+    if (d.inherits(InvalidImp::stype()))
+        return InvalidTag;
+    else if (d.inherits(IntImp::stype()))
+        return IntTag;
+    else if (d.inherits(DoubleImp::stype()))
+        return DoubleTag;
+    else if (d.inherits(TestResultImp::stype()))
+        return TestResultTag;
+    else if (d.inherits(StringImp::stype()))
+        return StringTag;
+    else if (d.inherits(TransformationImp::stype()))
+        return TransformationTag;
+    else if (d.inherits(BogusPointImp::stype()))
+        return -1;
+    else if (d.inherits(PointImp::stype()))
+        return PointTag;
+    else if (d.inherits(SegmentImp::stype()))
+        return SegmentTag;
+    else if (d.inherits(RayImp::stype()))
+        return RayTag;
+    else if (d.inherits(LineImp::stype()))
+        return LineTag;
+    else if (d.inherits(AngleImp::stype()))
+        return AngleTag;
+    else if (d.inherits(VectorImp::stype()))
+        return VectorTag;
+    else if (d.inherits(ArcImp::stype()))
+        return ArcTag;
+    else if (d.inherits(CircleImp::stype()))
+        return CircleTag;
+    else if (d.inherits(ConicArcImp::stype()))
+        return -1;
+    else if (d.inherits(ConicImp::stype()))
+        return dynamic_cast<const ConicImpCart *>(&d) ? ConicCartTag : ConicPolarTag;
+    else if (d.inherits(CubicImp::stype()))
+        return CubicTag;
+    else if (d.inherits(NumericTextImp::stype()))
+        return NumericTextTag;
+    else if (d.inherits(BoolTextImp::stype()))
+        return BoolTextTag;
+    else if (d.inherits(TextImp::stype()))
+        return TextTag;
+    else if (d.inherits(FilledPolygonImp::stype()))
+        return FilledPolygonTag;
+    else if (d.inherits(ClosedPolygonalImp::stype()))
+        return ClosedPolygonalTag;
+    else if (d.inherits(OpenPolygonalImp::stype()))
+        return OpenPolygonalTag;
+    // the rational Bézier quadratics and cubics inherit from
+    // BezierImp::stype(), so we compare the exact types here..
+    else if (d.type() == RationalBezierImp::stype() || d.type() == RationalBezierImp::stype2() || d.type() == RationalBezierImp::stype3())
+        return RationalBezierTag;
+    else if (d.type() == BezierImp::stype() || d.type() == BezierImp::stype2() || d.type() == BezierImp::stype3())
+        return BezierTag;
+    else if (d.inherits(LocusImp::stype()))
+        return binaryTag(*static_cast<const LocusImp &>(d).curve()) >= 0 ? LocusTag : -1;
+    return -1;
+}
+
+static void writeCoordinate(QDataStream &stream, const Coordinate &c)
+{
+    stream << c.x << c.y;
+}
+
+static Coordinate readCoordinate(QDataStream &stream)
+{
+    Coordinate ret;
+    stream >> ret.x >> ret.y;
+    return ret;
+}
+
+static void writeCoordinates(QDataStream &stream, const std::vector<Coordinate> &cs)
+{
+    stream << static_cast<quint32>(cs.size());
+    for (std::vector<Coordinate>::const_iterator i = cs.begin(); i != cs.end(); ++i)
+        writeCoordinate(stream, *i);
+}
+
+static void writeDoubles(QDataStream &stream, const std::vector<double> &ds)
+{
+    stream << static_cast<quint32>(ds.size());
+    for (std::vector<double>::const_iterator i = ds.begin(); i != ds.end(); ++i)
+        stream << *i;
+}
+
+static std::vector<double> readDoubles(QDataStream &stream)
+{
+    std::vector<double> ret;
+    quint32 n = 0;
+    stream >> n;
+    for (quint32 i = 0; i < n && stream.status() == QDataStream::Ok; ++i) {
+        double d = 0.;
+        stream >> d;
+        ret.push_back(d);
+    }
+    return ret;
+}
+
+static std::vector<Coordinate> readCoordinates(QDataStream &stream)
+{
+    std::vector<Coordinate> ret;
+    quint32 n = 0;
+    stream >> n;
+    // don't trust n for a reserve(), the stream may be corrupt..
+    for (quint32 i = 0; i < n && stream.status() == QDataStream::Ok; ++i)
+        ret.push_back(readCoordinate(stream));
+    return ret;
+}
+
+bool ObjectImpFactory::canSerialize(const ObjectImp &d) const
+{
+    return binaryTag(d) >= 0;
+}
+
+bool ObjectImpFactory::serialize(const ObjectImp &d, QDataStream &stream) const
+{
+    int tag = binaryTag(d);
+    if (tag < 0)
+        return false;
+    stream << static_cast<quint8>(tag);
+    switch (tag) {
+    case InvalidTag:
+        break;
+    case IntTag:
+        stream << static_cast<qint32>(static_cast<const IntImp &>(d).data());
+        break;
+    case DoubleTag:
+        stream << static_cast<const DoubleImp &>(d).data();
+        break;
+    case StringTag:
+        stream << static_cast<const StringImp &>(d).data();
+        break;
+    case TestResultTag: {
+        const TestResultImp &t = static_cast<const TestResultImp &>(d);
+        stream << t.truth() << t.data();
+        break;
+    }
+    case TransformationTag: {
+        const Transformation &trans = static_cast<const TransformationImp &>(d).data();
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                stream << trans.data(i, j);
+        stream << trans.isHomothetic();
+        break;
+    }
+    case PointTag:
+        writeCoordinate(stream, static_cast<const PointImp &>(d).coordinate());
+        break;
+    case LineTag:
+    case SegmentTag:
+    case RayTag: {
+        LineData l = static_cast<const AbstractLineImp &>(d).data();
+        writeCoordinate(stream, l.a);
+        writeCoordinate(stream, l.b);
+        break;
+    }
+    case AngleTag: {
+        const AngleImp &a = static_cast<const AngleImp &>(d);
+        writeCoordinate(stream, a.point());
+        stream << a.startAngle() << a.angle() << a.markRightAngle();
+        break;
+    }
+    case VectorTag: {
+        const VectorImp &v = static_cast<const VectorImp &>(d);
+        writeCoordinate(stream, v.a());
+        writeCoordinate(stream, v.b());
+        break;
+    }
+    case ArcTag: {
+        const ArcImp &a = static_cast<const ArcImp &>(d);
+        writeCoordinate(stream, a.center());
+        stream << a.radius() << a.startAngle() << a.angle();
+        break;
+    }
+    case CircleTag: {
+        const CircleImp &c = static_cast<const CircleImp &>(d);
+        writeCoordinate(stream, c.center());
+        stream << c.radius();
+        break;
+    }
+    case ConicPolarTag: {
+        const ConicPolarData data = static_cast<const ConicImp &>(d).polarData();
+        writeCoordinate(stream, data.focus1);
+        stream << data.pdimen << data.ecostheta0 << data.esintheta0;
+        break;
+    }
+    case ConicCartTag: {
+        const ConicCartesianData data = static_cast<const ConicImp &>(d).cartesianData();
+        for (int i = 0; i < 6; ++i)
+            stream << data.coeffs[i];
+        break;
+    }
+    case CubicTag: {
+        const CubicCartesianData data = static_cast<const CubicImp &>(d).data();
+        for (int i = 0; i < 10; ++i)
+            stream << data.coeffs[i];
+        break;
+    }
+    case TextTag:
+    case NumericTextTag:
+    case BoolTextTag: {
+        const TextImp &t = static_cast<const TextImp &>(d);
+        stream << t.text();
+        writeCoordinate(stream, t.coordinate());
+        stream << t.hasFrame();
+        if (tag == NumericTextTag)
+            stream << static_cast<const NumericTextImp &>(d).getValue();
+        else if (tag == BoolTextTag)
+            stream << static_cast<const BoolTextImp &>(d).getValue();
+        break;
+    }
+    case FilledPolygonTag:
+    case ClosedPolygonalTag:
+    case OpenPolygonalTag:
+        writeCoordinates(stream, static_cast<const AbstractPolygonImp &>(d).points());
+        break;
+    case BezierTag:
+        writeCoordinates(stream, static_cast<const BezierImp &>(d).points());
+        break;
+    case RationalBezierTag: {
+        const RationalBezierImp &b = static_cast<const RationalBezierImp &>(d);
+        writeCoordinates(stream, b.points());
+        writeDoubles(stream, b.weights());
+        break;
+    }
+    case LocusTag: {
+        // the curve, the hierarchy, which only has an XML form, and the
+        // points we have sampled, which are the expensive part..
+        const LocusImp &l = static_cast<const LocusImp &>(d);
+        serialize(*l.curve(), stream);
+        QDomDocument doc;
+        QDomElement e = doc.createElement(QStringLiteral("Hierarchy"));
+        l.hierarchy().serialize(e, doc);
+        doc.appendChild(e);
+        stream << doc.toByteArray(-1);
+        const LocusImp::CachedPoints points = l.cachedPoints();
+        stream << static_cast<quint32>(points.size());
+        for (LocusImp::CachedPoints::const_iterator i = points.begin(); i != points.end(); ++i) {
+            stream << i->first;
+            writeCoordinate(stream, i->second);
+        }
+        break;
+    }
+    }
+    return true;
+}
+
+ObjectImp *ObjectImpFactory::deserialize(QDataStream &stream) const
+{
+    quint8 tag = 0;
+    stream >> tag;
+    if (stream.status() != QDataStream::Ok)
+        return nullptr;
+
+    ObjectImp *ret = nullptr;
+    switch (tag) {
+    case InvalidTag:
+        ret = new InvalidImp;
+        break;
+    case IntTag: {
+        qint32 i = 0;
+        stream >> i;
+        ret = new IntImp(i);
+        break;
+    }
+    case DoubleTag: {
+        double v = 0.;
+        stream >> v;
+        ret = new DoubleImp(v);
+        break;
+    }
+    case StringTag: {
+        QString v;
+        stream >> v;
+        ret = new StringImp(v);
+        break;
+    }
+    case TestResultTag: {
+        bool truth = false;
+        QString v;
+        stream >> truth >> v;
+        ret = new TestResultImp(truth, v);
+        break;
+    }
+    case TransformationTag: {
+        double data[3][3];
+        bool homothetic = false;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                stream >> data[i][j];
+        stream >> homothetic;
+        ret = new TransformationImp(Transformation(data, homothetic));
+        break;
+    }
+    case PointTag:
+        ret = new PointImp(readCoordinate(stream));
+        break;
+    case LineTag:
+    case SegmentTag:
+    case RayTag: {
+        Coordinate a = readCoordinate(stream);
+        Coordinate b = readCoordinate(stream);
+        if (tag == LineTag)
+            ret = new LineImp(a, b);
+        else if (tag == SegmentTag)
+            ret = new SegmentImp(a, b);
+        else
+            ret = new RayImp(a, b);
+        break;
+    }
+    case AngleTag: {
+        Coordinate p = readCoordinate(stream);
+        double startangle = 0.;
+        double angle = 0.;
+        bool markrightangle = false;
+        stream >> startangle >> angle >> markrightangle;
+        ret = new AngleImp(p, startangle, angle, markrightangle);
+        break;
+    }
+    case VectorTag: {
+        Coordinate a = readCoordinate(stream);
+        Coordinate b = readCoordinate(stream);
+        ret = new VectorImp(a, b);
+        break;
+    }
+    case ArcTag: {
+        Coordinate center = readCoordinate(stream);
+        double radius = 0.;
+        double startangle = 0.;
+        double angle = 0.;
+        stream >> radius >> startangle >> angle;
+        ret = new ArcImp(center, radius, startangle, angle);
+        break;
+    }
+    case CircleTag: {
+        Coordinate center = readCoordinate(stream);
+        double radius = 0.;
+        stream >> radius;
+        ret = new CircleImp(center, radius);
+        break;
+    }
+    case ConicPolarTag: {
+        Coordinate focus1 = readCoordinate(stream);
+        double pdimen = 0.;
+        double ecostheta0 = 0.;
+        double esintheta0 = 0.;
+        stream >> pdimen >> ecostheta0 >> esintheta0;
+        ret = new ConicImpPolar(ConicPolarData(focus1, pdimen, ecostheta0, esintheta0));
+        break;
+    }
+    case ConicCartTag: {
+        double coeffs[6];
+        for (int i = 0; i < 6; ++i)
+            stream >> coeffs[i];
+        ret = new ConicImpCart(ConicCartesianData(coeffs));
+        break;
+    }
+    case CubicTag: {
+        double c[10];
+        for (int i = 0; i < 10; ++i)
+            stream >> c[i];
+        ret = new CubicImp(CubicCartesianData(c));
+        break;
+    }
+    case TextTag:
+    case NumericTextTag:
+    case BoolTextTag: {
+        QString text;
+        stream >> text;
+        Coordinate loc = readCoordinate(stream);
+        bool frame = false;
+        stream >> frame;
+        if (tag == NumericTextTag) {
+            double value = 0.;
+            stream >> value;
+            ret = new NumericTextImp(text, loc, frame, value);
+        } else if (tag == BoolTextTag) {
+            bool value = false;
+            stream >> value;
+            ret = new BoolTextImp(text, loc, frame, value);
+        } else
+            ret = new TextImp(text, loc, frame);
+        break;
+    }
+    case FilledPolygonTag:
+        ret = new FilledPolygonImp(readCoordinates(stream));
+        break;
+    case ClosedPolygonalTag:
+        ret = new ClosedPolygonalImp(readCoordinates(stream));
+        break;
+    case OpenPolygonalTag:
+        ret = new OpenPolygonalImp(readCoordinates(stream));
+        break;
+    case BezierTag:
+        ret = new BezierImp(readCoordinates(stream));
+        break;
+    case RationalBezierTag: {
+        const std::vector<Coordinate> points = readCoordinates(stream);
+        const std::vector<double> weights = readDoubles(stream);
+        if (points.size() != weights.size())
+            return nullptr;
+        ret = new RationalBezierImp(points, weights);
+        break;
+    }
+    case LocusTag: {
+        ObjectImp *curve = deserialize(stream);
+        if (!curve || !curve->inherits(CurveImp::stype())) {
+            delete curve;
+            return nullptr;
+        }
+        QByteArray xml;
+        quint32 n = 0;
+        stream >> xml >> n;
+        QDomDocument doc;
+        QString error;
+        ObjectHierarchy *hier = nullptr;
+        if (stream.status() == QDataStream::Ok && doc.setContent(xml))
+            hier = ObjectHierarchy::buildSafeObjectHierarchy(doc.documentElement(), error);
+        if (!hier) {
+            delete curve;
+            return nullptr;
+        }
+        LocusImp *locus = new LocusImp(static_cast<CurveImp *>(curve), *hier);
+        delete hier;
+        locus->setRestored();
+        LocusImp::CachedPoints points;
+        for (quint32 i = 0; i < n && stream.status() == QDataStream::Ok; ++i) {
+            double t = 0.;
+            stream >> t;
+            const Coordinate p = readCoordinate(stream);
+            points.push_back(std::make_pair(t, p));
+        }
+        locus->addCachedPoints(points);
+        ret = locus;
+        break;
+    }
+    default:
+        return nullptr;
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        delete ret;
+        return nullptr;
+    }
+    return ret;
+}
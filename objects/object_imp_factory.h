@@ -6,6 +6,8 @@
 
 #include "common.h"
 
+class QDataStream;
+
 class ObjectImpFactory
 {
     ObjectImpFactory();
@@ -22,4 +24,25 @@ public:
      * adds data to \p parent , and returns a type string.
      */
     QString serialize(const ObjectImp &d, QDomElement &parent, QDomDocument &doc) const;
+
+    /**
+     * returns whether \p d can be written by serialize( const ObjectImp&,
+     * QDataStream& ).  This is true for InvalidImp and all the "plain
+     * data" imp types, but not for imps that refer to other structures,
+     * like LocusImp or HierarchyImp.
+     */
+    bool canSerialize(const ObjectImp &d) const;
+    /**
+     * writes \p d to \p stream in a compact binary form.  Unlike the XML
+     * form above, this is lossless for every supported type ( e.g. it
+     * also keeps the position of angles and vectors ).  Returns false
+     * and writes nothing if !canSerialize( d ).
+     */
+    bool serialize(const ObjectImp &d, QDataStream &stream) const;
+    /**
+     * reads an ObjectImp written by serialize( const ObjectImp&,
+     * QDataStream& ) from \p stream.  Returns 0 if the data is
+     * corrupt.
+     */
+    ObjectImp *deserialize(QDataStream &stream) const;
 };
@@ -72,6 +72,30 @@ bool ObjectType::isTransform() const
     return false;
 }
 
+bool ObjectType::isThreadSafe() const
+{
+    return true;
+}
+
+bool ObjectType::hasCalcMany() const
+{
+    return false;
+}
+
+std::vector<ObjectImp *> ObjectType::calcMany(const std::vector<Args> &parents, const KigDocument &d) const
+{
+    std::vector<ObjectImp *> ret;
+    ret.reserve(parents.size());
+    for (std::vector<Args>::const_iterator i = parents.begin(); i != parents.end(); ++i)
+        ret.push_back(calc(*i, d));
+    return ret;
+}
+
+ObjectImp *ObjectType::calcInto(const Args &parents, const KigDocument &d, ObjectImp *) const
+{
+    return calc(parents, d);
+}
+
 QStringList ObjectType::specialActions() const
 {
     return QStringList();
@@ -30,6 +30,14 @@ public:
     virtual bool inherits(int type) const;
 
     virtual ObjectImp *calc(const Args &parents, const KigDocument &d) const = 0;
+    /**
+     * Like calc(), but \p old is the previous result of this type for
+     * the same object.  If the new result has the same ObjectImp type,
+     * a type can update \p old in place and return it instead of
+     * allocating a new ObjectImp.  Otherwise, the new result is returned
+     * and the caller deletes \p old.  The default just calls calc().
+     */
+    virtual ObjectImp *calcInto(const Args &parents, const KigDocument &d, ObjectImp *old) const;
 
     virtual bool canMove(const ObjectTypeCalcer &ourobj) const;
     virtual bool isFreelyTranslatable(const ObjectTypeCalcer &ourobj) const;
@@ -73,6 +81,29 @@ public:
      */
     virtual bool isTransform() const;
 
+    /**
+     * Whether calc() may be called for several objects of this type at
+     * the same time, from different threads ( see calcAll() ).  Types
+     * whose calc() depends on some global state that is not protected,
+     * like the Python script types, should return false.  The default
+     * is true.
+     */
+    virtual bool isThreadSafe() const;
+
+    /**
+     * Whether calcMany() calculates several objects of this type faster
+     * than calling calc() for each of them.  calcAll() then hands all
+     * objects of this type that don't depend on each other to one
+     * calcMany() call, on the calling thread.  The default is false.
+     */
+    virtual bool hasCalcMany() const;
+    /**
+     * Calculate the objects with the parents in \p parents at once,
+     * none of them depends on another.  The default calls calc() for
+     * each of them.
+     */
+    virtual std::vector<ObjectImp *> calcMany(const std::vector<Args> &parents, const KigDocument &d) const;
+
     // ObjectType's can define some special actions, that are strictly
     // specific to the type at hand.  E.g. a text label allows to toggle
     // the display of a frame around the text.  Constrained and fixed
@@ -6,6 +6,7 @@
 
 #include "bogus_imp.h"
 #include "locus_imp.h"
+#include "object_imp_factory.h"
 #include "point_imp.h"
 
 #include "../kig/kig_commands.h"
@@ -15,6 +16,10 @@
 #include "../misc/common.h"
 #include "../misc/goniometry.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <qdom.h>
+
 #include <algorithm>
 #include <cmath>
 #include <functional>
@@ -56,6 +61,49 @@ ObjectImp *LocusType::calc(const Args &args, const KigDocument &) const
     return new LocusImp(curveimp->copy(), hier.withFixedArgs(fixedargs));
 }
 
+// a hash of the arguments of a locus, see LocusImp::key().  The data is
+// hashed in its binary form, since the XML form drops digits.  Returns
+// an empty array if one of the arguments has no binary form.
+static QByteArray locusKey(const Args &args)
+{
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    QDomDocument doc;
+    QDomElement e = doc.createElement(QStringLiteral("Hierarchy"));
+    static_cast<const HierarchyImp *>(args[0])->data().serialize(e, doc);
+    doc.appendChild(e);
+    h.addData(doc.toByteArray(-1));
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    for (Args::const_iterator i = args.begin() + 1; i != args.end(); ++i) {
+        // the binary form of a locus has its cached points, which
+        // don't change what it is..
+        if ((*i)->inherits(LocusImp::stype())) {
+            const QByteArray &key = static_cast<const LocusImp *>(*i)->key();
+            if (key.isEmpty())
+                return QByteArray();
+            out << key;
+        } else if (!ObjectImpFactory::instance()->serialize(**i, out))
+            return QByteArray();
+    }
+    h.addData(data);
+    return h.result();
+}
+
+ObjectImp *LocusType::calcInto(const Args &args, const KigDocument &doc, ObjectImp *old) const
+{
+    ObjectImp *ret = calc(args, doc);
+    if (!ret->inherits(LocusImp::stype()))
+        return ret;
+    // sampling a locus is expensive, so if its arguments didn't change,
+    // we keep the points the old one has..
+    LocusImp *locus = static_cast<LocusImp *>(ret);
+    locus->setKey(locusKey(args));
+    if (old && old->inherits(LocusImp::stype()))
+        locus->takeCachedPoints(*static_cast<LocusImp *>(old));
+    return ret;
+}
+
 bool LocusType::inherits(int type) const
 {
     return type == ID_LocusType ? true : Parent::inherits(type);
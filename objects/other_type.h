@@ -17,6 +17,7 @@ public:
     static const LocusType *instance();
 
     ObjectImp *calc(const Args &args, const KigDocument &) const override;
+    ObjectImp *calcInto(const Args &args, const KigDocument &, ObjectImp *old) const override;
 
     const ObjectImpType *impRequirement(const ObjectImp *o, const Args &parents) const override;
 
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "../misc/coordinate.h"
+#include "imp_allocator.h"
 #include "object_imp.h"
 
 /**
@@ -15,6 +16,8 @@ class PointImp : public ObjectImp
     Coordinate mc;
 
 public:
+    KIG_IMP_ALLOCATOR
+
     typedef ObjectImp Parent;
     /**
      * Returns the ObjectImpType representing PointImp's.
@@ -37,7 +37,23 @@ FixedPointType::~FixedPointType()
 {
 }
 
-ObjectImp *FixedPointType::calc(const Args &parents, const KigDocument &) const
+// the calcInto() of the point types below: old is updated in place if
+// it is a point of the same type ( and not e.g. an InvalidImp )..
+static ObjectImp *pointInto(ObjectImp *old, const Coordinate &c)
+{
+    if (old && old->type() == PointImp::stype()) {
+        static_cast<PointImp *>(old)->setCoordinate(c);
+        return old;
+    }
+    return new PointImp(c);
+}
+
+ObjectImp *FixedPointType::calc(const Args &parents, const KigDocument &doc) const
+{
+    return calcInto(parents, doc, nullptr);
+}
+
+ObjectImp *FixedPointType::calcInto(const Args &parents, const KigDocument &, ObjectImp *old) const
 {
     if (!margsparser.checkArgs(parents))
         return new InvalidImp;
@@ -45,7 +61,7 @@ ObjectImp *FixedPointType::calc(const Args &parents, const KigDocument &) const
     double a = static_cast<const DoubleImp *>(parents[0])->data();
     double b = static_cast<const DoubleImp *>(parents[1])->data();
 
-    return new PointImp(Coordinate(a, b));
+    return pointInto(old, Coordinate(a, b));
 }
 
 static const ArgsParser::spec argsspecRelativePoint[] = {{DoubleImp::stype(), "relative-x", "SHOULD NOT BE SEEN", false},
@@ -63,7 +79,12 @@ RelativePointType::~RelativePointType()
 {
 }
 
-ObjectImp *RelativePointType::calc(const Args &parents, const KigDocument &) const
+ObjectImp *RelativePointType::calc(const Args &parents, const KigDocument &doc) const
+{
+    return calcInto(parents, doc, nullptr);
+}
+
+ObjectImp *RelativePointType::calcInto(const Args &parents, const KigDocument &, ObjectImp *old) const
 {
     if (!margsparser.checkArgs(parents))
         return new InvalidImp;
@@ -74,7 +95,7 @@ ObjectImp *RelativePointType::calc(const Args &parents, const KigDocument &) con
     double a = static_cast<const DoubleImp *>(parents[0])->data();
     double b = static_cast<const DoubleImp *>(parents[1])->data();
 
-    return new PointImp(reference + Coordinate(a, b));
+    return pointInto(old, reference + Coordinate(a, b));
 }
 
 KIG_INSTANTIATE_OBJECT_TYPE_INSTANCE(CursorPointType)
@@ -94,13 +115,22 @@ const CursorPointType *CursorPointType::instance()
     return &t;
 }
 
-ObjectImp *CursorPointType::calc(const Args &parents, const KigDocument &) const
+ObjectImp *CursorPointType::calc(const Args &parents, const KigDocument &doc) const
+{
+    return calcInto(parents, doc, nullptr);
+}
+
+ObjectImp *CursorPointType::calcInto(const Args &parents, const KigDocument &, ObjectImp *old) const
 {
     assert(parents[0]->inherits(DoubleImp::stype()));
     assert(parents[1]->inherits(DoubleImp::stype()));
     double a = static_cast<const DoubleImp *>(parents[0])->data();
     double b = static_cast<const DoubleImp *>(parents[1])->data();
 
+    if (old && old->type() == BogusPointImp::stype()) {
+        static_cast<BogusPointImp *>(old)->setCoordinate(Coordinate(a, b));
+        return old;
+    }
     return new BogusPointImp(Coordinate(a, b));
 }
 
@@ -110,6 +140,11 @@ const ObjectImpType *CursorPointType::resultId() const
 }
 
 ObjectImp *ConstrainedPointType::calc(const Args &parents, const KigDocument &doc) const
+{
+    return calcInto(parents, doc, nullptr);
+}
+
+ObjectImp *ConstrainedPointType::calcInto(const Args &parents, const KigDocument &doc, ObjectImp *old) const
 {
     if (!margsparser.checkArgs(parents))
         return new InvalidImp;
@@ -118,7 +153,7 @@ ObjectImp *ConstrainedPointType::calc(const Args &parents, const KigDocument &do
     const Coordinate nc = static_cast<const CurveImp *>(parents[1])->getPoint(param, doc);
     doc.mcachedparam = param;
     if (nc.valid())
-        return new PointImp(nc);
+        return pointInto(old, nc);
     else
         return new InvalidImp;
 }
@@ -21,6 +21,7 @@ public:
     bool inherits(int type) const override;
 
     ObjectImp *calc(const Args &parents, const KigDocument &) const override;
+    ObjectImp *calcInto(const Args &parents, const KigDocument &, ObjectImp *old) const override;
     bool canMove(const ObjectTypeCalcer &ourobj) const override;
     bool isFreelyTranslatable(const ObjectTypeCalcer &ourobj) const override;
     std::vector<ObjectCalcer *> movableParents(const ObjectTypeCalcer &ourobj) const override;
@@ -43,6 +44,7 @@ public:
     static const RelativePointType *instance();
 
     ObjectImp *calc(const Args &parents, const KigDocument &) const override;
+    ObjectImp *calcInto(const Args &parents, const KigDocument &, ObjectImp *old) const override;
     bool canMove(const ObjectTypeCalcer &ourobj) const override;
     bool isFreelyTranslatable(const ObjectTypeCalcer &ourobj) const override;
     std::vector<ObjectCalcer *> movableParents(const ObjectTypeCalcer &ourobj) const override;
@@ -82,6 +84,7 @@ class CursorPointType : public ObjectType
 public:
     static const CursorPointType *instance();
     ObjectImp *calc(const Args &parents, const KigDocument &) const override;
+    ObjectImp *calcInto(const Args &parents, const KigDocument &, ObjectImp *old) const override;
 
     const ObjectImpType *impRequirement(const ObjectImp *o, const Args &parents) const override;
     bool isDefinedOnOrThrough(const ObjectImp *o, const Args &parents) const override;
@@ -103,6 +106,7 @@ public:
     bool inherits(int type) const override;
 
     ObjectImp *calc(const Args &parents, const KigDocument &) const override;
+    ObjectImp *calcInto(const Args &parents, const KigDocument &, ObjectImp *old) const override;
 
     bool canMove(const ObjectTypeCalcer &ourobj) const override;
     bool isFreelyTranslatable(const ObjectTypeCalcer &ourobj) const override;
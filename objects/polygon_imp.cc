@@ -30,14 +30,22 @@
 
 #include <cmath>
 
+std::shared_ptr<const AbstractPolygonImp::Data> AbstractPolygonImp::makeData(const uint npoints, const std::vector<Coordinate> &points, const Coordinate &centerofmass)
+{
+    std::shared_ptr<Data> ret = std::make_shared<Data>();
+    ret->npoints = npoints;
+    ret->points = points;
+    ret->centerofmass = centerofmass;
+    ret->boundrect = Rect::boundingRect(points);
+    return ret;
+}
+
 AbstractPolygonImp::AbstractPolygonImp(const uint npoints, const std::vector<Coordinate> &points, const Coordinate &centerofmass)
-    : mnpoints(npoints)
-    , mpoints(points)
-    , mcenterofmass(centerofmass)
+    : md(makeData(npoints, points, centerofmass))
 {
 }
 
-AbstractPolygonImp::AbstractPolygonImp(const std::vector<Coordinate> &points)
+static Coordinate calcCenterOfMass(const std::vector<Coordinate> &points)
 {
     uint npoints = points.size();
     Coordinate centerofmassn = Coordinate(0, 0);
@@ -45,9 +53,17 @@ AbstractPolygonImp::AbstractPolygonImp(const std::vector<Coordinate> &points)
     for (uint i = 0; i < npoints; ++i) {
         centerofmassn += points[i];
     }
-    mpoints = points;
-    mcenterofmass = centerofmassn / npoints;
-    mnpoints = npoints;
+    return centerofmassn / npoints;
+}
+
+AbstractPolygonImp::AbstractPolygonImp(const std::vector<Coordinate> &points)
+    : md(makeData(points.size(), points, calcCenterOfMass(points)))
+{
+}
+
+AbstractPolygonImp::AbstractPolygonImp(const std::shared_ptr<const Data> &data)
+    : md(data)
+{
 }
 
 AbstractPolygonImp::~AbstractPolygonImp()
@@ -56,7 +72,7 @@ AbstractPolygonImp::~AbstractPolygonImp()
 
 Coordinate AbstractPolygonImp::attachPoint() const
 {
-    return mcenterofmass;
+    return md->centerofmass;
 }
 
 std::vector<Coordinate> AbstractPolygonImp::ptransform(const Transformation &t) const
@@ -80,8 +96,8 @@ std::vector<Coordinate> AbstractPolygonImp::ptransform(const Transformation &t)
     {
         double maxp = -1.0;
         double minp = 1.0;
-        for (uint i = 0; i < mpoints.size(); ++i) {
-            double p = t.getProjectiveIndicator(mpoints[i]);
+        for (uint i = 0; i < md->points.size(); ++i) {
+            double p = t.getProjectiveIndicator(md->points[i]);
             if (p > maxp)
                 maxp = p;
             if (p < minp)
@@ -90,8 +106,8 @@ std::vector<Coordinate> AbstractPolygonImp::ptransform(const Transformation &t)
         if (maxp > 0 && minp < 0)
             return np;
     }
-    for (uint i = 0; i < mpoints.size(); ++i) {
-        Coordinate nc = t.apply(mpoints[i]);
+    for (uint i = 0; i < md->points.size(); ++i) {
+        Coordinate nc = t.apply(md->points[i]);
         if (!nc.valid())
             return np;
         np.push_back(nc);
@@ -102,7 +118,7 @@ std::vector<Coordinate> AbstractPolygonImp::ptransform(const Transformation &t)
 ObjectImp *FilledPolygonImp::transform(const Transformation &t) const
 {
     std::vector<Coordinate> np = ptransform(t);
-    if (np.size() != mnpoints)
+    if (np.size() != md->npoints)
         return new InvalidImp;
     return new FilledPolygonImp(np);
 }
@@ -110,7 +126,7 @@ ObjectImp *FilledPolygonImp::transform(const Transformation &t) const
 ObjectImp *ClosedPolygonalImp::transform(const Transformation &t) const
 {
     std::vector<Coordinate> np = ptransform(t);
-    if (np.size() != mnpoints)
+    if (np.size() != md->npoints)
         return new InvalidImp;
     return new ClosedPolygonalImp(np);
 }
@@ -118,7 +134,7 @@ ObjectImp *ClosedPolygonalImp::transform(const Transformation &t) const
 ObjectImp *OpenPolygonalImp::transform(const Transformation &t) const
 {
     std::vector<Coordinate> np = ptransform(t);
-    if (np.size() != mnpoints)
+    if (np.size() != md->npoints)
         return new InvalidImp;
     return new OpenPolygonalImp(np);
 }
@@ -133,10 +149,10 @@ bool AbstractPolygonImp::isInPolygon(const Coordinate &p) const
     double cx = p.x;
     double cy = p.y;
 
-    Coordinate prevpoint = mpoints.back();
-    bool prevpointbelow = mpoints.back().y >= cy;
-    for (uint i = 0; i < mpoints.size(); ++i) {
-        Coordinate point = mpoints[i];
+    Coordinate prevpoint = md->points.back();
+    bool prevpointbelow = md->points.back().y >= cy;
+    for (uint i = 0; i < md->points.size(); ++i) {
+        Coordinate point = md->points[i];
         bool pointbelow = point.y >= cy;
         if (prevpointbelow != pointbelow) {
             // possibility of intersection: points on different side from
@@ -172,9 +188,9 @@ bool AbstractPolygonImp::isInPolygon(const Coordinate &p) const
 
 bool AbstractPolygonImp::isOnCPolygonBorder(const Coordinate &p, double dist, const KigDocument &doc) const
 {
-    uint reduceddim = mpoints.size() - 1;
+    uint reduceddim = md->points.size() - 1;
 
-    if (isOnSegment(p, mpoints[reduceddim], mpoints[0], dist))
+    if (isOnSegment(p, md->points[reduceddim], md->points[0], dist))
         return true;
 
     return isOnOPolygonBorder(p, dist, doc);
@@ -183,9 +199,9 @@ bool AbstractPolygonImp::isOnCPolygonBorder(const Coordinate &p, double dist, co
 bool AbstractPolygonImp::isOnOPolygonBorder(const Coordinate &p, double dist, const KigDocument &) const
 {
     bool ret = false;
-    uint reduceddim = mpoints.size() - 1;
+    uint reduceddim = md->points.size() - 1;
     for (uint i = 0; i < reduceddim; ++i) {
-        ret |= isOnSegment(p, mpoints[i], mpoints[i + 1], dist);
+        ret |= isOnSegment(p, md->points[i], md->points[i + 1], dist);
     }
 
     return ret;
@@ -194,14 +210,14 @@ bool AbstractPolygonImp::isOnOPolygonBorder(const Coordinate &p, double dist, co
 bool AbstractPolygonImp::inRect(const Rect &r, int width, const KigWidget &w) const
 {
     bool ret = false;
-    uint reduceddim = mpoints.size() - 1;
+    uint reduceddim = md->points.size() - 1;
     for (uint i = 0; !ret && i < reduceddim; ++i) {
-        SegmentImp s(mpoints[i], mpoints[i + 1]);
-        ret = lineInRect(r, mpoints[i], mpoints[i + 1], width, &s, w);
+        SegmentImp s(md->points[i], md->points[i + 1]);
+        ret = lineInRect(r, md->points[i], md->points[i + 1], width, &s, w);
     }
     if (!ret) {
-        SegmentImp s(mpoints[reduceddim], mpoints[0]);
-        ret = lineInRect(r, mpoints[reduceddim], mpoints[0], width, &s, w);
+        SegmentImp s(md->points[reduceddim], md->points[0]);
+        ret = lineInRect(r, md->points[reduceddim], md->points[0], width, &s, w);
     }
 
     return ret;
@@ -449,7 +465,7 @@ ObjectImp *FilledPolygonImp::property(int which, const KigDocument &w) const
         return Parent::property(which, w);
     else if (which == Parent::numberOfProperties()) {
         // number of sides
-        return new IntImp(mnpoints);
+        return new IntImp(md->npoints);
     } else if (which == Parent::numberOfProperties() + 1) {
         // perimeter
         return new DoubleImp(cperimeter());
@@ -461,11 +477,11 @@ ObjectImp *FilledPolygonImp::property(int which, const KigDocument &w) const
             return new InvalidImp;
         return new DoubleImp(fabs(area()));
     } else if (which == Parent::numberOfProperties() + 3) {
-        return new ClosedPolygonalImp(mpoints); // polygon boundary
+        return new ClosedPolygonalImp(md); // polygon boundary
     } else if (which == Parent::numberOfProperties() + 4) {
-        return new OpenPolygonalImp(mpoints); // open polygonal curve
+        return new OpenPolygonalImp(md); // open polygonal curve
     } else if (which == Parent::numberOfProperties() + 5) {
-        return new PointImp(mcenterofmass);
+        return new PointImp(md->centerofmass);
     } else if (which == Parent::numberOfProperties() + 6) {
         // winding number
         return new IntImp(windingNumber());
@@ -481,7 +497,7 @@ ObjectImp *ClosedPolygonalImp::property(int which, const KigDocument &w) const
         return Parent::property(which, w);
     else if (which == Parent::numberOfProperties()) {
         // number of sides
-        return new IntImp(mnpoints);
+        return new IntImp(md->npoints);
     } else if (which == Parent::numberOfProperties() + 1) {
         // perimeter
         return new DoubleImp(cperimeter());
@@ -493,11 +509,11 @@ ObjectImp *ClosedPolygonalImp::property(int which, const KigDocument &w) const
             return new InvalidImp;
         return new DoubleImp(fabs(area()));
     } else if (which == Parent::numberOfProperties() + 3) {
-        return new FilledPolygonImp(mpoints); // filled polygon
+        return new FilledPolygonImp(md); // filled polygon
     } else if (which == Parent::numberOfProperties() + 4) {
-        return new OpenPolygonalImp(mpoints); // open polygonal curve
+        return new OpenPolygonalImp(md); // open polygonal curve
     } else if (which == Parent::numberOfProperties() + 5) {
-        return new PointImp(mcenterofmass);
+        return new PointImp(md->centerofmass);
     } else if (which == Parent::numberOfProperties() + 6) {
         // winding number
         return new IntImp(windingNumber());
@@ -513,43 +529,43 @@ ObjectImp *OpenPolygonalImp::property(int which, const KigDocument &w) const
         return Parent::property(which, w);
     else if (which == Parent::numberOfProperties()) {
         // number of sides
-        return new IntImp(mnpoints - 1);
+        return new IntImp(md->npoints - 1);
     } else if (which == Parent::numberOfProperties() + 1) {
         // perimeter
         return new DoubleImp(operimeter());
     } else if (which == Parent::numberOfProperties() + 2) {
-        return new BezierImp(mpoints); // bezier curve
+        return new BezierImp(md->points); // bezier curve
     } else if (which == Parent::numberOfProperties() + 3) {
-        return new FilledPolygonImp(mpoints); // filled polygon
+        return new FilledPolygonImp(md); // filled polygon
     } else if (which == Parent::numberOfProperties() + 4) {
-        return new ClosedPolygonalImp(mpoints); // polygon boundary
+        return new ClosedPolygonalImp(md); // polygon boundary
     } else
         assert(false);
     return new InvalidImp;
 }
 
-const std::vector<Coordinate> AbstractPolygonImp::points() const
+const std::vector<Coordinate> &AbstractPolygonImp::points() const
 {
-    return mpoints;
+    return md->points;
 }
 
 uint AbstractPolygonImp::npoints() const
 {
-    return mnpoints;
+    return md->npoints;
 }
 
 double AbstractPolygonImp::operimeter() const
 {
     double perimeter = 0.;
-    for (uint i = 0; i < mpoints.size() - 1; ++i) {
-        perimeter += (mpoints[i + 1] - mpoints[i]).length();
+    for (uint i = 0; i < md->points.size() - 1; ++i) {
+        perimeter += (md->points[i + 1] - md->points[i]).length();
     }
     return perimeter;
 }
 
 double AbstractPolygonImp::cperimeter() const
 {
-    return operimeter() + (mpoints[0] - mpoints[mpoints.size() - 1]).length();
+    return operimeter() + (md->points[0] - md->points[md->points.size() - 1]).length();
 }
 
 /*
@@ -561,9 +577,9 @@ double AbstractPolygonImp::cperimeter() const
 double AbstractPolygonImp::area() const
 {
     double surface2 = 0.0;
-    Coordinate prevpoint = mpoints.back();
-    for (uint i = 0; i < mpoints.size(); ++i) {
-        Coordinate point = mpoints[i];
+    Coordinate prevpoint = md->points.back();
+    for (uint i = 0; i < md->points.size(); ++i) {
+        Coordinate point = md->points[i];
         surface2 += (point.x - prevpoint.x) * (point.y + prevpoint.y);
         prevpoint = point;
     }
@@ -572,17 +588,17 @@ double AbstractPolygonImp::area() const
 
 FilledPolygonImp *FilledPolygonImp::copy() const
 {
-    return new FilledPolygonImp(mpoints);
+    return new FilledPolygonImp(md);
 }
 
 ClosedPolygonalImp *ClosedPolygonalImp::copy() const
 {
-    return new ClosedPolygonalImp(mpoints);
+    return new ClosedPolygonalImp(md);
 }
 
 OpenPolygonalImp *OpenPolygonalImp::copy() const
 {
-    return new OpenPolygonalImp(mpoints);
+    return new OpenPolygonalImp(md);
 }
 
 void FilledPolygonImp::visit(ObjectImpVisitor *vtor) const
@@ -602,7 +618,7 @@ void OpenPolygonalImp::visit(ObjectImpVisitor *vtor) const
 
 bool AbstractPolygonImp::equals(const ObjectImp &rhs) const
 {
-    return rhs.inherits(AbstractPolygonImp::stype()) && static_cast<const AbstractPolygonImp &>(rhs).points() == mpoints;
+    return rhs.inherits(AbstractPolygonImp::stype()) && static_cast<const AbstractPolygonImp &>(rhs).points() == md->points;
 }
 
 const ObjectImpType *AbstractPolygonImp::stype()
@@ -708,7 +724,7 @@ const ObjectImpType *FilledPolygonImp::stype4()
 
 const ObjectImpType *FilledPolygonImp::type() const
 {
-    uint n = mnpoints;
+    uint n = md->npoints;
 
     if (n == 3)
         return FilledPolygonImp::stype3();
@@ -761,11 +777,7 @@ bool OpenPolygonalImp::isPropertyDefinedOnOrThroughThisImp(int which) const
 
 Rect AbstractPolygonImp::surroundingRect() const
 {
-    Rect r(0., 0., 0., 0.);
-    for (uint i = 0; i < mpoints.size(); ++i) {
-        r.setContains(mpoints[i]);
-    }
-    return r;
+    return md->boundrect;
 }
 
 int AbstractPolygonImp::windingNumber() const
@@ -781,13 +793,13 @@ int AbstractPolygonImp::windingNumber() const
      */
 
     int winding = 0;
-    uint npoints = mpoints.size();
-    Coordinate prevside = mpoints[0] - mpoints[npoints - 1];
+    uint npoints = md->points.size();
+    Coordinate prevside = md->points[0] - md->points[npoints - 1];
     for (uint i = 0; i < npoints; ++i) {
         uint nexti = i + 1;
         if (nexti >= npoints)
             nexti = 0;
-        Coordinate side = mpoints[nexti] - mpoints[i];
+        Coordinate side = md->points[nexti] - md->points[i];
         double vecprod = side.x * prevside.y - side.y * prevside.x;
         int steeringdir = (vecprod > 0) ? 1 : -1;
         if (vecprod == 0.0 || side.y * prevside.y > 0) {
@@ -812,11 +824,11 @@ bool AbstractPolygonImp::isTwisted() const
     double abx, aby, cdx, cdy, acx, acy, adx, ady, cax, cay, cbx, cby;
     bool pointbelow, prevpointbelow;
 
-    if (mpoints.size() <= 3)
+    if (md->points.size() <= 3)
         return false;
-    ia = mpoints.end() - 1;
+    ia = md->points.end() - 1;
 
-    for (ib = mpoints.begin(); ib + 1 != mpoints.end(); ++ib) {
+    for (ib = md->points.begin(); ib + 1 != md->points.end(); ++ib) {
         abx = ib->x - ia->x;
         aby = ib->y - ia->y;
         ic = ib + 1;
@@ -824,7 +836,7 @@ bool AbstractPolygonImp::isTwisted() const
         acy = ic->y - ia->y;
         prevpointbelow = (abx * acy <= aby * acx);
 
-        for (id = ib + 2; id != mpoints.end(); ++id) {
+        for (id = ib + 2; id != md->points.end(); ++id) {
             if (id == ia)
                 break;
             adx = id->x - ia->x;
@@ -856,14 +868,14 @@ bool AbstractPolygonImp::isMonotoneSteering() const
      * steering is always in the same direction
      */
 
-    uint npoints = mpoints.size();
-    Coordinate prevside = mpoints[0] - mpoints[npoints - 1];
+    uint npoints = md->points.size();
+    Coordinate prevside = md->points[0] - md->points[npoints - 1];
     int prevsteeringdir = 0;
     for (uint i = 0; i < npoints; ++i) {
         uint nexti = i + 1;
         if (nexti >= npoints)
             nexti = 0;
-        Coordinate side = mpoints[nexti] - mpoints[i];
+        Coordinate side = md->points[nexti] - md->points[i];
         double vecprod = side.x * prevside.y - side.y * prevside.x;
         int steeringdir = (vecprod > 0) ? 1 : -1;
         if (vecprod == 0.0) {
@@ -898,9 +910,14 @@ FilledPolygonImp::FilledPolygonImp(const std::vector<Coordinate> &points)
 {
 }
 
+FilledPolygonImp::FilledPolygonImp(const std::shared_ptr<const Data> &data)
+    : AbstractPolygonImp(data)
+{
+}
+
 void FilledPolygonImp::draw(KigPainter &p) const
 {
-    p.drawPolygon(mpoints);
+    p.drawPolygon(md->points);
 }
 
 bool FilledPolygonImp::contains(const Coordinate &p, int, const KigWidget &) const
@@ -913,11 +930,16 @@ ClosedPolygonalImp::ClosedPolygonalImp(const std::vector<Coordinate> &points)
 {
 }
 
+ClosedPolygonalImp::ClosedPolygonalImp(const std::shared_ptr<const Data> &data)
+    : AbstractPolygonImp(data)
+{
+}
+
 void ClosedPolygonalImp::draw(KigPainter &p) const
 {
-    for (unsigned int i = 0; i < mnpoints - 1; i++)
-        p.drawSegment(mpoints[i], mpoints[i + 1]);
-    p.drawSegment(mpoints[mnpoints - 1], mpoints[0]);
+    for (unsigned int i = 0; i < md->npoints - 1; i++)
+        p.drawSegment(md->points[i], md->points[i + 1]);
+    p.drawSegment(md->points[md->npoints - 1], md->points[0]);
 }
 
 bool ClosedPolygonalImp::contains(const Coordinate &p, int width, const KigWidget &w) const
@@ -930,10 +952,15 @@ OpenPolygonalImp::OpenPolygonalImp(const std::vector<Coordinate> &points)
 {
 }
 
+OpenPolygonalImp::OpenPolygonalImp(const std::shared_ptr<const Data> &data)
+    : AbstractPolygonImp(data)
+{
+}
+
 void OpenPolygonalImp::draw(KigPainter &p) const
 {
-    for (unsigned int i = 0; i < mnpoints - 1; i++)
-        p.drawSegment(mpoints[i], mpoints[i + 1]);
+    for (unsigned int i = 0; i < md->npoints - 1; i++)
+        p.drawSegment(md->points[i], md->points[i + 1]);
 }
 
 bool OpenPolygonalImp::contains(const Coordinate &p, int width, const KigWidget &w) const
@@ -5,7 +5,9 @@
 #pragma once
 
 #include "../misc/coordinate.h"
+#include "../misc/rect.h"
 #include "object_imp.h"
+#include <memory>
 #include <vector>
 
 /**
@@ -14,11 +16,26 @@
 class AbstractPolygonImp : public ObjectImp
 {
 protected:
-    uint mnpoints;
-    std::vector<Coordinate> mpoints;
-    //  bool minside;   // true: filled polygon, false: polygon boundary
-    //  bool mopen;     // true: polygonal curve (minside must be false)
-    Coordinate mcenterofmass;
+    /**
+     * The points of a polygon, together with the things we calculate
+     * from them once.  This is never changed after construction, so
+     * copies of a polygon ( and there are many: every ObjectConstCalcer,
+     * locus and macro calculation makes one ) simply share it..
+     */
+    struct Data {
+        uint npoints;
+        std::vector<Coordinate> points;
+        //  bool minside;   // true: filled polygon, false: polygon boundary
+        //  bool mopen;     // true: polygonal curve (minside must be false)
+        Coordinate centerofmass;
+        // surroundingRect(), calculated once, since it is used for every
+        // redraw..
+        Rect boundrect;
+    };
+    std::shared_ptr<const Data> md;
+
+    static std::shared_ptr<const Data> makeData(const uint npoints, const std::vector<Coordinate> &points, const Coordinate &centerofmass);
+    explicit AbstractPolygonImp(const std::shared_ptr<const Data> &data);
 
 public:
     typedef ObjectImp Parent;
@@ -51,7 +68,7 @@ public:
     /**
      * Returns the vector with polygon points.
      */
-    const std::vector<Coordinate> points() const;
+    const std::vector<Coordinate> &points() const;
     /**
      * Returns the center of mass of the polygon.
      */
@@ -88,6 +105,10 @@ class FilledPolygonImp : public AbstractPolygonImp
 public:
     typedef AbstractPolygonImp Parent;
     explicit FilledPolygonImp(const std::vector<Coordinate> &points);
+    /**
+     * Constructs a polygon sharing the points of another one.
+     */
+    explicit FilledPolygonImp(const std::shared_ptr<const Data> &data);
     static const ObjectImpType *stype();
     static const ObjectImpType *stype3();
     static const ObjectImpType *stype4();
@@ -116,6 +137,10 @@ class ClosedPolygonalImp : public AbstractPolygonImp
 public:
     typedef AbstractPolygonImp Parent;
     explicit ClosedPolygonalImp(const std::vector<Coordinate> &points);
+    /**
+     * Constructs a polygon sharing the points of another one.
+     */
+    explicit ClosedPolygonalImp(const std::shared_ptr<const Data> &data);
     static const ObjectImpType *stype();
     ObjectImp *transform(const Transformation &) const override;
     void draw(KigPainter &p) const override;
@@ -142,6 +167,10 @@ class OpenPolygonalImp : public AbstractPolygonImp
 public:
     typedef AbstractPolygonImp Parent;
     explicit OpenPolygonalImp(const std::vector<Coordinate> &points);
+    /**
+     * Constructs a polygon sharing the points of another one.
+     */
+    explicit OpenPolygonalImp(const std::shared_ptr<const Data> &data);
     static const ObjectImpType *stype();
     ObjectImp *transform(const Transformation &) const override;
     void draw(KigPainter &p) const override;
@@ -7,6 +7,8 @@
 #include "../misc/kigpainter.h"
 #include "bogus_imp.h"
 
+#include <QMutex>
+
 TextImp::TextImp(const QString &text, const Coordinate &loc, bool frame)
     : mtext(text)
     , mloc(loc)
@@ -35,10 +37,18 @@ ObjectImp *TextImp::transform(const Transformation &t) const
     return new TextImp(mtext, nloc, mframe);
 }
 
+// the image exporter draws from several threads at once, see
+// TiledImageWriter
+static QMutex boundRectMutex;
+
 void TextImp::draw(KigPainter &p) const
 {
-    mboundrect = p.simpleBoundingRect(mloc, mtext);
-    p.drawTextFrame(mboundrect, mtext, mframe);
+    const Rect boundrect = p.simpleBoundingRect(mloc, mtext);
+    {
+        QMutexLocker locker(&boundRectMutex);
+        mboundrect = boundrect;
+    }
+    p.drawTextFrame(boundrect, mtext, mframe);
 }
 
 bool TextImp::contains(const Coordinate &p, int, const KigWidget &) const
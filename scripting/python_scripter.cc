@@ -342,6 +342,11 @@ PythonScripter::PythonScripter()
     d->mainnamespace = extract<dict>(mnh.get());
 }
 
+void PythonScripter::redirectStdout()
+{
+    PyRun_SimpleString("import sys; sys.stdout = sys.stderr;");
+}
+
 PythonScripter::~PythonScripter()
 {
     PyErr_Clear();
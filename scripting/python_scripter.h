@@ -52,4 +52,10 @@ public:
 
     CompiledPythonScript compile(const char *code);
     ObjectImp *calc(CompiledPythonScript &script, const Args &args);
+
+    /**
+     * Send what scripts print to stderr instead of stdout, which the
+     * script worker uses to talk to Kig, see ScriptWorkerPool.
+     */
+    void redirectStdout();
 };
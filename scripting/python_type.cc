@@ -5,20 +5,27 @@
 #include "python_type.h"
 
 #include "python_scripter.h"
+#include "script_worker.h"
 
 #include "../objects/bogus_imp.h"
 #include "../objects/object_imp.h"
 
 class PythonCompiledScriptImp : public BogusImp
 {
-    mutable CompiledPythonScript mscript;
+    QString msource;
+    // this is 0 if the script was compiled out of process, see
+    // ScriptWorkerPool.  It is then only compiled here if we need to
+    // fall back to running it in process.
+    mutable CompiledPythonScript *mscript;
 
 public:
     typedef BogusImp Parent;
     static const ObjectImpType *stype();
     const ObjectImpType *type() const override;
 
-    PythonCompiledScriptImp(const CompiledPythonScript &s);
+    PythonCompiledScriptImp(const QString &source, const CompiledPythonScript &s);
+    explicit PythonCompiledScriptImp(const QString &source);
+    ~PythonCompiledScriptImp();
 
     void visit(ObjectImpVisitor *vtor) const override;
     ObjectImp *copy() const override;
@@ -26,16 +33,38 @@ public:
 
     bool isCache() const override;
 
-    CompiledPythonScript &data() const
+    CompiledPythonScript &data() const;
+
+    const QString &source() const
     {
-        return mscript;
-    };
+        return msource;
+    }
 };
 
-PythonCompiledScriptImp::PythonCompiledScriptImp(const CompiledPythonScript &s)
+PythonCompiledScriptImp::PythonCompiledScriptImp(const QString &source, const CompiledPythonScript &s)
     : BogusImp()
-    , mscript(s)
+    , msource(source)
+    , mscript(new CompiledPythonScript(s))
+{
+}
+
+PythonCompiledScriptImp::PythonCompiledScriptImp(const QString &source)
+    : BogusImp()
+    , msource(source)
+    , mscript(nullptr)
+{
+}
+
+PythonCompiledScriptImp::~PythonCompiledScriptImp()
+{
+    delete mscript;
+}
+
+CompiledPythonScript &PythonCompiledScriptImp::data() const
 {
+    if (!mscript)
+        mscript = new CompiledPythonScript(PythonScripter::instance()->compile(msource.toLatin1()));
+    return *mscript;
 }
 
 const ObjectImpType *PythonCompiledScriptImp::stype()
@@ -56,7 +85,9 @@ void PythonCompiledScriptImp::visit(ObjectImpVisitor *) const
 
 ObjectImp *PythonCompiledScriptImp::copy() const
 {
-    return new PythonCompiledScriptImp(mscript);
+    if (mscript)
+        return new PythonCompiledScriptImp(msource, *mscript);
+    return new PythonCompiledScriptImp(msource);
 }
 
 bool PythonCompiledScriptImp::equals(const ObjectImp &) const
@@ -97,6 +128,11 @@ const ObjectImpType *PythonCompileType::resultId() const
     return PythonCompiledScriptImp::stype();
 }
 
+bool PythonCompileType::isThreadSafe() const
+{
+    return false;
+}
+
 ObjectImp *PythonCompileType::calc(const Args &parents, const KigDocument &) const
 {
     assert(parents.size() == 1);
@@ -106,10 +142,19 @@ ObjectImp *PythonCompileType::calc(const Args &parents, const KigDocument &) con
     const StringImp *si = static_cast<const StringImp *>(parents[0]);
     QString s = si->data();
 
+    switch (ScriptWorkerPool::instance()->compile(s)) {
+    case ScriptWorkerPool::CompileOk:
+        return new PythonCompiledScriptImp(s);
+    case ScriptWorkerPool::CompileError:
+        return new InvalidImp();
+    case ScriptWorkerPool::CompileUnavailable:
+        break;
+    }
+
     CompiledPythonScript cs = PythonScripter::instance()->compile(s.toLatin1());
 
     if (cs.valid())
-        return new PythonCompiledScriptImp(cs);
+        return new PythonCompiledScriptImp(s, cs);
     else
         return new InvalidImp();
 }
@@ -137,10 +182,15 @@ ObjectImp *PythonExecuteType::calc(const Args &parents, const KigDocument &d) co
     if (!parents[0]->inherits(PythonCompiledScriptImp::stype()))
         return new InvalidImp;
 
-    CompiledPythonScript &script = static_cast<const PythonCompiledScriptImp *>(parents[0])->data();
+    const PythonCompiledScriptImp *script = static_cast<const PythonCompiledScriptImp *>(parents[0]);
 
     Args args(parents.begin() + 1, parents.end());
-    return script.calc(args, d);
+    if (ScriptWorkerPool::instance()->enabled()) {
+        ObjectImp *ret = ScriptWorkerPool::instance()->calc(script->source(), args);
+        if (ret)
+            return ret;
+    }
+    return script->data().calc(args, d);
 }
 
 const ObjectImpType *PythonExecuteType::impRequirement(const ObjectImp *o, const Args &parents) const
@@ -156,6 +206,50 @@ const ObjectImpType *PythonExecuteType::resultId() const
     return ObjectImp::stype();
 }
 
+bool PythonExecuteType::isThreadSafe() const
+{
+    // even out of process, the worker pool is driven from one thread,
+    // which runs independent scripts in parallel itself, see calcMany()
+    return false;
+}
+
+bool PythonExecuteType::hasCalcMany() const
+{
+    return ScriptWorkerPool::instance()->enabled();
+}
+
+std::vector<ObjectImp *> PythonExecuteType::calcMany(const std::vector<Args> &parents, const KigDocument &d) const
+{
+    std::vector<ObjectImp *> ret(parents.size(), nullptr);
+    std::vector<ScriptWorkerPool::Job> jobs;
+    std::vector<uint> jobof;
+    for (uint i = 0; i < parents.size(); ++i) {
+        assert(parents[i].size() >= 1);
+        if (!parents[i][0]->inherits(PythonCompiledScriptImp::stype())) {
+            ret[i] = new InvalidImp;
+            continue;
+        }
+        ScriptWorkerPool::Job job;
+        job.code = static_cast<const PythonCompiledScriptImp *>(parents[i][0])->source();
+        job.args = Args(parents[i].begin() + 1, parents[i].end());
+        job.result = nullptr;
+        jobs.push_back(job);
+        jobof.push_back(i);
+    }
+    if (ScriptWorkerPool::instance()->enabled())
+        ScriptWorkerPool::instance()->calc(jobs);
+
+    // the jobs that could not be run out of process are done in here..
+    for (uint j = 0; j < jobs.size(); ++j) {
+        const uint i = jobof[j];
+        if (jobs[j].result)
+            ret[i] = jobs[j].result;
+        else
+            ret[i] = static_cast<const PythonCompiledScriptImp *>(parents[i][0])->data().calc(jobs[j].args, d);
+    }
+    return ret;
+}
+
 std::vector<ObjectCalcer *> PythonCompileType::sortArgs(const std::vector<ObjectCalcer *> &args) const
 {
     return args;
@@ -19,6 +19,8 @@ public:
     const ObjectImpType *impRequirement(const ObjectImp *o, const Args &parents) const override;
     bool isDefinedOnOrThrough(const ObjectImp *o, const Args &parents) const override;
     const ObjectImpType *resultId() const override;
+    // the Python interpreter can only be used from one thread at a time
+    bool isThreadSafe() const override;
 
     std::vector<ObjectCalcer *> sortArgs(const std::vector<ObjectCalcer *> &args) const override;
     Args sortArgs(const Args &args) const override;
@@ -37,6 +39,9 @@ public:
     const ObjectImpType *impRequirement(const ObjectImp *o, const Args &parents) const override;
     bool isDefinedOnOrThrough(const ObjectImp *o, const Args &parents) const override;
     const ObjectImpType *resultId() const override;
+    bool isThreadSafe() const override;
+    bool hasCalcMany() const override;
+    std::vector<ObjectImp *> calcMany(const std::vector<Args> &parents, const KigDocument &d) const override;
 
     std::vector<ObjectCalcer *> sortArgs(const std::vector<ObjectCalcer *> &args) const override;
     Args sortArgs(const Args &args) const override;
@@ -7,6 +7,7 @@
 #include "newscriptwizard.h"
 #include "python_scripter.h"
 #include "python_type.h"
+#include "script_worker.h"
 
 #include "../kig/kig_commands.h"
 #include "../kig/kig_part.h"
@@ -20,6 +21,21 @@
 
 #include <KMessageBox>
 
+/**
+ * whether the last script run reported an error, and if so, its
+ * traceback.  The script may have run in process or in a worker.
+ */
+static bool scriptErrorOccurred(QByteArray &errtrace)
+{
+    if (ScriptWorkerPool::instance()->errorOccurred()) {
+        errtrace = ScriptWorkerPool::instance()->lastErrorExceptionTraceback().c_str();
+        return true;
+    }
+    PythonScripter *inst = PythonScripter::instance();
+    errtrace = inst->lastErrorExceptionTraceback().c_str();
+    return inst->errorOccurred();
+}
+
 void ScriptModeBase::dragRect(const QPoint &p, KigWidget &w)
 {
     if (mwawd != SelectingArgs)
@@ -174,9 +190,8 @@ bool ScriptCreationMode::queryFinish()
     reto->calc(mdoc.document());
 
     if (reto->imp()->inherits(InvalidImp::stype())) {
-        PythonScripter *inst = PythonScripter::instance();
-        QByteArray errtrace = inst->lastErrorExceptionTraceback().c_str();
-        if (inst->errorOccurred()) {
+        QByteArray errtrace;
+        if (scriptErrorOccurred(errtrace)) {
             KMessageBox::detailedSorry(mwizard,
                                        i18n("The Python interpreter caught an error during the execution of your "
                                             "script. Please fix the script and click the Finish button again."),
@@ -308,9 +323,8 @@ bool ScriptEditMode::queryFinish()
     mon.finish(comm);
 
     if (mexecuted->imp()->inherits(InvalidImp::stype())) {
-        PythonScripter *inst = PythonScripter::instance();
-        QByteArray errtrace = inst->lastErrorExceptionTraceback().c_str();
-        if (inst->errorOccurred()) {
+        QByteArray errtrace;
+        if (scriptErrorOccurred(errtrace)) {
             KMessageBox::detailedSorry(mwizard,
                                        i18n("The Python interpreter caught an error during the execution of your "
                                             "script. Please fix the script."),
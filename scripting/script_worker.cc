@@ -0,0 +1,480 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "script_worker.h"
+
+#include "python_scripter.h"
+
+#include "../kig/kig_document.h"
+#include "../objects/bogus_imp.h"
+#include "../objects/object_imp.h"
+#include "../objects/object_imp_factory.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QThread>
+#include <QtEndian>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <kigpart_export.h>
+
+#include <algorithm>
+#include <map>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+ * The pipe protocol.  Every message is a big endian quint32 with the
+ * payload size, followed by the payload, which is written with a
+ * QDataStream:
+ *
+ * request: quint8 kind, QString code, and for CalcRequest a quint32
+ *          argument count followed by the serialized arguments.
+ * reply:   quint8 status, then for ReplyOk to a CalcRequest the
+ *          serialized result, and for ReplyScriptError the exception
+ *          traceback as a QString.
+ */
+enum RequestKind { CompileRequest = 0, CalcRequest = 1 };
+enum ReplyStatus { ReplyOk = 0, ReplyScriptError = 1, ReplyUnsupported = 2 };
+
+static const int protocolVersion = QDataStream::Qt_5_15;
+
+static QByteArray frame(const QByteArray &payload)
+{
+    QByteArray ret(4, 0);
+    qToBigEndian<quint32>(payload.size(), reinterpret_cast<uchar *>(ret.data()));
+    ret.append(payload);
+    return ret;
+}
+
+static bool takeFrame(QByteArray &buffer, QByteArray &payload)
+{
+    if (buffer.size() < 4)
+        return false;
+    const quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(buffer.constData()));
+    if (static_cast<quint32>(buffer.size()) - 4 < size)
+        return false;
+    payload = buffer.mid(4, size);
+    buffer.remove(0, 4 + size);
+    return true;
+}
+
+/*
+ * the worker side
+ */
+
+static bool readFully(QFile &in, char *data, qint64 size)
+{
+    while (size > 0) {
+        qint64 r = in.read(data, size);
+        if (r <= 0)
+            return false;
+        data += r;
+        size -= r;
+    }
+    return true;
+}
+
+static bool readRequest(QFile &in, QByteArray &payload)
+{
+    uchar sizebuf[4];
+    if (!readFully(in, reinterpret_cast<char *>(sizebuf), 4))
+        return false;
+    payload.resize(qFromBigEndian<quint32>(sizebuf));
+    return readFully(in, payload.data(), payload.size());
+}
+
+static QByteArray scriptErrorReply()
+{
+    QByteArray reply;
+    QDataStream out(&reply, QIODevice::WriteOnly);
+    out.setVersion(protocolVersion);
+    out << static_cast<quint8>(ReplyScriptError) << QString::fromStdString(PythonScripter::instance()->lastErrorExceptionTraceback());
+    return reply;
+}
+
+static QByteArray handleRequest(const QByteArray &request, std::map<QString, CompiledPythonScript> &scripts, const KigDocument &doc)
+{
+    QDataStream in(request);
+    in.setVersion(protocolVersion);
+    quint8 kind = 0;
+    QString code;
+    in >> kind >> code;
+
+    std::map<QString, CompiledPythonScript>::iterator script = scripts.find(code);
+    if (script == scripts.end()) {
+        script = scripts.insert(std::make_pair(code, PythonScripter::instance()->compile(code.toLatin1()))).first;
+        if (!script->second.valid()) {
+            QByteArray reply = scriptErrorReply();
+            // don't cache failures, the next request may come from a
+            // fixed version of the script that happens to be identical..
+            scripts.erase(script);
+            return reply;
+        }
+    }
+
+    QByteArray reply;
+    QDataStream out(&reply, QIODevice::WriteOnly);
+    out.setVersion(protocolVersion);
+
+    if (kind == CompileRequest) {
+        out << static_cast<quint8>(ReplyOk);
+        return reply;
+    }
+
+    quint32 nargs = 0;
+    in >> nargs;
+    Args args;
+    bool ok = in.status() == QDataStream::Ok;
+    for (quint32 i = 0; ok && i < nargs; ++i) {
+        ObjectImp *imp = ObjectImpFactory::instance()->deserialize(in);
+        if (imp)
+            args.push_back(imp);
+        else
+            ok = false;
+    }
+
+    if (!ok) {
+        out << static_cast<quint8>(ReplyUnsupported);
+    } else {
+        ObjectImp *ret = script->second.calc(args, doc);
+        if (PythonScripter::instance()->errorOccurred())
+            reply = scriptErrorReply();
+        else if (ObjectImpFactory::instance()->canSerialize(*ret)) {
+            out << static_cast<quint8>(ReplyOk);
+            ObjectImpFactory::instance()->serialize(*ret, out);
+        } else
+            out << static_cast<quint8>(ReplyUnsupported);
+        delete ret;
+    }
+
+    delete_all(args.begin(), args.end());
+    return reply;
+}
+
+/**
+ * The main loop of a worker process.  This is called by the kig
+ * executable when started with --script-worker.
+ */
+extern "C" KIGPART_EXPORT int runScriptWorker()
+{
+    // the scripts may print to stdout, which would corrupt the protocol,
+    // so we keep a private copy of stdout for the replies, and send
+    // everything else to stderr.  Python may not share our C runtime,
+    // so we tell it too..
+#ifdef Q_OS_WIN
+    ::_setmode(0, _O_BINARY);
+    const int protocolfd = ::_dup(1);
+    ::_setmode(protocolfd, _O_BINARY);
+    ::_dup2(2, 1);
+#else
+    const int protocolfd = ::dup(1);
+    ::dup2(2, 1);
+#endif
+    PythonScripter::instance()->redirectStdout();
+
+    QFile in;
+    QFile out;
+    if (!in.open(0, QIODevice::ReadOnly | QIODevice::Unbuffered) || !out.open(protocolfd, QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        qCritical() << "script worker: could not open its pipes";
+        return -1;
+    }
+
+    KigDocument doc;
+    std::map<QString, CompiledPythonScript> scripts;
+    QByteArray request;
+    while (readRequest(in, request)) {
+        if (out.write(frame(handleRequest(request, scripts, doc))) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * the pool side
+ */
+
+struct ScriptWorker {
+    QProcess *process;
+    QByteArray buffer;
+    ScriptWorkerPool::Job *job;
+    QDeadlineTimer deadline;
+};
+
+class ScriptWorkerPool::Private
+{
+public:
+    bool enabled;
+    int maxworkers;
+    int timeout;
+    QString program;
+    std::vector<ScriptWorker> workers;
+
+    bool erroroccurred;
+    std::string lastexceptiontraceback;
+
+    bool startWorker();
+    void stopWorker(std::vector<ScriptWorker>::size_type i);
+    bool send(ScriptWorker &w, const QByteArray &request);
+    bool exchange(const QByteArray &request, QByteArray &reply);
+    ObjectImp *parseCalcReply(const QByteArray &reply);
+};
+
+bool ScriptWorkerPool::Private::startWorker()
+{
+    ScriptWorker w;
+    w.process = new QProcess;
+    w.job = nullptr;
+    w.process->setProgram(program);
+    w.process->setArguments(QStringList() << QStringLiteral("--script-worker"));
+    w.process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    w.process->start();
+    if (!w.process->waitForStarted()) {
+        qWarning() << "Could not start a Python script worker" << program << ", running scripts in process instead:" << w.process->errorString();
+        delete w.process;
+        enabled = false;
+        return false;
+    }
+    workers.push_back(w);
+    return true;
+}
+
+void ScriptWorkerPool::Private::stopWorker(std::vector<ScriptWorker>::size_type i)
+{
+    QProcess *p = workers[i].process;
+    p->kill();
+    p->waitForFinished(1000);
+    delete p;
+    workers.erase(workers.begin() + i);
+}
+
+bool ScriptWorkerPool::Private::send(ScriptWorker &w, const QByteArray &request)
+{
+    w.buffer.clear();
+    w.deadline = QDeadlineTimer(timeout);
+    return w.process->write(frame(request)) >= 0;
+}
+
+/**
+ * synchronous request/reply with a single worker, for compile() and
+ * the single calc().  Returns false if the worker did not answer in
+ * time or died, and that worker is then replaced.
+ */
+bool ScriptWorkerPool::Private::exchange(const QByteArray &request, QByteArray &reply)
+{
+    if (workers.empty() && !startWorker())
+        return false;
+    ScriptWorker &w = workers.front();
+    if (!send(w, request)) {
+        stopWorker(0);
+        return false;
+    }
+    while (!takeFrame(w.buffer, reply)) {
+        if (w.deadline.hasExpired() || !w.process->waitForReadyRead(static_cast<int>(w.deadline.remainingTime()))) {
+            stopWorker(0);
+            return false;
+        }
+        w.buffer.append(w.process->readAllStandardOutput());
+    }
+    return true;
+}
+
+ObjectImp *ScriptWorkerPool::Private::parseCalcReply(const QByteArray &reply)
+{
+    QDataStream in(reply);
+    in.setVersion(protocolVersion);
+    quint8 status = ReplyUnsupported;
+    in >> status;
+    if (status == ReplyOk) {
+        ObjectImp *ret = ObjectImpFactory::instance()->deserialize(in);
+        return ret ? ret : new InvalidImp;
+    } else if (status == ReplyScriptError) {
+        QString traceback;
+        in >> traceback;
+        erroroccurred = true;
+        lastexceptiontraceback = traceback.toStdString();
+        return new InvalidImp;
+    }
+    // the worker calculated something we cannot transfer
+    return nullptr;
+}
+
+static QString workerProgram()
+{
+    if (QCoreApplication::applicationName() == QLatin1String("kig"))
+        return QCoreApplication::applicationFilePath();
+    // we are embedded in another application..
+    return QStandardPaths::findExecutable(QStringLiteral("kig"));
+}
+
+ScriptWorkerPool::ScriptWorkerPool()
+    : d(new Private)
+{
+    KConfigGroup cg = KSharedConfig::openConfig()->group("Python Scripting");
+    d->enabled = cg.readEntry("OutOfProcess", false);
+    d->maxworkers = qMax(1, cg.readEntry("Workers", QThread::idealThreadCount()));
+    d->timeout = cg.readEntry("Timeout", 5000);
+    d->program = workerProgram();
+    d->erroroccurred = false;
+    if (d->program.isEmpty())
+        d->enabled = false;
+}
+
+ScriptWorkerPool::~ScriptWorkerPool()
+{
+    while (!d->workers.empty())
+        d->stopWorker(d->workers.size() - 1);
+    delete d;
+}
+
+ScriptWorkerPool *ScriptWorkerPool::instance()
+{
+    static ScriptWorkerPool t;
+    return &t;
+}
+
+bool ScriptWorkerPool::enabled() const
+{
+    return d->enabled;
+}
+
+bool ScriptWorkerPool::errorOccurred() const
+{
+    return d->erroroccurred;
+}
+
+std::string ScriptWorkerPool::lastErrorExceptionTraceback() const
+{
+    return d->lastexceptiontraceback;
+}
+
+static bool encodeRequest(RequestKind kind, const QString &code, const Args &args, QByteArray &request)
+{
+    QDataStream out(&request, QIODevice::WriteOnly);
+    out.setVersion(protocolVersion);
+    out << static_cast<quint8>(kind) << code;
+    if (kind == CompileRequest)
+        return true;
+    out << static_cast<quint32>(args.size());
+    for (Args::const_iterator i = args.begin(); i != args.end(); ++i)
+        if (!ObjectImpFactory::instance()->serialize(**i, out))
+            return false;
+    return true;
+}
+
+ScriptWorkerPool::CompileResult ScriptWorkerPool::compile(const QString &code)
+{
+    d->erroroccurred = false;
+    d->lastexceptiontraceback.clear();
+    if (!d->enabled)
+        return CompileUnavailable;
+
+    QByteArray request;
+    encodeRequest(CompileRequest, code, Args(), request);
+    QByteArray reply;
+    if (!d->exchange(request, reply))
+        return d->enabled ? CompileError : CompileUnavailable;
+
+    QDataStream in(reply);
+    in.setVersion(protocolVersion);
+    quint8 status = ReplyScriptError;
+    in >> status;
+    if (status == ReplyOk)
+        return CompileOk;
+    QString traceback;
+    in >> traceback;
+    d->erroroccurred = true;
+    d->lastexceptiontraceback = traceback.toStdString();
+    return CompileError;
+}
+
+ObjectImp *ScriptWorkerPool::calc(const QString &code, const Args &args)
+{
+    d->erroroccurred = false;
+    d->lastexceptiontraceback.clear();
+    if (!d->enabled)
+        return nullptr;
+
+    QByteArray request;
+    if (!encodeRequest(CalcRequest, code, args, request))
+        return nullptr;
+    QByteArray reply;
+    if (!d->exchange(request, reply))
+        return d->enabled ? new InvalidImp : nullptr;
+    return d->parseCalcReply(reply);
+}
+
+void ScriptWorkerPool::calc(std::vector<Job> &jobs)
+{
+    d->erroroccurred = false;
+    d->lastexceptiontraceback.clear();
+
+    std::vector<std::pair<Job *, QByteArray>> queue;
+    for (std::vector<Job>::iterator i = jobs.begin(); i != jobs.end(); ++i) {
+        i->result = nullptr;
+        QByteArray request;
+        if (d->enabled && encodeRequest(CalcRequest, i->code, i->args, request))
+            queue.push_back(std::make_pair(&*i, request));
+    }
+    // we take jobs from the back..
+    std::reverse(queue.begin(), queue.end());
+
+    for (;;) {
+        // hand out work to idle workers, starting new ones as needed..
+        for (int i = 0; !queue.empty(); ++i) {
+            if (i == static_cast<int>(d->workers.size()) && (i >= d->maxworkers || !d->enabled || !d->startWorker()))
+                break;
+            ScriptWorker &w = d->workers[i];
+            if (w.job)
+                continue;
+            if (d->send(w, queue.back().second))
+                w.job = queue.back().first;
+            else {
+                queue.back().first->result = new InvalidImp;
+                d->stopWorker(i--);
+            }
+            queue.pop_back();
+        }
+
+        bool busy = false;
+        for (std::vector<ScriptWorker>::const_iterator i = d->workers.begin(); i != d->workers.end(); ++i)
+            busy |= i->job != nullptr;
+        if (!busy)
+            break;
+
+        // and collect the results.  With several busy workers, we can't
+        // block on one of them, so we poll them in short slices..
+        for (std::vector<ScriptWorker>::size_type i = 0; i < d->workers.size();) {
+            ScriptWorker &w = d->workers[i];
+            if (!w.job) {
+                ++i;
+                continue;
+            }
+            w.process->waitForReadyRead(static_cast<int>(qMin<qint64>(10, w.deadline.remainingTime())));
+            w.buffer.append(w.process->readAllStandardOutput());
+            QByteArray reply;
+            if (takeFrame(w.buffer, reply)) {
+                w.job->result = d->parseCalcReply(reply);
+                w.job = nullptr;
+                ++i;
+            } else if (w.deadline.hasExpired() || w.process->state() == QProcess::NotRunning) {
+                w.job->result = new InvalidImp;
+                d->stopWorker(i);
+            } else
+                ++i;
+        }
+    }
+}
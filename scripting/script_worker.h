@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "../objects/common.h"
+
+#include <QString>
+
+#include <string>
+#include <vector>
+
+/**
+ * ScriptWorkerPool is an optional execution backend for Python script
+ * objects.  Instead of running scripts in the interpreter embedded in
+ * the Kig process ( see PythonScripter ), it sends them to a pool of
+ * local worker processes ( "kig --script-worker" ) over a pipe.  The
+ * ObjectImp's involved are passed using the binary form of
+ * ObjectImpFactory::serialize.
+ *
+ * This buys us three things: a script that loops or takes too long is
+ * abandoned after a deadline, and its object simply becomes invalid;
+ * a script that crashes the interpreter only takes its worker down;
+ * and independent script objects are calculated in parallel, with
+ * calc( std::vector<Job>& ), see PythonExecuteType::calcMany().
+ *
+ * The pool is configured in the "Python Scripting" group of kigrc:
+ * "OutOfProcess" ( default false ) enables it, "Workers" sets the
+ * maximum number of worker processes ( default: the number of CPU
+ * cores ) and "Timeout" is the per call deadline in milliseconds
+ * ( default 5000 ).
+ */
+class ScriptWorkerPool
+{
+    class Private;
+    Private *d;
+    ScriptWorkerPool();
+    ~ScriptWorkerPool();
+
+public:
+    static ScriptWorkerPool *instance();
+
+    /**
+     * Whether script objects should be calculated out of process.  This
+     * becomes false if the worker processes cannot be started.
+     */
+    bool enabled() const;
+
+    /**
+     * One script evaluation, for calc( std::vector<Job>& ).
+     */
+    struct Job {
+        QString code;
+        Args args;
+        /**
+         * set by calc(): the result, or 0 if the job could not be run
+         * out of process, see calc( const QString&, const Args& ).
+         */
+        ObjectImp *result;
+    };
+
+    enum CompileResult { CompileOk, CompileError, CompileUnavailable };
+    /**
+     * Checks in a worker whether \p code compiles and defines a calc
+     * function.  CompileUnavailable means that no worker could be
+     * started, and the caller should compile the script in process.
+     */
+    CompileResult compile(const QString &code);
+
+    /**
+     * Runs the calc function of \p code on \p args in a worker.
+     * Returns an InvalidImp if the script fails, exceeds the deadline
+     * or crashes its worker.  Returns 0 if the call cannot be done out
+     * of process at all ( e.g. because one of the args cannot be
+     * serialized ), in which case the caller should fall back to
+     * PythonScripter.
+     */
+    ObjectImp *calc(const QString &code, const Args &args);
+    /**
+     * Runs all \p jobs, spreading them over the worker processes.  The
+     * jobs must be independent of each other.
+     */
+    void calc(std::vector<Job> &jobs);
+
+    /**
+     * The error reported by the last failing script, with the same
+     * semantics as the equivalent functions in PythonScripter.
+     */
+    bool errorOccurred() const;
+    std::string lastErrorExceptionTraceback() const;
+};
@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../kig/kig_document.h"
+#include "../misc/conic-common.h"
+#include "../misc/coordinate.h"
+#include "../misc/curve_sampler.h"
+#include "../misc/rect.h"
+#include "../objects/circle_imp.h"
+#include "../objects/conic_imp.h"
+
+#include <QObject>
+#include <QTest>
+
+#include <cmath>
+#include <vector>
+
+typedef std::vector<std::vector<Coordinate>> Polylines;
+
+class CurveSamplerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSimplifyStraight();
+    void testSimplifyKeepsCorners();
+    void testCircle();
+    void testHyperbola();
+    void testPointLimit();
+    void testClip();
+};
+
+void CurveSamplerTest::testSimplifyStraight()
+{
+    std::vector<Coordinate> pts;
+    for (int i = 0; i <= 10; ++i)
+        pts.push_back(Coordinate(i, 2 * i));
+    simplifyPolyline(pts, 1e-6);
+    QCOMPARE(pts.size(), std::size_t(2));
+    QVERIFY(pts.front() == Coordinate(0, 0));
+    QVERIFY(pts.back() == Coordinate(10, 20));
+}
+
+void CurveSamplerTest::testSimplifyKeepsCorners()
+{
+    std::vector<Coordinate> pts;
+    pts.push_back(Coordinate(0, 0));
+    pts.push_back(Coordinate(1, 0.01));
+    pts.push_back(Coordinate(2, 0));
+    pts.push_back(Coordinate(2, 2));
+    simplifyPolyline(pts, 0.1);
+    // the small bump goes, the corner stays..
+    QCOMPARE(pts.size(), std::size_t(3));
+    QVERIFY(pts[1] == Coordinate(2, 0));
+
+    // no point may end up farther than the tolerance from the result
+    pts.clear();
+    pts.push_back(Coordinate(0, 0));
+    pts.push_back(Coordinate(1, 0.5));
+    pts.push_back(Coordinate(2, 0));
+    simplifyPolyline(pts, 0.1);
+    QCOMPARE(pts.size(), std::size_t(3));
+}
+
+void CurveSamplerTest::testCircle()
+{
+    KigDocument doc;
+    const CircleImp circle(Coordinate(0, 0), 1);
+    const double tolerance = 1e-3;
+    const Polylines pieces = sampleCurve(&circle, doc, Rect(-2, -2, 4, 4), tolerance, 10000);
+
+    // a circle has no jumps, so it is one closed polyline..
+    QCOMPARE(pieces.size(), std::size_t(1));
+    const std::vector<Coordinate> &pts = pieces.front();
+    QVERIFY(pts.size() > 8);
+    QVERIFY((pts.front() - pts.back()).length() < 1e-9);
+
+    // the points lie on the circle, and the segments stay within one
+    // and a half tolerance of it ( see sampleCurve() )
+    for (uint i = 0; i < pts.size(); ++i) {
+        QVERIFY(std::fabs(pts[i].length() - 1) < 1e-9);
+        if (i > 0)
+            QVERIFY(1 - ((pts[i - 1] + pts[i]) / 2).length() <= 1.5 * tolerance);
+    }
+}
+
+void CurveSamplerTest::testHyperbola()
+{
+    // x^2 - y^2 = 1, with its two branches on either side of the y axis
+    KigDocument doc;
+    const ConicImpCart hyperbola(ConicCartesianData(1, -1, 0, 0, 0, -1));
+    const Polylines pieces = sampleCurve(&hyperbola, doc, Rect(-5, -5, 10, 10), 1e-3, 10000);
+
+    QVERIFY(pieces.size() >= 2);
+    bool left = false;
+    bool right = false;
+    for (Polylines::const_iterator i = pieces.begin(); i != pieces.end(); ++i) {
+        QVERIFY(i->size() > 1);
+        for (uint j = 0; j < i->size(); ++j) {
+            const Coordinate &p = (*i)[j];
+            QVERIFY(p.valid());
+            QVERIFY(std::fabs(p.x * p.x - p.y * p.y - 1) <= 1e-6 * (1 + p.x * p.x + p.y * p.y));
+            left |= p.x < 0;
+            right |= p.x > 0;
+            // the jump between the branches must not be drawn
+            if (j > 0)
+                QVERIFY((p.x < 0) == ((*i)[j - 1].x < 0));
+        }
+    }
+    QVERIFY(left);
+    QVERIFY(right);
+}
+
+void CurveSamplerTest::testPointLimit()
+{
+    // with too few points for the tolerance, the curve is finished
+    // coarsely instead of cut short..
+    KigDocument doc;
+    const CircleImp circle(Coordinate(0, 0), 1);
+    const Polylines pieces = sampleCurve(&circle, doc, Rect(-2, -2, 4, 4), 1e-6, 20);
+
+    QCOMPARE(pieces.size(), std::size_t(1));
+    const std::vector<Coordinate> &pts = pieces.front();
+    QVERIFY((pts.front() - circle.getPoint(0., doc)).length() < 1e-9);
+    QVERIFY((pts.back() - circle.getPoint(1., doc)).length() < 1e-9);
+}
+
+void CurveSamplerTest::testClip()
+{
+    // leaves the window through the right, goes around it and comes
+    // back in at the top..
+    std::vector<Coordinate> pts;
+    pts.push_back(Coordinate(0, 0));
+    pts.push_back(Coordinate(4, 0));
+    pts.push_back(Coordinate(4, 4));
+    pts.push_back(Coordinate(0, 4));
+    pts.push_back(Coordinate(0, 0));
+    const Polylines pieces = clipPolylines(Polylines(1, pts), Rect(-1, -1, 3, 3));
+
+    QCOMPARE(pieces.size(), std::size_t(2));
+    QCOMPARE(pieces[0].size(), std::size_t(2));
+    QVERIFY(pieces[0][0] == Coordinate(0, 0));
+    QVERIFY(pieces[0][1] == Coordinate(2, 0));
+    QCOMPARE(pieces[1].size(), std::size_t(2));
+    QVERIFY(pieces[1][0] == Coordinate(0, 2));
+    QVERIFY(pieces[1][1] == Coordinate(0, 0));
+
+    // nothing is left of what is entirely outside
+    pts.clear();
+    pts.push_back(Coordinate(5, 5));
+    pts.push_back(Coordinate(6, 5));
+    QVERIFY(clipPolylines(Polylines(1, pts), Rect(-1, -1, 3, 3)).empty());
+}
+
+QTEST_GUILESS_MAIN(CurveSamplerTest)
+
+#include "curvesamplertest.moc"
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../misc/coordinate.h"
+#include "../objects/bezier_imp.h"
+#include "../objects/bogus_imp.h"
+#include "../objects/circle_imp.h"
+#include "../objects/object_imp.h"
+#include "../objects/object_imp_factory.h"
+#include "../objects/point_imp.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QObject>
+#include <QTest>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+class ImpCodecTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testPlainData();
+    void testBezier();
+    void testRationalBezier_data();
+    void testRationalBezier();
+    void testCorrupt();
+};
+
+// writes \p imp in the binary form, and reads it back
+static ObjectImp *roundTrip(const ObjectImp &imp)
+{
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        if (!ObjectImpFactory::instance()->serialize(imp, out))
+            return nullptr;
+    }
+    QDataStream in(data);
+    return ObjectImpFactory::instance()->deserialize(in);
+}
+
+void ImpCodecTest::testPlainData()
+{
+    // values that don't survive the six digits of the XML form..
+    const PointImp point(Coordinate(1. / 3, -2e-12));
+    std::unique_ptr<ObjectImp> p(roundTrip(point));
+    QVERIFY(p);
+    QVERIFY(p->type() == PointImp::stype());
+    QVERIFY(p->equals(point));
+
+    const DoubleImp d(M_PI);
+    std::unique_ptr<ObjectImp> q(roundTrip(d));
+    QVERIFY(q);
+    QVERIFY(q->type() == DoubleImp::stype());
+    QCOMPARE(static_cast<const DoubleImp &>(*q).data(), M_PI);
+
+    const CircleImp circle(Coordinate(0.1, 0.2), 1. / 7);
+    std::unique_ptr<ObjectImp> c(roundTrip(circle));
+    QVERIFY(c);
+    QVERIFY(c->type() == CircleImp::stype());
+    QVERIFY(c->equals(circle));
+}
+
+void ImpCodecTest::testBezier()
+{
+    std::vector<Coordinate> pts;
+    pts.push_back(Coordinate(0, 0));
+    pts.push_back(Coordinate(1. / 3, 2));
+    pts.push_back(Coordinate(3, -1));
+    const BezierImp bezier(pts);
+    std::unique_ptr<ObjectImp> b(roundTrip(bezier));
+    QVERIFY(b);
+    QVERIFY(b->type() == bezier.type());
+    QVERIFY(static_cast<const BezierImp &>(*b).points() == pts);
+}
+
+void ImpCodecTest::testRationalBezier_data()
+{
+    QTest::addColumn<int>("npoints");
+    // a quadratic, a cubic and a general rational Bézier curve, which
+    // all have their own ObjectImpType
+    QTest::newRow("quadratic") << 3;
+    QTest::newRow("cubic") << 4;
+    QTest::newRow("general") << 6;
+}
+
+void ImpCodecTest::testRationalBezier()
+{
+    QFETCH(int, npoints);
+    std::vector<Coordinate> pts;
+    std::vector<double> weights;
+    for (int i = 0; i < npoints; ++i) {
+        pts.push_back(Coordinate(i, (i % 2) / 3.));
+        weights.push_back(1. + i / 7.);
+    }
+    const RationalBezierImp bezier(pts, weights);
+    std::unique_ptr<ObjectImp> b(roundTrip(bezier));
+    QVERIFY(b);
+    // the quadratic and cubic types inherit from BezierImp::stype(), so
+    // they must not come back as plain Bézier curves..
+    QVERIFY(b->type() == bezier.type());
+    const RationalBezierImp &r = static_cast<const RationalBezierImp &>(*b);
+    QVERIFY(r.points() == pts);
+    QVERIFY(r.weights() == weights);
+}
+
+void ImpCodecTest::testCorrupt()
+{
+    std::vector<Coordinate> pts(4, Coordinate(1, 2));
+    const RationalBezierImp bezier(pts, std::vector<double>(4, 1.));
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        QVERIFY(ObjectImpFactory::instance()->serialize(bezier, out));
+    }
+    // cut off the weights..
+    data.chop(sizeof(double));
+    QDataStream in(data);
+    std::unique_ptr<ObjectImp> b(ObjectImpFactory::instance()->deserialize(in));
+    QVERIFY(!b);
+}
+
+QTEST_GUILESS_MAIN(ImpCodecTest)
+
+#include "impcodectest.moc"
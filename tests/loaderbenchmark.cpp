@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../filters/native-filter.h"
+#include "../kig/kig_document.h"
+#include "../misc/coordinate.h"
+#include "../objects/line_type.h"
+#include "../objects/object_calcer.h"
+#include "../objects/object_factory.h"
+#include "../objects/object_holder.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+class LoaderBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testRoundTrip();
+    void benchmarkSave07();
+    void benchmarkLoad07();
+
+private:
+    QTemporaryDir mdir;
+    std::unique_ptr<KigDocument> mdoc;
+};
+
+// the number of points in the benchmark document, which has a segment
+// between every two consecutive points as well
+static const int numberOfPoints = 5000;
+
+// a document with a chain of \p n points and the segments between them
+static KigDocument *buildDocument(int n)
+{
+    KigDocument *doc = new KigDocument;
+    std::vector<ObjectHolder *> os;
+    ObjectTypeCalcer *prev = nullptr;
+    for (int i = 0; i < n; ++i) {
+        ObjectTypeCalcer *p = ObjectFactory::instance()->fixedPointCalcer(Coordinate(std::cos(i / 10.), i / 100.));
+        p->calc(*doc);
+        os.push_back(new ObjectHolder(p));
+        if (prev) {
+            std::vector<ObjectCalcer *> args;
+            args.push_back(prev);
+            args.push_back(p);
+            ObjectTypeCalcer *s = new ObjectTypeCalcer(SegmentABType::instance(), args);
+            s->calc(*doc);
+            os.push_back(new ObjectHolder(s));
+        }
+        prev = p;
+    }
+    doc->addObjects(os);
+    return doc;
+}
+
+void LoaderBenchmark::initTestCase()
+{
+    QVERIFY(mdir.isValid());
+    mdoc.reset(buildDocument(numberOfPoints));
+}
+
+void LoaderBenchmark::testRoundTrip()
+{
+    const QString file = mdir.filePath(QStringLiteral("roundtrip.kig"));
+    QVERIFY(KigFilterNative::instance()->save(*mdoc, file));
+    std::unique_ptr<KigDocument> loaded(KigFilterNative::instance()->load(file));
+    QVERIFY(loaded);
+    QCOMPARE(loaded->objects().size(), mdoc->objects().size());
+
+    // and what we load saves the same way..
+    const QString again = mdir.filePath(QStringLiteral("again.kig"));
+    QVERIFY(KigFilterNative::instance()->save(*loaded, again));
+    std::unique_ptr<KigDocument> reloaded(KigFilterNative::instance()->load(again));
+    QVERIFY(reloaded);
+    QCOMPARE(reloaded->objects().size(), mdoc->objects().size());
+}
+
+void LoaderBenchmark::benchmarkSave07()
+{
+    const QString file = mdir.filePath(QStringLiteral("save.kig"));
+    QBENCHMARK {
+        QVERIFY(KigFilterNative::instance()->save(*mdoc, file));
+    }
+}
+
+void LoaderBenchmark::benchmarkLoad07()
+{
+    const QString file = mdir.filePath(QStringLiteral("load.kig"));
+    QVERIFY(KigFilterNative::instance()->save(*mdoc, file));
+    QBENCHMARK {
+        std::unique_ptr<KigDocument> loaded(KigFilterNative::instance()->load(file));
+        QVERIFY(loaded);
+    }
+}
+
+QTEST_GUILESS_MAIN(LoaderBenchmark)
+
+#include "loaderbenchmark.moc"
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2026 The Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../misc/coordinate.h"
+#include "../misc/rect.h"
+
+#include <QObject>
+#include <QTest>
+
+#include <vector>
+
+class RectTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testBoundingRectEmpty();
+    void testBoundingRectSinglePoint();
+    void testBoundingRect();
+};
+
+void RectTest::testBoundingRectEmpty()
+{
+    Rect r = Rect::boundingRect(std::vector<Coordinate>());
+    QVERIFY(!r.valid());
+}
+
+void RectTest::testBoundingRectSinglePoint()
+{
+    Rect r = Rect::boundingRect(std::vector<Coordinate>(1, Coordinate(2, -3)));
+    QVERIFY(r.valid());
+    QCOMPARE(r.left(), 2.);
+    QCOMPARE(r.right(), 2.);
+    QCOMPARE(r.bottom(), -3.);
+    QCOMPARE(r.top(), -3.);
+}
+
+void RectTest::testBoundingRect()
+{
+    std::vector<Coordinate> pts;
+    pts.push_back(Coordinate(1, 1));
+    pts.push_back(Coordinate(-2, 4));
+    pts.push_back(Coordinate(3, -5));
+    pts.push_back(Coordinate(0, 0));
+    Rect r = Rect::boundingRect(pts);
+    QVERIFY(r.valid());
+    QCOMPARE(r.left(), -2.);
+    QCOMPARE(r.right(), 3.);
+    QCOMPARE(r.bottom(), -5.);
+    QCOMPARE(r.top(), 4.);
+    for (std::vector<Coordinate>::const_iterator i = pts.begin(); i != pts.end(); ++i)
+        QVERIFY(r.contains(*i));
+}
+
+QTEST_GUILESS_MAIN(RectTest)
+
+#include "recttest.moc"